@@ -0,0 +1,210 @@
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+/*
+    Implementation of region (arena) allocator for memory of one scope, for example one request: many blocks are
+    allocated by bumping pointer and all of them are freed together. There is no free of single block.
+
+    Arena is chain of blocks taken from fsa (default pool or any Fsa_pool), descriptor of arena is kept at the begin of
+    the first block. Allocation is add and compare in current block, next block of chain is taken only when current
+    one is full. Mark keeps position in chain, restore to mark frees everything allocated after it. Reset and restore
+    do not give blocks back to fsa, they are reused by next allocations, so both of them take constant time.
+    Blocks after current one are given back by arena_trim.
+
+    Arena is not thread safe, it should be owned by one thread (or one request).
+
+    author: Kamil Kielbasa
+    email: dusergithub@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <fixed_size_allocator.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* alignment of each allocation, it has to be power of two, could be passed in compile time by -D option */
+#ifndef ARENA_ALIGNMENT
+#define ARENA_ALIGNMENT 16
+#endif
+
+/* default size of block taken from fsa, bigger requests get their own block */
+#define ARENA_DEFAULT_BLOCK_SIZE (16 * SIZE_OF_CHUNK)
+
+typedef struct Arena_block Arena_block;
+
+/*
+    Descriptor of arena. Fields are public only for inlined arena_alloc, they should not be touched by caller.
+*/
+struct Arena
+{
+    uint8_t* top; /* next allocation */
+    uint8_t* end; /* end of current block */
+
+    Arena_block* block_p; /* current block */
+    Arena_block* first_block_p; /* block which keeps descriptor */
+
+    Fsa_pool* pool_p; /* NULL for default fsa pool */
+    size_t block_size;
+};
+
+typedef struct Arena Arena;
+
+/* position in arena, see arena_get_mark */
+struct Arena_mark
+{
+    Arena_block* block_p;
+    uint8_t* top;
+};
+
+typedef struct Arena_mark Arena_mark;
+
+/*
+    Statistics of arena. They are counted by walk through chain of blocks, arena_alloc does not update anything.
+*/
+struct Arena_statistics
+{
+    size_t nr_of_blocks;
+    size_t size_of_blocks; /* bytes taken from fsa */
+
+    size_t bytes_in_use; /* bytes allocated since reset with padding and ends of blocks which were left */
+};
+
+typedef struct Arena_statistics Arena_statistics;
+
+/*
+    This function create arena. The first block is taken at once and it keeps descriptor of arena.
+
+    PARAMS:
+    @IN pool_p - fsa pool for blocks, NULL for default pool (fsa_init has to be called before).
+    @IN block_size - size of block in bytes, 0 for ARENA_DEFAULT_BLOCK_SIZE.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Arena if success.
+*/
+Arena* arena_create(Fsa_pool* pool_p, const size_t block_size);
+
+/*
+    This function give all blocks of arena back to fsa.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+
+    RETURN:
+    This is void function.
+*/
+void arena_destroy(Arena* arena_p);
+
+/*
+    This function allocate memory when current block is full, it is slow path of arena_alloc and it should not be
+    called directly. Next block of chain is reused if request fits in it, otherwise new block is taken from fsa.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* arena_alloc_from_next_block(Arena* arena_p, const size_t bytes);
+
+/*
+    This function allocate memory aligned to ARENA_ALIGNMENT. End of block is aligned too, so fitting request can not
+    cross it after rounding.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static inline void* arena_alloc(Arena* arena_p, const size_t bytes)
+{
+    uint8_t* const addr_p = arena_p->top;
+
+    if (__builtin_expect(bytes <= (size_t)(arena_p->end - addr_p), 1))
+    {
+        arena_p->top = addr_p + ((bytes + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1));
+        return addr_p;
+    }
+
+    return arena_alloc_from_next_block(arena_p, bytes);
+}
+
+/*
+    This function allocate memory aligned to @alignment.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @IN alignment - requested alignment, it has to be power of two.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* arena_alloc_aligned(Arena* arena_p, const size_t alignment, const size_t bytes);
+
+/*
+    This function save current position in arena.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+
+    RETURN:
+    Mark of current position.
+*/
+Arena_mark arena_get_mark(const Arena* arena_p);
+
+/*
+    This function free everything allocated after mark was taken. Mark has to be taken after last reset and before
+    restore to earlier mark.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @IN mark - mark returned by arena_get_mark.
+
+    RETURN:
+    This is void function.
+*/
+void arena_restore(Arena* arena_p, const Arena_mark mark);
+
+/*
+    This function free everything allocated in arena, blocks are kept for next allocations.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+
+    RETURN:
+    This is void function.
+*/
+void arena_reset(Arena* arena_p);
+
+/*
+    This function give blocks after current one back to fsa.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+
+    RETURN:
+    This is void function.
+*/
+void arena_trim(Arena* arena_p);
+
+/*
+    This function fill statistics of arena.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void arena_read_statistics(const Arena* arena_p, Arena_statistics* stats_p);
+
+#endif /* ARENA_ALLOCATOR_H */
@@ -0,0 +1,330 @@
+#include <arena_allocator.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+#if (ARENA_ALIGNMENT & (ARENA_ALIGNMENT - 1)) != 0 || ARENA_ALIGNMENT < 8
+#error "ARENA_ALIGNMENT has to be power of two not smaller than 8"
+#endif
+
+/* space taken at the begin of each block, memory after it is aligned to ARENA_ALIGNMENT */
+#define BLOCK_HEADER_SIZE __align_up(sizeof(Arena_block), ARENA_ALIGNMENT)
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/* header of block taken from fsa */
+struct Arena_block
+{
+    Arena_block* next_p;
+    size_t size; /* usable size of block given by fsa, header included */
+    uint8_t* top; /* top of block when arena moved to next one */
+};
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+    This function round @value up to multiple of @alignment.
+
+    PARAMS:
+    @IN value - value to round.
+    @IN alignment - power of two.
+
+    RETURN:
+    Rounded value.
+*/
+static inline size_t __align_up(const size_t value, const size_t alignment);
+
+/*
+    This function take block of at least @size bytes (header included) from fsa.
+
+    PARAMS:
+    @IN pool_p - fsa pool, NULL for default pool.
+    @IN size - size of block in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to block if success.
+*/
+static Arena_block* __block_create(Fsa_pool* pool_p, const size_t size);
+
+/*
+    This function give block back to fsa.
+
+    PARAMS:
+    @IN pool_p - fsa pool, NULL for default pool.
+    @IN block_p - pointer to block.
+
+    RETURN:
+    This is void function.
+*/
+static void __block_destroy(Fsa_pool* pool_p, Arena_block* block_p);
+
+/*
+    This function compute begin of memory for allocations in block.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @IN block_p - pointer to block.
+
+    RETURN:
+    Address of the first allocation in block.
+*/
+static inline uint8_t* __block_begin(const Arena* arena_p, const Arena_block* block_p);
+
+/*
+    This function make @block_p current block of arena with top at @top.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+    @IN block_p - pointer to block.
+    @IN top - next allocation in block.
+
+    RETURN:
+    This is void function.
+*/
+static inline void __set_current_block(Arena* arena_p, Arena_block* block_p, uint8_t* top);
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline size_t __align_up(const size_t value, const size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static Arena_block* __block_create(Fsa_pool* pool_p, const size_t size)
+{
+    Arena_block* const block_p = pool_p == NULL ? fsa_alloc(size) : fsa_pool_alloc(pool_p, size);
+
+    if (block_p == NULL)
+    {
+        return NULL;
+    }
+
+    /* fsa gives whole chunks, so the rest of the last one is used too */
+    block_p->next_p = NULL;
+    block_p->size = pool_p == NULL ? fsa_get_usable_size(block_p) : fsa_pool_get_usable_size(pool_p, block_p);
+    block_p->top = NULL;
+
+    return block_p;
+}
+
+static void __block_destroy(Fsa_pool* pool_p, Arena_block* block_p)
+{
+    if (pool_p == NULL)
+    {
+        fsa_dealloc(block_p);
+    }
+    else
+    {
+        fsa_pool_dealloc(pool_p, block_p);
+    }
+}
+
+static inline uint8_t* __block_begin(const Arena* arena_p, const Arena_block* block_p)
+{
+    uint8_t* const begin_p = (uint8_t*)block_p + BLOCK_HEADER_SIZE;
+
+    /* the first block keeps descriptor of arena */
+    if (block_p == arena_p->first_block_p)
+    {
+        return begin_p + __align_up(sizeof(Arena), ARENA_ALIGNMENT);
+    }
+
+    return begin_p;
+}
+
+static inline void __set_current_block(Arena* arena_p, Arena_block* block_p, uint8_t* top)
+{
+    arena_p->block_p = block_p;
+    arena_p->top = top;
+    arena_p->end = (uint8_t*)block_p + block_p->size;
+}
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+Arena* arena_create(Fsa_pool* pool_p, const size_t block_size)
+{
+    const size_t overhead = BLOCK_HEADER_SIZE + __align_up(sizeof(Arena), ARENA_ALIGNMENT);
+    const size_t size = block_size == 0 ? ARENA_DEFAULT_BLOCK_SIZE : block_size;
+
+    if (size <= overhead)
+    {
+        return NULL;
+    }
+
+    Arena_block* const block_p = __block_create(pool_p, size);
+
+    if (block_p == NULL)
+    {
+        return NULL;
+    }
+
+    Arena* const arena_p = (Arena*)((uint8_t*)block_p + BLOCK_HEADER_SIZE);
+
+    arena_p->first_block_p = block_p;
+    arena_p->pool_p = pool_p;
+    arena_p->block_size = size;
+
+    __set_current_block(arena_p, block_p, __block_begin(arena_p, block_p));
+
+    return arena_p;
+}
+
+void arena_destroy(Arena* arena_p)
+{
+    if (arena_p == NULL)
+    {
+        return;
+    }
+
+    Fsa_pool* const pool_p = arena_p->pool_p;
+    Arena_block* block_p = arena_p->first_block_p;
+
+    /* descriptor is in the first block, so it is read before block is given back */
+    while (block_p != NULL)
+    {
+        Arena_block* const next_p = block_p->next_p;
+
+        __block_destroy(pool_p, block_p);
+        block_p = next_p;
+    }
+}
+
+void* arena_alloc_from_next_block(Arena* arena_p, const size_t bytes)
+{
+    if (bytes > SIZE_MAX - BLOCK_HEADER_SIZE - ARENA_ALIGNMENT)
+    {
+        return NULL;
+    }
+
+    const size_t size = __align_up(bytes, ARENA_ALIGNMENT);
+    Arena_block* const block_p = arena_p->block_p;
+    Arena_block* next_p = block_p->next_p;
+
+    /* block is reused after reset or restore only if request fits, too small one stays in chain for later */
+    if (next_p == NULL || next_p->size - BLOCK_HEADER_SIZE < size)
+    {
+        const size_t needed = BLOCK_HEADER_SIZE + size;
+        Arena_block* const new_block_p = __block_create(arena_p->pool_p,
+                                                        needed > arena_p->block_size ? needed : arena_p->block_size);
+
+        if (new_block_p == NULL)
+        {
+            return NULL;
+        }
+
+        new_block_p->next_p = next_p;
+        block_p->next_p = new_block_p;
+        next_p = new_block_p;
+    }
+
+    block_p->top = arena_p->top;
+
+    uint8_t* const addr_p = __block_begin(arena_p, next_p);
+    __set_current_block(arena_p, next_p, addr_p + size);
+
+    return addr_p;
+}
+
+void* arena_alloc_aligned(Arena* arena_p, const size_t alignment, const size_t bytes)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return NULL;
+    }
+
+    if (alignment <= ARENA_ALIGNMENT)
+    {
+        return arena_alloc(arena_p, bytes);
+    }
+
+    const uintptr_t top = (uintptr_t)arena_p->top;
+    const size_t padding = __align_up(top, alignment) - top;
+    const size_t free_bytes = (size_t)(arena_p->end - arena_p->top);
+
+    if (padding <= free_bytes && bytes <= free_bytes - padding)
+    {
+        uint8_t* const addr_p = arena_p->top + padding;
+        arena_p->top = addr_p + __align_up(bytes, ARENA_ALIGNMENT);
+
+        return addr_p;
+    }
+
+    if (bytes > SIZE_MAX - alignment)
+    {
+        return NULL;
+    }
+
+    /* new block is aligned only to ARENA_ALIGNMENT, so space for padding is requested too */
+    uint8_t* const addr_p = arena_alloc_from_next_block(arena_p, bytes + alignment - ARENA_ALIGNMENT);
+
+    if (addr_p == NULL)
+    {
+        return NULL;
+    }
+
+    return addr_p + (__align_up((uintptr_t)addr_p, alignment) - (uintptr_t)addr_p);
+}
+
+Arena_mark arena_get_mark(const Arena* arena_p)
+{
+    const Arena_mark mark = {.block_p = arena_p->block_p, .top = arena_p->top};
+
+    return mark;
+}
+
+void arena_restore(Arena* arena_p, const Arena_mark mark)
+{
+    __set_current_block(arena_p, mark.block_p, mark.top);
+}
+
+void arena_reset(Arena* arena_p)
+{
+    Arena_block* const block_p = arena_p->first_block_p;
+
+    __set_current_block(arena_p, block_p, __block_begin(arena_p, block_p));
+}
+
+void arena_trim(Arena* arena_p)
+{
+    Arena_block* block_p = arena_p->block_p->next_p;
+
+    arena_p->block_p->next_p = NULL;
+
+    while (block_p != NULL)
+    {
+        Arena_block* const next_p = block_p->next_p;
+
+        __block_destroy(arena_p->pool_p, block_p);
+        block_p = next_p;
+    }
+}
+
+void arena_read_statistics(const Arena* arena_p, Arena_statistics* stats_p)
+{
+    if (stats_p == NULL)
+    {
+        return;
+    }
+
+    *stats_p = (Arena_statistics){0};
+
+    bool is_before_current = true;
+
+    for (const Arena_block* block_p = arena_p->first_block_p; block_p != NULL; block_p = block_p->next_p)
+    {
+        ++stats_p->nr_of_blocks;
+        stats_p->size_of_blocks += block_p->size;
+
+        if (block_p == arena_p->block_p)
+        {
+            stats_p->bytes_in_use += (size_t)(arena_p->top - __block_begin(arena_p, block_p));
+            is_before_current = false;
+        }
+        else if (is_before_current)
+        {
+            stats_p->bytes_in_use += (size_t)(block_p->top - __block_begin(arena_p, block_p));
+        }
+    }
+}
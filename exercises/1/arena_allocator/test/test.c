@@ -0,0 +1,444 @@
+#include <arena_allocator.h>
+#include <fixed_size_allocator.h>
+#include <split_size_allocator.h>
+#include <benchmark.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* block of 2 chunks in tests, so chain grows quickly */
+#define TEST_BLOCK_SIZE (2 * SIZE_OF_CHUNK)
+
+/* number of requests in benchmark, each of them allocates objects and frees all of them at the end */
+#define NR_OF_REQUESTS 20000
+
+/* number of objects allocated by one request, sizes are from [MIN_OBJECT_SIZE, MAX_OBJECT_SIZE] */
+#define NR_OF_OBJECTS 64
+#define MIN_OBJECT_SIZE 16
+#define MAX_OBJECT_SIZE 256
+
+/* ---------------------------------------------- STATIC VARIABLES ------------------------------------------------- */
+
+/* objects of one request, freed one by one by allocators without reset */
+static void* objects[NR_OF_OBJECTS];
+
+/* arena used by benchmark */
+static Arena* benchmark_arena_p;
+
+/* ------------------------------------------- FUNCTION DECLARATION ------------------------------------------------ */
+
+/*
+    In this test case we want to make sure that allocations are aligned, do not overlap and chain of blocks grows when
+    block is full, also for requests bigger than block.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_allocations(void);
+
+/*
+    In this test case we want to make sure that restore to mark frees only what was allocated after mark and next
+    allocations reuse the same memory and blocks.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_marks(void);
+
+/*
+    In this test case we want to make sure that reset keeps blocks for reuse and trim gives them back to fsa.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_reset_and_trim(void);
+
+/*
+    In this test case we want to make sure that arena works on its own fsa pool and allocation fails without side
+    effects when pool is full.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_pool(void);
+
+/*
+    Workload of benchmark: requests of NR_OF_OBJECTS objects each, all of them are freed at the end of request.
+
+    PARAMS:
+    @IN alloc - allocation function.
+    @IN dealloc - deallocation function.
+
+    RETURN:
+    This is void function.
+*/
+static void __run_requests(void* (*alloc)(size_t), void (*dealloc)(void*));
+
+/*
+    Workload of benchmark on arena, objects are freed by reset.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __run_requests_on_arena(void);
+
+/*
+    Benchmark of request-scoped allocations on arena, fsa slab, ssa and libc malloc.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_requests(void);
+
+/* ---------------------------------------------- TEST DEFINITION -------------------------------------------------- */
+
+static void test_allocations(void)
+{
+    fsa_init();
+
+    Arena* const arena_p = arena_create(NULL, TEST_BLOCK_SIZE);
+    assert(arena_p != NULL);
+
+    Arena_statistics stats;
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.nr_of_blocks == 1 && stats.size_of_blocks == TEST_BLOCK_SIZE && stats.bytes_in_use == 0);
+
+    /* small requests fill first block, then the second one is taken */
+    uint8_t* blocks[400];
+    size_t requested = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); ++i)
+    {
+        const size_t bytes = 1 + i % 40;
+        blocks[i] = arena_alloc(arena_p, bytes);
+        assert(blocks[i] != NULL && (uintptr_t)blocks[i] % ARENA_ALIGNMENT == 0);
+
+        memset(blocks[i], (int)i, bytes);
+        requested += bytes;
+    }
+
+    /* nothing was overwritten by next allocations */
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); ++i)
+    {
+        for (size_t j = 0; j < 1 + i % 40; ++j)
+        {
+            assert(blocks[i][j] == (uint8_t)i);
+        }
+    }
+
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.nr_of_blocks == 2 && stats.bytes_in_use >= requested);
+
+    /* zero bytes is valid request */
+    assert(arena_alloc(arena_p, 0) != NULL);
+
+    /* request bigger than block gets its own block */
+    uint8_t* const big_p = arena_alloc(arena_p, 3 * TEST_BLOCK_SIZE);
+    assert(big_p != NULL);
+    memset(big_p, 0xab, 3 * TEST_BLOCK_SIZE);
+
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.nr_of_blocks == 3 && stats.size_of_blocks >= 5 * TEST_BLOCK_SIZE);
+
+    /* aligned allocations in current block and in new one */
+    for (size_t alignment = 1; alignment <= 2 * SIZE_OF_CHUNK; alignment <<= 1)
+    {
+        uint8_t* const addr_p = arena_alloc_aligned(arena_p, alignment, 100);
+        assert(addr_p != NULL && (uintptr_t)addr_p % alignment == 0);
+
+        memset(addr_p, 0xcd, 100);
+    }
+
+    assert(arena_alloc_aligned(arena_p, 48, 16) == NULL);
+    assert(arena_alloc(arena_p, SIZE_MAX) == NULL);
+    assert(arena_alloc(arena_p, (size_t)MEMORY_SIZE) == NULL);
+
+    arena_destroy(arena_p);
+
+    /* all blocks are given back */
+    Fsa_statistics fsa_stats;
+    fsa_read_statistics(&fsa_stats);
+    assert(fsa_stats.nr_of_chunks_in_use == 0);
+
+    /* block has to keep at least descriptor */
+    assert(arena_create(NULL, 16) == NULL);
+}
+
+static void test_marks(void)
+{
+    fsa_init();
+
+    Arena* const arena_p = arena_create(NULL, TEST_BLOCK_SIZE);
+    assert(arena_p != NULL);
+
+    void* const kept_p = arena_alloc(arena_p, 100);
+    memset(kept_p, 0x11, 100);
+
+    const Arena_mark mark = arena_get_mark(arena_p);
+
+    Arena_statistics before;
+    arena_read_statistics(arena_p, &before);
+
+    /* scope allocates over few blocks */
+    void* first_p = NULL;
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        void* const addr_p = arena_alloc(arena_p, 200);
+        assert(addr_p != NULL);
+
+        first_p = first_p == NULL ? addr_p : first_p;
+    }
+
+    Arena_statistics after;
+    arena_read_statistics(arena_p, &after);
+    assert(after.nr_of_blocks > 1 && after.bytes_in_use >= before.bytes_in_use + 100 * 200);
+
+    /* nested mark in the last block */
+    const Arena_mark nested_mark = arena_get_mark(arena_p);
+    void* const nested_p = arena_alloc(arena_p, 64);
+
+    arena_restore(arena_p, nested_mark);
+    assert(arena_alloc(arena_p, 64) == nested_p);
+
+    /* everything after mark is freed, kept allocation is untouched */
+    arena_restore(arena_p, mark);
+
+    Arena_statistics restored;
+    arena_read_statistics(arena_p, &restored);
+    assert(restored.bytes_in_use == before.bytes_in_use && restored.nr_of_blocks == after.nr_of_blocks);
+
+    assert(arena_alloc(arena_p, 200) == first_p);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        assert(((uint8_t*)kept_p)[i] == 0x11);
+    }
+
+    /* the same scope again takes no new blocks */
+    for (size_t i = 1; i < 100; ++i)
+    {
+        assert(arena_alloc(arena_p, 200) != NULL);
+    }
+
+    arena_read_statistics(arena_p, &restored);
+    assert(restored.nr_of_blocks == after.nr_of_blocks);
+
+    arena_destroy(arena_p);
+}
+
+static void test_reset_and_trim(void)
+{
+    fsa_init();
+
+    Arena* const arena_p = arena_create(NULL, TEST_BLOCK_SIZE);
+    assert(arena_p != NULL);
+
+    void* const first_p = arena_alloc(arena_p, 32);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        assert(arena_alloc(arena_p, TEST_BLOCK_SIZE / 2) != NULL);
+    }
+
+    Fsa_statistics fsa_before;
+    fsa_read_statistics(&fsa_before);
+
+    Arena_statistics stats;
+    arena_read_statistics(arena_p, &stats);
+
+    const size_t nr_of_blocks = stats.nr_of_blocks;
+    assert(nr_of_blocks > 2);
+
+    /* reset keeps blocks, next allocations start from the begin again */
+    arena_reset(arena_p);
+
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.bytes_in_use == 0 && stats.nr_of_blocks == nr_of_blocks);
+
+    assert(arena_alloc(arena_p, 32) == first_p);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        assert(arena_alloc(arena_p, TEST_BLOCK_SIZE / 2) != NULL);
+    }
+
+    Fsa_statistics fsa_after;
+    fsa_read_statistics(&fsa_after);
+    assert(fsa_after.nr_of_allocs == fsa_before.nr_of_allocs);
+
+    /* too small block after reset is skipped, new one is put before it */
+    arena_reset(arena_p);
+    assert(arena_alloc(arena_p, 4 * TEST_BLOCK_SIZE) != NULL);
+
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.nr_of_blocks == nr_of_blocks + 1);
+
+    /* trim gives back blocks after current one */
+    arena_trim(arena_p);
+
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.nr_of_blocks == 2);
+
+    fsa_read_statistics(&fsa_after);
+    assert(fsa_after.bytes_in_use == stats.size_of_blocks);
+
+    arena_reset(arena_p);
+    arena_trim(arena_p);
+
+    arena_read_statistics(arena_p, &stats);
+    assert(stats.nr_of_blocks == 1 && stats.size_of_blocks == TEST_BLOCK_SIZE);
+
+    arena_destroy(arena_p);
+}
+
+static void test_pool(void)
+{
+    static uint8_t region[8 * SIZE_OF_CHUNK] __attribute__((aligned(SIZE_OF_CHUNK)));
+
+    Fsa_pool* const pool_p = fsa_pool_create(&region[0], sizeof(region), SIZE_OF_CHUNK);
+    assert(pool_p != NULL);
+
+    Arena* const arena_p = arena_create(pool_p, TEST_BLOCK_SIZE);
+    assert((uint8_t*)arena_p >= &region[0] && (uint8_t*)arena_p < &region[0] + sizeof(region));
+
+    /* 4 blocks fit in region */
+    for (size_t i = 0; i < 4; ++i)
+    {
+        void* const addr_p = arena_alloc(arena_p, TEST_BLOCK_SIZE / 2);
+        assert((uint8_t*)addr_p >= &region[0] && (uint8_t*)addr_p < &region[0] + sizeof(region));
+    }
+
+    const Arena_mark mark = arena_get_mark(arena_p);
+
+    void* addr_p;
+
+    do
+    {
+        addr_p = arena_alloc(arena_p, TEST_BLOCK_SIZE / 2);
+    } while (addr_p != NULL);
+
+    /* failure does not move arena */
+    const Arena_mark failed_mark = arena_get_mark(arena_p);
+    assert(arena_alloc(arena_p, 1) != NULL);
+
+    arena_restore(arena_p, failed_mark);
+    arena_restore(arena_p, mark);
+
+    arena_destroy(arena_p);
+
+    Fsa_statistics stats;
+    fsa_pool_read_statistics(pool_p, &stats);
+    assert(stats.nr_of_chunks_in_use == 0);
+
+    fsa_pool_destroy(pool_p);
+}
+
+/* ------------------------------------------- BENCHMARK DEFINITION ------------------------------------------------ */
+
+static void __run_requests(void* (*alloc)(size_t), void (*dealloc)(void*))
+{
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < NR_OF_REQUESTS; ++i)
+    {
+        for (size_t j = 0; j < NR_OF_OBJECTS; ++j)
+        {
+            seed = seed * 1103515245u + 12345u;
+
+            objects[j] = alloc(MIN_OBJECT_SIZE + (seed >> 8) % (MAX_OBJECT_SIZE - MIN_OBJECT_SIZE + 1));
+            assert(objects[j] != NULL);
+        }
+
+        for (size_t j = 0; j < NR_OF_OBJECTS; ++j)
+        {
+            dealloc(objects[j]);
+        }
+    }
+}
+
+static void __run_requests_on_arena(void)
+{
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < NR_OF_REQUESTS; ++i)
+    {
+        for (size_t j = 0; j < NR_OF_OBJECTS; ++j)
+        {
+            seed = seed * 1103515245u + 12345u;
+
+            objects[j] = arena_alloc(benchmark_arena_p,
+                                     MIN_OBJECT_SIZE + (seed >> 8) % (MAX_OBJECT_SIZE - MIN_OBJECT_SIZE + 1));
+            assert(objects[j] != NULL);
+        }
+
+        arena_reset(benchmark_arena_p);
+    }
+}
+
+static void benchmark_requests(void)
+{
+    printf("REQUESTS, %d requests of %d objects of [%d, %d] B\n",
+           NR_OF_REQUESTS,
+           NR_OF_OBJECTS,
+           MIN_OBJECT_SIZE,
+           MAX_OBJECT_SIZE);
+
+    fsa_init();
+
+    benchmark_arena_p = arena_create(NULL, 0);
+    assert(benchmark_arena_p != NULL);
+
+    MEASURE_FUNCTION(__run_requests_on_arena(), "arena");
+
+    arena_destroy(benchmark_arena_p);
+
+    fsa_init();
+    MEASURE_FUNCTION(__run_requests(fsa_slab_alloc, fsa_dealloc), "fsa slab");
+
+    ssa_init();
+    MEASURE_FUNCTION(__run_requests(ssa_alloc, ssa_dealloc), "ssa");
+
+    MEASURE_FUNCTION(__run_requests(malloc, free), "malloc");
+}
+
+/* ----------------------------------------------- MAIN FUNCTION --------------------------------------------------- */
+
+int main(void)
+{
+    test_allocations();
+    test_marks();
+    test_reset_and_trim();
+    test_pool();
+
+    benchmark_requests();
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#ifndef BUDDY_ALLOCATOR_H
+#define BUDDY_ALLOCATOR_H
+
+/*
+    Implementation of buddy allocator using static memory. Memory is split into blocks of power of two sizes, each
+    block of order n is aligned to 2^n and its buddy is found by XOR of offset with 2^n. Free blocks are kept on one list
+    per order, so alloc and dealloc take at most one split or merge per order.
+
+    author: Kamil Kielbasa
+    email: dusergithub@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <stddef.h>
+
+/* default value, MEMORY_SIZE should be passed in compile time by -D option, it has to be power of two */
+#ifndef MEMORY_SIZE
+#define MEMORY_SIZE (1 << 20) /* 1 MB */
+#endif
+
+/* the smallest block is 2^BUDDY_MIN_ORDER bytes, could be passed in compile time by -D option */
+#ifndef BUDDY_MIN_ORDER
+#define BUDDY_MIN_ORDER 4 /* 16 B */
+#endif
+
+/*
+    Statistics of allocator. Counters are updated by alloc and dealloc, so reading them does not walk through memory.
+    Sizes are in bytes and they are sizes of blocks, not requested sizes.
+*/
+struct Buddy_statistics
+{
+    size_t nr_of_blocks_in_use;
+    size_t bytes_in_use;
+    size_t peak_bytes_in_use;
+
+    size_t nr_of_free_blocks;
+    size_t size_of_largest_free_block;
+
+    size_t nr_of_allocs;
+    size_t nr_of_frees;
+    size_t nr_of_failures;
+};
+
+typedef struct Buddy_statistics Buddy_statistics;
+
+/*
+    This function is responsible for set whole memory as one free block. Only metadata is written: states of blocks,
+    free lists and links of the first block, memory of blocks is not touched (and not zeroed).
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void buddy_init(void);
+
+/*
+    This function allocate block of the smallest order which keeps @bytes. Bigger free block is split in halves until
+    block of such order is made, second halves go to free lists.
+
+    PARAMS:
+    @bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success, aligned to size of block.
+*/
+void* buddy_alloc(const size_t bytes);
+
+/*
+    This function free block and merge it with its buddy as long as buddy is free block of the same order. Pointer
+    which was not returned by buddy_alloc or which is already freed is ignored.
+
+    PARAMS:
+    @addr_p - pointer to memory for freeing.
+
+    RETURN:
+    This is void function.
+*/
+void buddy_dealloc(void* addr_p);
+
+/*
+    This function fill statistics of allocator.
+
+    PARAMS:
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void buddy_read_statistics(Buddy_statistics* stats_p);
+
+/*
+    This function is responsible for print statistics of allocator (see buddy_read_statistics) to stdio.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void buddy_get_statistics(void);
+
+/*
+    Getter for size of memory array.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    Size of memory.
+*/
+size_t buddy_get_size_of_memory(void);
+
+/*
+    Getter for memory address. Returned pointer must be used as read only.
+
+    PARAMS:
+    @IN index - index in memory array.
+
+    RETURN:
+    Address from @(&memory[index]).
+*/
+void* buddy_get_address_from_memory(const size_t index);
+
+#endif /* BUDDY_ALLOCATOR_H */
@@ -0,0 +1,309 @@
+#include <buddy_allocator.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* list n keeps free blocks of 2^n bytes, orders below BUDDY_MIN_ORDER are never used */
+#define NR_OF_ORDERS 32
+
+/* end of free list */
+#define NO_BLOCK UINT32_MAX
+
+/* number of the smallest blocks in memory, each of them has got its state */
+#define NR_OF_MIN_BLOCKS (MEMORY_SIZE >> BUDDY_MIN_ORDER)
+
+/* state of block start: order of block and flag of free block, 0 if no block starts there */
+#define BLOCK_FREE 0x80
+#define BLOCK_ORDER_MASK 0x7f
+
+#if (MEMORY_SIZE & (MEMORY_SIZE - 1)) != 0 || MEMORY_SIZE > (1 << 30)
+#error "MEMORY_SIZE has to be power of two not bigger than 1 GB"
+#endif
+
+#if BUDDY_MIN_ORDER < 3
+#error "BUDDY_MIN_ORDER has to keep free list links"
+#endif
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/* free block keeps offsets of neighbours on free list at its begin */
+struct Free_block
+{
+    uint32_t next;
+    uint32_t prev;
+};
+
+typedef struct Free_block Free_block;
+
+/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+
+/* memory for allocations, each block is aligned to its size */
+static uint8_t memory[MEMORY_SIZE] __attribute__((aligned(1 << BUDDY_MIN_ORDER)));
+
+/* state of block which starts at each of the smallest blocks */
+static uint8_t block_states[NR_OF_MIN_BLOCKS];
+
+/* offsets of the first free block in each order */
+static uint32_t free_lists[NR_OF_ORDERS];
+
+/* bit n is set if free list of order n is not empty */
+static uint32_t free_lists_bitmap;
+
+/* statistics updated by alloc and dealloc */
+static Buddy_statistics statistics;
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+    This function compute the smallest order of block which keeps @bytes.
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    Order of block.
+*/
+static inline size_t __order_of(const size_t bytes);
+
+/*
+    This function add free block to the head of its list and mark it as free.
+
+    PARAMS:
+    @IN offset - offset of block in memory.
+    @IN order - order of block.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_list_push(const size_t offset, const size_t order);
+
+/*
+    This function remove free block from its list and clear its state.
+
+    PARAMS:
+    @IN offset - offset of block in memory.
+    @IN order - order of block.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_list_remove(const size_t offset, const size_t order);
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline size_t __order_of(const size_t bytes)
+{
+    if (bytes <= ((size_t)1 << BUDDY_MIN_ORDER))
+    {
+        return BUDDY_MIN_ORDER;
+    }
+
+    return (size_t)(64 - __builtin_clzll((unsigned long long)(bytes - 1)));
+}
+
+static void __free_list_push(const size_t offset, const size_t order)
+{
+    Free_block* const block_p = (Free_block*)&memory[offset];
+
+    block_p->prev = NO_BLOCK;
+    block_p->next = free_lists[order];
+
+    if (free_lists[order] != NO_BLOCK)
+    {
+        ((Free_block*)&memory[free_lists[order]])->prev = (uint32_t)offset;
+    }
+
+    free_lists[order] = (uint32_t)offset;
+    free_lists_bitmap |= (uint32_t)1 << order;
+
+    block_states[offset >> BUDDY_MIN_ORDER] = (uint8_t)(BLOCK_FREE | order);
+
+    ++statistics.nr_of_free_blocks;
+}
+
+static void __free_list_remove(const size_t offset, const size_t order)
+{
+    const Free_block* const block_p = (const Free_block*)&memory[offset];
+
+    if (block_p->prev != NO_BLOCK)
+    {
+        ((Free_block*)&memory[block_p->prev])->next = block_p->next;
+    }
+    else
+    {
+        free_lists[order] = block_p->next;
+    }
+
+    if (block_p->next != NO_BLOCK)
+    {
+        ((Free_block*)&memory[block_p->next])->prev = block_p->prev;
+    }
+
+    if (free_lists[order] == NO_BLOCK)
+    {
+        free_lists_bitmap &= ~((uint32_t)1 << order);
+    }
+
+    block_states[offset >> BUDDY_MIN_ORDER] = 0;
+
+    --statistics.nr_of_free_blocks;
+}
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+void buddy_init(void)
+{
+    /* only metadata is written, memory of blocks is not touched */
+    (void)memset(&block_states[0], 0, sizeof(block_states));
+    (void)memset(&statistics, 0, sizeof(statistics));
+
+    for (size_t i = 0; i < NR_OF_ORDERS; ++i)
+    {
+        free_lists[i] = NO_BLOCK;
+    }
+
+    free_lists_bitmap = 0;
+
+    __free_list_push(0, (size_t)__builtin_ctz(MEMORY_SIZE));
+}
+
+void* buddy_alloc(const size_t bytes)
+{
+    if (bytes == 0)
+    {
+        return NULL;
+    }
+
+    if (bytes > MEMORY_SIZE)
+    {
+        ++statistics.nr_of_failures;
+        return NULL;
+    }
+
+    const size_t order = __order_of(bytes);
+    const uint32_t orders = free_lists_bitmap & (UINT32_MAX << order);
+
+    if (orders == 0)
+    {
+        ++statistics.nr_of_failures;
+        return NULL;
+    }
+
+    /* the smallest free block which is big enough */
+    size_t block_order = (size_t)__builtin_ctz(orders);
+    const size_t offset = free_lists[block_order];
+
+    __free_list_remove(offset, block_order);
+
+    /* second half of block goes to free list until block has got requested order */
+    while (block_order > order)
+    {
+        --block_order;
+        __free_list_push(offset + ((size_t)1 << block_order), block_order);
+    }
+
+    block_states[offset >> BUDDY_MIN_ORDER] = (uint8_t)order;
+
+    ++statistics.nr_of_allocs;
+    ++statistics.nr_of_blocks_in_use;
+    statistics.bytes_in_use += (size_t)1 << order;
+
+    if (statistics.bytes_in_use > statistics.peak_bytes_in_use)
+    {
+        statistics.peak_bytes_in_use = statistics.bytes_in_use;
+    }
+
+    return (void*)&memory[offset];
+}
+
+void buddy_dealloc(void* addr_p)
+{
+    if (addr_p == NULL)
+    {
+        return;
+    }
+
+    /* pointer out of memory or not at start of the smallest block can not be returned by buddy_alloc */
+    size_t offset = (size_t)((uintptr_t)addr_p - (uintptr_t)&memory[0]);
+    if (offset >= MEMORY_SIZE || (offset & (((size_t)1 << BUDDY_MIN_ORDER) - 1)) != 0)
+    {
+        return;
+    }
+
+    /* no block starts there or block is already free (double free) */
+    const uint8_t state = block_states[offset >> BUDDY_MIN_ORDER];
+    if (state == 0 || (state & BLOCK_FREE) != 0)
+    {
+        return;
+    }
+
+    size_t order = state & BLOCK_ORDER_MASK;
+
+    ++statistics.nr_of_frees;
+    --statistics.nr_of_blocks_in_use;
+    statistics.bytes_in_use -= (size_t)1 << order;
+
+    block_states[offset >> BUDDY_MIN_ORDER] = 0;
+
+    /* merge with buddy as long as it is free block of the same order */
+    while (((size_t)1 << order) < MEMORY_SIZE)
+    {
+        const size_t buddy_offset = offset ^ ((size_t)1 << order);
+
+        if (block_states[buddy_offset >> BUDDY_MIN_ORDER] != (BLOCK_FREE | order))
+        {
+            break;
+        }
+
+        __free_list_remove(buddy_offset, order);
+
+        offset &= ~((size_t)1 << order);
+        ++order;
+    }
+
+    __free_list_push(offset, order);
+}
+
+void buddy_read_statistics(Buddy_statistics* stats_p)
+{
+    if (stats_p == NULL)
+    {
+        return;
+    }
+
+    *stats_p = statistics;
+
+    /* all blocks of the highest not empty order have got the same size */
+    stats_p->size_of_largest_free_block =
+        free_lists_bitmap == 0 ? 0 : (size_t)1 << (NR_OF_ORDERS - 1 - __builtin_clz(free_lists_bitmap));
+}
+
+void buddy_get_statistics(void)
+{
+    Buddy_statistics stats;
+    buddy_read_statistics(&stats);
+
+    printf("number of allocated blocks = %zu\n", stats.nr_of_blocks_in_use);
+    printf("bytes in use = %zu (peak = %zu)\n", stats.bytes_in_use, stats.peak_bytes_in_use);
+    printf("number of free blocks = %zu\n", stats.nr_of_free_blocks);
+    printf("size of largest free block = %zu\n", stats.size_of_largest_free_block);
+    printf("allocs = %zu, frees = %zu, failures = %zu\n", stats.nr_of_allocs, stats.nr_of_frees, stats.nr_of_failures);
+}
+
+size_t buddy_get_size_of_memory(void)
+{
+    return ARRAY_SIZE(memory);
+}
+
+void* buddy_get_address_from_memory(const size_t index)
+{
+    return (void*)&memory[index];
+}
@@ -0,0 +1,501 @@
+#include <buddy_allocator.h>
+#include <fixed_size_allocator.h>
+#include <split_size_allocator.h>
+#include <benchmark.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* size of the smallest block */
+#define TEST_MIN_BLOCK_SIZE ((size_t)1 << BUDDY_MIN_ORDER)
+
+/* number of blocks kept allocated at once in benchmark */
+#define NR_OF_LIVE_BLOCKS 128
+
+/* number of allocations in benchmark workload */
+#define NR_OF_OPERATIONS 100000
+
+/* requests in benchmark workload are from [MIN_REQUEST_SIZE, MAX_REQUEST_SIZE], fsa slab layer keeps up to 2 kB */
+#define MIN_REQUEST_SIZE 16
+#define MAX_REQUEST_SIZE 2048
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/* state of benchmark workload after it is done */
+struct Workload
+{
+    void* live[NR_OF_LIVE_BLOCKS];
+    size_t requested[NR_OF_LIVE_BLOCKS];
+    size_t nr_of_failures;
+};
+
+typedef struct Workload Workload;
+
+/* ---------------------------------------------- STATIC VARIABLES ------------------------------------------------- */
+
+/* workload shared by all allocators in benchmark */
+static Workload workload;
+
+/* ------------------------------------------- FUNCTION DECLARATION ------------------------------------------------ */
+
+/*
+    In this test case we want to make sure that init writes only metadata and does not touch pages of memory.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_init(void);
+
+/*
+    Count pages of @size bytes from @addr_p which are resident in RAM.
+
+    PARAMS:
+    @IN addr_p - page aligned address.
+    @IN size - number of bytes.
+
+    RETURN:
+    Number of resident pages.
+*/
+static size_t __count_resident_pages(void* addr_p, const size_t size);
+
+/*
+    In this test case we want to make sure that blocks have got size of power of two and they are aligned to it.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_allocations(void);
+
+/*
+    In this test case we want to make sure that freed blocks are merged with buddies up to one block of whole memory,
+    in any order of deallocations.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_deallocations(void);
+
+/*
+    In this test case we want to check that statistics follow splits and merges.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_statistics(void);
+
+/*
+    In this test case we want to check that double free and pointers not returned by buddy_alloc are ignored.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_invalid_deallocations(void);
+
+/*
+    Run random workload of allocs and deallocs with NR_OF_LIVE_BLOCKS blocks alive. The same seed is used for each
+    allocator, so they get the same requests. Blocks alive at the end are left in workload.
+
+    PARAMS:
+    @IN alloc - allocation function.
+    @IN dealloc - deallocation function.
+
+    RETURN:
+    This is void function.
+*/
+static void __run_workload(void* (*alloc)(const size_t), void (*dealloc)(void*));
+
+/*
+    Print fragmentation of allocator after workload and free blocks left in workload.
+
+    PARAMS:
+    @IN label - name of allocator.
+    @IN bytes_in_use - bytes taken by allocator for blocks alive.
+    @IN size_of_largest_free_block - the biggest request which could be served now.
+    @IN dealloc - deallocation function.
+
+    RETURN:
+    This is void function.
+*/
+static void __report_workload(const char* label,
+                              const size_t bytes_in_use,
+                              const size_t size_of_largest_free_block,
+                              void (*dealloc)(void*));
+
+/*
+    Benchmark of throughput and fragmentation of buddy allocator against fsa (slab layer) and ssa.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_allocators(void);
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+static void test_init(void)
+{
+    buddy_init();
+
+    /* block of whole memory starts at the begin of memory */
+    uint8_t* const memory_p = (uint8_t*)buddy_alloc(MEMORY_SIZE);
+    assert(memory_p != NULL);
+    buddy_dealloc(memory_p);
+
+    /* the first page keeps links of free block, whole pages after it are given back to kernel */
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    uint8_t* const begin_p = (uint8_t*)(((uintptr_t)memory_p & ~(uintptr_t)(page_size - 1)) + page_size);
+    const size_t size = (size_t)(memory_p + MEMORY_SIZE - begin_p) & ~(page_size - 1);
+
+    const int ret = madvise(begin_p, size, MADV_DONTNEED);
+    assert(ret == 0);
+    (void)ret;
+
+    const size_t nr_of_resident = __count_resident_pages(begin_p, size);
+
+    /* init writes only metadata, so pages of memory are not touched */
+    buddy_init();
+
+    assert(__count_resident_pages(begin_p, size) == nr_of_resident);
+}
+
+static size_t __count_resident_pages(void* addr_p, const size_t size)
+{
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t nr_of_pages = (size + page_size - 1) / page_size;
+
+    unsigned char* const vec_p = (unsigned char*)calloc(nr_of_pages, sizeof(*vec_p));
+    assert(vec_p != NULL);
+
+    const int ret = mincore(addr_p, size, vec_p);
+    assert(ret == 0);
+    (void)ret;
+
+    size_t nr_of_resident = 0;
+
+    for (size_t i = 0; i < nr_of_pages; ++i)
+    {
+        nr_of_resident += vec_p[i] & 1;
+    }
+
+    free(vec_p);
+
+    return nr_of_resident;
+}
+
+static void test_allocations(void)
+{
+    buddy_init();
+
+    const size_t size_of_data[] = {1, 16, 17, 100, 128, 1000, 4096, 5000};
+    const size_t size_of_block[] = {16, 16, 32, 128, 128, 1024, 4096, 8192};
+    uint8_t* address[ARRAY_SIZE(size_of_data)] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        address[i] = (uint8_t*)buddy_alloc(size_of_data[i]);
+        assert(address[i] != NULL);
+
+        const size_t offset = (size_t)(address[i] - (uint8_t*)buddy_get_address_from_memory(0));
+        const size_t block_size = size_of_block[i] < TEST_MIN_BLOCK_SIZE ? TEST_MIN_BLOCK_SIZE : size_of_block[i];
+
+        assert((offset & (block_size - 1)) == 0);
+        (void)memset(address[i], 0xff, size_of_data[i]);
+    }
+
+    /* blocks do not overlap */
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        for (size_t j = i + 1; j < ARRAY_SIZE(size_of_data); ++j)
+        {
+            assert(address[i] + size_of_data[i] <= address[j] || address[j] + size_of_data[j] <= address[i]);
+        }
+    }
+
+    assert(buddy_alloc(0) == NULL);
+    assert(buddy_alloc(MEMORY_SIZE) == NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        buddy_dealloc(address[i]);
+    }
+
+    /* whole memory is one block again */
+    void* const all_p = buddy_alloc(MEMORY_SIZE);
+    assert(all_p == buddy_get_address_from_memory(0));
+    assert(buddy_alloc(1) == NULL);
+
+    buddy_dealloc(all_p);
+}
+
+static void test_deallocations(void)
+{
+    buddy_init();
+
+    void* address[64] = {0};
+
+    /* allocate blocks in increasing order and then deallocate them in increasing order */
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = buddy_alloc(i * 10 + 1);
+        assert(address[i] != NULL);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        buddy_dealloc(address[i]);
+    }
+
+    Buddy_statistics stats;
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_free_blocks == 1 && stats.size_of_largest_free_block == MEMORY_SIZE);
+
+    /* allocate blocks in increasing order and then deallocate them in decreasing order */
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = buddy_alloc(i * 10 + 1);
+        assert(address[i] != NULL);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        buddy_dealloc(address[ARRAY_SIZE(address) - i - 1]);
+    }
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_free_blocks == 1 && stats.size_of_largest_free_block == MEMORY_SIZE);
+
+    /* allocate blocks in increasing order and then deallocate even and odd ones */
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = buddy_alloc(i * 10 + 1);
+        assert(address[i] != NULL);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); i += 2)
+    {
+        buddy_dealloc(address[i]);
+    }
+
+    for (size_t i = 1; i < ARRAY_SIZE(address); i += 2)
+    {
+        buddy_dealloc(address[i]);
+    }
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_free_blocks == 1 && stats.size_of_largest_free_block == MEMORY_SIZE);
+}
+
+static void test_statistics(void)
+{
+    buddy_init();
+
+    Buddy_statistics stats;
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_blocks_in_use == 0 && stats.bytes_in_use == 0);
+    assert(stats.nr_of_free_blocks == 1 && stats.size_of_largest_free_block == MEMORY_SIZE);
+
+    /* the whole memory is split in halves down to the smallest block, one free block of each order is left */
+    uint8_t* const first_p = (uint8_t*)buddy_alloc(1);
+    assert(first_p == buddy_get_address_from_memory(0));
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_blocks_in_use == 1 && stats.bytes_in_use == TEST_MIN_BLOCK_SIZE);
+    assert(stats.nr_of_free_blocks == (size_t)__builtin_ctz(MEMORY_SIZE) - BUDDY_MIN_ORDER);
+    assert(stats.size_of_largest_free_block == MEMORY_SIZE / 2);
+
+    /* buddy of the first block is taken without split */
+    uint8_t* const second_p = (uint8_t*)buddy_alloc(TEST_MIN_BLOCK_SIZE);
+    assert(second_p == first_p + TEST_MIN_BLOCK_SIZE);
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_free_blocks == (size_t)__builtin_ctz(MEMORY_SIZE) - BUDDY_MIN_ORDER - 1);
+
+    /* first block can not be merged, because its buddy is allocated */
+    buddy_dealloc(first_p);
+    assert(buddy_alloc(MEMORY_SIZE / 2 + 1) == NULL);
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_blocks_in_use == 1 && stats.bytes_in_use == TEST_MIN_BLOCK_SIZE);
+    assert(stats.peak_bytes_in_use == 2 * TEST_MIN_BLOCK_SIZE);
+    assert(stats.nr_of_free_blocks == (size_t)__builtin_ctz(MEMORY_SIZE) - BUDDY_MIN_ORDER);
+    assert(stats.nr_of_allocs == 2 && stats.nr_of_frees == 1 && stats.nr_of_failures == 1);
+
+    buddy_dealloc(second_p);
+
+    buddy_read_statistics(&stats);
+    assert(stats.nr_of_blocks_in_use == 0 && stats.bytes_in_use == 0);
+    assert(stats.nr_of_free_blocks == 1 && stats.size_of_largest_free_block == MEMORY_SIZE);
+}
+
+static void test_invalid_deallocations(void)
+{
+    buddy_init();
+
+    uint8_t* const first_p = (uint8_t*)buddy_alloc(1);
+    uint8_t* const second_p = (uint8_t*)buddy_alloc(3 * TEST_MIN_BLOCK_SIZE);
+    assert(first_p != NULL && second_p != NULL);
+
+    buddy_dealloc(first_p);
+
+    Buddy_statistics expected;
+    buddy_read_statistics(&expected);
+
+    uint8_t foreign[TEST_MIN_BLOCK_SIZE];
+
+    void* const invalid[] = {
+        first_p,                                                       /* double free */
+        foreign,                                                       /* pointer out of memory */
+        (uint8_t*)buddy_get_address_from_memory(MEMORY_SIZE - 1) + 1,  /* end of memory */
+        second_p + 1,                                                  /* not aligned to the smallest block */
+        second_p + TEST_MIN_BLOCK_SIZE,                                /* inside of allocated block */
+        (uint8_t*)buddy_get_address_from_memory(MEMORY_SIZE / 2),      /* start of free block */
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(invalid); ++i)
+    {
+        buddy_dealloc(invalid[i]);
+
+        Buddy_statistics stats;
+        buddy_read_statistics(&stats);
+        assert(memcmp(&stats, &expected, sizeof(stats)) == 0);
+    }
+
+    /* free lists are not changed, so freed block is given back again and halves of memory are not merged */
+    assert(buddy_alloc(1) == first_p);
+    assert(buddy_alloc(MEMORY_SIZE / 2 + 1) == NULL);
+
+    buddy_dealloc(first_p);
+    buddy_dealloc(second_p);
+
+    buddy_read_statistics(&expected);
+    assert(expected.nr_of_blocks_in_use == 0);
+    assert(expected.nr_of_free_blocks == 1 && expected.size_of_largest_free_block == MEMORY_SIZE);
+}
+
+static void __run_workload(void* (*alloc)(const size_t), void (*dealloc)(void*))
+{
+    (void)memset(&workload, 0, sizeof(workload));
+
+    srand(1);
+
+    for (size_t i = 0; i < NR_OF_OPERATIONS; ++i)
+    {
+        const size_t slot = (size_t)rand() % NR_OF_LIVE_BLOCKS;
+        const size_t bytes = MIN_REQUEST_SIZE + (size_t)rand() % (MAX_REQUEST_SIZE - MIN_REQUEST_SIZE + 1);
+
+        if (workload.live[slot] != NULL)
+        {
+            dealloc(workload.live[slot]);
+        }
+
+        workload.live[slot] = alloc(bytes);
+        workload.requested[slot] = workload.live[slot] != NULL ? bytes : 0;
+
+        if (workload.live[slot] == NULL)
+        {
+            ++workload.nr_of_failures;
+        }
+    }
+}
+
+static void __report_workload(const char* label,
+                              const size_t bytes_in_use,
+                              const size_t size_of_largest_free_block,
+                              void (*dealloc)(void*))
+{
+    size_t requested = 0;
+
+    for (size_t i = 0; i < NR_OF_LIVE_BLOCKS; ++i)
+    {
+        requested += workload.requested[i];
+        dealloc(workload.live[i]);
+    }
+
+    const size_t size_of_free = MEMORY_SIZE - bytes_in_use;
+
+    /* internal: bytes taken over requested, external: free bytes which can not be given in one request */
+    printf("%s: requested = %zu B, in use = %zu B, internal fragmentation = %.1lf%%, "
+           "external fragmentation = %.1lf%%, failures = %zu\n",
+           label,
+           requested,
+           bytes_in_use,
+           100.0 * (double)(bytes_in_use - requested) / (double)bytes_in_use,
+           size_of_free == 0 ? 0.0 : 100.0 * (1.0 - (double)size_of_largest_free_block / (double)size_of_free),
+           workload.nr_of_failures);
+}
+
+static void benchmark_allocators(void)
+{
+    printf("ALLOCATORS, %d live blocks, %d allocations of [%d, %d] B\n",
+           NR_OF_LIVE_BLOCKS,
+           NR_OF_OPERATIONS,
+           MIN_REQUEST_SIZE,
+           MAX_REQUEST_SIZE);
+
+    buddy_init();
+    MEASURE_FUNCTION(__run_workload(buddy_alloc, buddy_dealloc), "buddy");
+
+    Buddy_statistics buddy_stats;
+    buddy_read_statistics(&buddy_stats);
+    __report_workload("buddy", buddy_stats.bytes_in_use, buddy_stats.size_of_largest_free_block, buddy_dealloc);
+
+    fsa_init();
+    MEASURE_FUNCTION(__run_workload(fsa_slab_alloc, fsa_dealloc), "fsa slab");
+
+    Fsa_statistics fsa_stats;
+    Fsa_fragmentation fsa_frag;
+    fsa_read_statistics(&fsa_stats);
+    fsa_read_fragmentation(&fsa_frag);
+    __report_workload("fsa slab", fsa_stats.bytes_in_use, fsa_frag.size_of_largest_free_extent, fsa_dealloc);
+
+    ssa_init();
+    MEASURE_FUNCTION(__run_workload(ssa_alloc, ssa_dealloc), "ssa");
+
+    Ssa_statistics ssa_stats;
+    ssa_read_statistics(&ssa_stats);
+    __report_workload("ssa", ssa_stats.bytes_in_use, ssa_stats.size_of_largest_free_chunk, ssa_dealloc);
+}
+
+/* ----------------------------------------------- MAIN FUNCTION --------------------------------------------------- */
+
+int main(void)
+{
+    test_init();
+    test_allocations();
+    test_deallocations();
+    test_statistics();
+    test_invalid_deallocations();
+
+    benchmark_allocators();
+
+    return 0;
+}
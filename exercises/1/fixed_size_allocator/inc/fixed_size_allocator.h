@@ -2,7 +2,8 @@
 #define FIXED_SIZE_ALLOCATOR_H
 
 /*
-    Implementation of fixed-size allocator using static memory.
+    Implementation of fixed-size allocator using static memory. Functions with fsa_pool_ prefix work on pools created
+    at runtime over caller-provided, mmap'ed or shared memory, other functions work on default pool over static memory.
 
     author: Kamil Kielbasa
     email: dusergithub@gmail.com
@@ -23,11 +24,343 @@
 #define PAGE_SIZE (1 << 12)
 #endif
 
+/*
+    FSA_THREAD_SAFE could be passed in compile time by -D option. Then fsa_alloc and fsa_dealloc can be called from many
+    threads without any lock, chunks are claimed and released by atomic operations on 64-bit bitmap words.
+    fsa_init is never thread safe.
+
+    FSA_THREAD_CACHE could be passed in compile time by -D option (it enables FSA_THREAD_SAFE too). Then each thread
+    keeps up to high water mark freed single chunks and serves single chunk requests from them without atomic
+    operations. Cache is refilled from bitmap and flushed to bitmap by half of high water mark chunks at once.
+
+    Pool over shared region (fsa_pool_create_shared) keeps bitmaps, slab lists, locks and counters in the region, so
+    in FSA_THREAD_SAFE build many processes can allocate and free in it at the same time: lock-free atomic operations
+    work on shared memory as well. Without FSA_THREAD_SAFE only one process can use such pool at a time.
+*/
+
+#if defined(FSA_THREAD_CACHE) && !defined(FSA_THREAD_SAFE)
+#define FSA_THREAD_SAFE
+#endif
+
+/* default capacity (and high water mark) of thread cache, could be passed in compile time by -D option */
+#ifndef FSA_CACHE_SIZE
+#define FSA_CACHE_SIZE 64
+#endif
+
+/* max number of pools (with default one) using thread caches at the same time, could be passed by -D option */
+#ifndef FSA_MAX_CACHED_POOLS
+#define FSA_MAX_CACHED_POOLS 8
+#endif
+
+/* default huge page size on x86-64 is 2MB, could be passed in compile time by -D option */
+#ifndef FSA_HUGE_PAGE_SIZE
+#define FSA_HUGE_PAGE_SIZE (1 << 21)
+#endif
+
+/*
+    Slab layer carve single chunks into slots of one size class. Size classes are powers of two from FSA_SLAB_MIN_SIZE
+    to FSA_SLAB_MAX_SIZE, but slot can not be bigger than half of chunk. Bigger requests get whole chunks.
+*/
+#define FSA_SLAB_MIN_SHIFT 3 /* 8 B */
+#define FSA_SLAB_MAX_SHIFT 11 /* 2 kB */
+#define FSA_SLAB_MIN_SIZE (1 << FSA_SLAB_MIN_SHIFT)
+#define FSA_SLAB_MAX_SIZE (1 << FSA_SLAB_MAX_SHIFT)
+#define FSA_SLAB_NR_OF_CLASSES (FSA_SLAB_MAX_SHIFT - FSA_SLAB_MIN_SHIFT + 1)
+
+/* flags for fsa_pool_create_mapped */
+#define FSA_POOL_TRANSPARENT_HUGE_PAGES (1 << 0) /* mapping aligned to huge page and advised by MADV_HUGEPAGE */
+#define FSA_POOL_EXPLICIT_HUGE_PAGES (1 << 1) /* mapping by MAP_HUGETLB, transparent huge pages if it fails */
+
 #define SIZE_OF_CHUNK PAGE_SIZE /* 4kB */
 #define BITS_IN_BYTE (1 << 3) /* 8 bits in byte */
+#define BITS_IN_WORD (1 << 6) /* 64 bits in bitmap word */
+
+/* returned by fsa_pool_get_offset for address which is not in pool */
+#define FSA_INVALID_OFFSET SIZE_MAX
+
+typedef struct Fsa_pool Fsa_pool;
+
+/*
+    Statistics of pool. Counters are updated by alloc and dealloc, so reading them does not walk through memory or
+    bitmap. Counts of allocations served by thread cache (FSA_THREAD_CACHE) are added to pool when cache is refilled or
+    flushed. Free blocks (number of free runs and the largest one) are not counters, they are in fragmentation report.
+*/
+struct Fsa_statistics
+{
+    size_t nr_of_chunks_in_use;
+    size_t bytes_in_use;
+    size_t peak_bytes_in_use;
+
+    size_t nr_of_allocs;
+    size_t nr_of_frees;
+    size_t nr_of_failures;
+};
+
+typedef struct Fsa_statistics Fsa_statistics;
+
+/* number of buckets in histogram of free extents, the last bucket counts also all longer extents */
+#define FSA_FRAGMENTATION_NR_OF_BUCKETS 32
+
+/*
+    Fragmentation report of pool. Extent is run of free chunks and bucket n of histogram counts extents of
+    [2^n, 2^(n + 1)) chunks, so largest request which can be served is seen without trying it. External fragmentation
+    is 1 - largest extent / free bytes: 0 if all free memory is one extent, close to 1 if it is split into small ones.
+    Internal waste is part of allocated bytes lost by rounding of requests since init or reset, to whole chunks by
+    alloc and to power of two slots by slab alloc. Chunks carved into slots are not counted as allocations.
+*/
+struct Fsa_fragmentation
+{
+    size_t free_extents[FSA_FRAGMENTATION_NR_OF_BUCKETS];
+    size_t nr_of_free_extents;
+    size_t free_bytes;
+    size_t size_of_largest_free_extent; /* in bytes */
+    double external_fragmentation; /* 0 if there is no free memory */
+
+    size_t requested_bytes;
+    size_t allocated_bytes; /* whole chunks and slots given for requested bytes */
+    double internal_waste; /* 1 - requested / allocated, 0 if nothing was allocated */
+};
+
+typedef struct Fsa_fragmentation Fsa_fragmentation;
+
+/*
+    This function create pool of chunks over memory region.
+
+    PARAMS:
+    @IN region_p - memory for allocations, if NULL then memory of @size will be mapped as by fsa_pool_create_mapped.
+    @IN size - size of region in bytes.
+    @IN chunk_size - size of one chunk in bytes, it has to be power of two.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Fsa_pool if success.
+*/
+Fsa_pool* fsa_pool_create(void* region_p, const size_t size, const size_t chunk_size);
+
+/*
+    This function create pool of chunks over anonymous mapping. Mapping is only reserved (MAP_NORESERVE), pages are
+    committed by kernel on first touch. Pages of freed runs of at least @return_threshold bytes are given back to
+    kernel by madvise(MADV_DONTNEED), so resident memory follows actual use. Such chunks are zeroed on next touch.
+
+    PARAMS:
+    @IN size - size of memory for allocations in bytes.
+    @IN chunk_size - size of one chunk in bytes, it has to be power of two.
+    @IN flags - FSA_POOL_TRANSPARENT_HUGE_PAGES, FSA_POOL_EXPLICIT_HUGE_PAGES or 0.
+    @IN return_threshold - min size of freed run in bytes given back to kernel, 0 if pages should never be given back.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Fsa_pool if success.
+*/
+Fsa_pool* fsa_pool_create_mapped(const size_t size,
+                                 const size_t chunk_size,
+                                 const unsigned int flags,
+                                 const size_t return_threshold);
+
+/*
+    This function create pool in shared memory file (memfd_create or shm_open), so it can be attached by other
+    processes and buffer can be passed between them without copy. File is resized to header, metadata and memory of
+    pool and mapped by MAP_SHARED. Each process maps file at own address, so buffers are passed as offsets (see
+    fsa_pool_get_offset), which are the same in every mapping. Shared pool does not use thread caches and does not
+    give pages back to kernel.
+
+    PARAMS:
+    @IN fd - descriptor of shared memory file opened for read and write.
+    @IN size - size of memory for allocations in bytes.
+    @IN chunk_size - size of one chunk in bytes, it has to be power of two.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Fsa_pool if success.
+*/
+Fsa_pool* fsa_pool_create_shared(const int fd, const size_t size, const size_t chunk_size);
+
+/*
+    This function map pool created by fsa_pool_create_shared in calling process. Header of pool is checked against
+    size of file, so file without ready pool is rejected.
+
+    PARAMS:
+    @IN fd - descriptor of shared memory file opened for read and write.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Fsa_pool if success.
+*/
+Fsa_pool* fsa_pool_attach_shared(const int fd);
+
+/*
+    This function destroy pool created by fsa_pool_create or fsa_pool_create_mapped, or mapping of shared pool. Mapped
+    memory is unmapped, caller-provided memory and shared memory file are not touched.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_destroy(Fsa_pool* pool_p);
+
+/*
+    This function free all chunks of pool, the same as fsa_init does for default pool.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_reset(Fsa_pool* pool_p);
+
+/*
+    This function take all slab locks of pool, so no other thread is inside of slab alloc or dealloc of pool until
+    fsa_pool_unlock. It is for fork handlers: child has got only the thread which called fork, so lock held by another
+    thread would be never released in child. Bitmap is lock free and it is not locked. Without FSA_THREAD_SAFE it
+    does nothing.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_lock(Fsa_pool* pool_p);
+
+/*
+    This function release all slab locks of pool taken by fsa_pool_lock, it could be called also in child after fork.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_unlock(Fsa_pool* pool_p);
+
+/*
+    This function allocate contiguous chunks from pool, the same as fsa_alloc does for default pool.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* fsa_pool_alloc(Fsa_pool* pool_p, const size_t bytes);
+
+/*
+    This function allocate slot of the smallest size class which fits @bytes from pool, the same as fsa_slab_alloc does
+    for default pool.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* fsa_pool_slab_alloc(Fsa_pool* pool_p, const size_t bytes);
+
+/*
+    This function allocate zeroed memory for array from pool, the same as fsa_calloc does for default pool.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN nr_of_members - number of members of array.
+    @IN size - size of member in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* fsa_pool_calloc(Fsa_pool* pool_p, const size_t nr_of_members, const size_t size);
 
 /*
-    This function memset memory and allocator metadata.
+    This functon free chunks (or slot) allocated from pool, the same as fsa_dealloc does for default pool.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN addr_p - pointer to memory for deallocation.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_dealloc(Fsa_pool* pool_p, void* addr_p);
+
+/*
+    This function convert address of pool memory to offset from begin of memory. Offset of shared pool is the same
+    in every process which attached it.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN addr_p - address inside memory of pool.
+
+    RETURN:
+    @FSA_INVALID_OFFSET if address is not in memory of pool.
+    @offset if success.
+*/
+size_t fsa_pool_get_offset(const Fsa_pool* pool_p, const void* addr_p);
+
+/*
+    This function convert offset returned by fsa_pool_get_offset to address in mapping of calling process.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN offset - offset from begin of memory of pool.
+
+    RETURN:
+    @NULL if offset is not in memory of pool.
+    @address if success.
+*/
+void* fsa_pool_get_address(const Fsa_pool* pool_p, const size_t offset);
+
+/*
+    This function compute how many bytes can be used under address allocated from pool: size of slot for slab
+    allocations, size of all chunks otherwise.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @IN addr_p - address returned by fsa_pool_alloc or fsa_pool_slab_alloc.
+
+    RETURN:
+    @0 if address was not allocated from pool.
+    @size in bytes if success.
+*/
+size_t fsa_pool_get_usable_size(const Fsa_pool* pool_p, const void* addr_p);
+
+/*
+    This function fill statistics of pool. It only loads counters, so its cost does not depend on size of pool and it
+    could be polled often. It does not allocate memory and does not print anything.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_read_statistics(const Fsa_pool* pool_p, Fsa_statistics* stats_p);
+
+/*
+    This function fill fragmentation report of pool. Free extents are counted by one pass through bitmap (one bit per
+    chunk, 64 chunks per step), so its cost grows with size of pool. Counters of internal waste are updated by alloc. Chunks cached by threads (FSA_THREAD_CACHE) are not free
+    and their requests are added to pool when cache is refilled or flushed.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+    @OUT frag_p - pointer to fragmentation report.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_pool_read_fragmentation(const Fsa_pool* pool_p, Fsa_fragmentation* frag_p);
+
+/*
+    This function free all chunks of default pool. Only metadata is written: bitmap and descriptors of chunks which
+    were allocated, memory of chunks is not touched (and not zeroed, see fsa_calloc). Cost does not depend on size of
+    memory, so it can be called as cheap reset.
 
     PARAMS:
     @IN - void
@@ -39,7 +372,8 @@ void fsa_init(void);
 
 /*
     This function implement simple allocator based on static memory. It is fixed-size allocator which means memory is 
-    divided in fixed size chunks (RAM pages by default).
+    divided in fixed size chunks (RAM pages by default). Any number of contiguous chunks up to size of memory can be
+    allocated.
 
     PARAMS:
     @IN bytes - requested memory size in bytes.
@@ -50,10 +384,38 @@ void fsa_init(void);
 */
 void* fsa_alloc(const size_t bytes);
 
+/*
+    This function implement slab allocator on top of chunks. Requests up to FSA_SLAB_MAX_SIZE bytes are rounded to
+    power of two size class and served from chunks carved into slots of this class, so many small objects share one
+    chunk. Bigger requests are served by fsa_alloc. Memory is given back by fsa_dealloc.
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* fsa_slab_alloc(const size_t bytes);
+
+/*
+    This function allocate memory for array by fsa_slab_alloc and zero it. Only returned bytes are zeroed, fsa_init
+    does not zero memory.
+
+    PARAMS:
+    @IN nr_of_members - number of members of array.
+    @IN size - size of member in bytes.
+
+    RETURN:
+    @NULL if failure (also if size of array overflows).
+    @address if success.
+*/
+void* fsa_calloc(const size_t nr_of_members, const size_t size);
+
 /*
     This functon implement freeing memory. Function is responsible for get information about number of allocated chunks 
     under this address and set this value to zero. Then number of allocated bits will be set to zero started by given
-    address.
+    address. Slots allocated by fsa_slab_alloc go back to their chunk.
 
     PARAMS:
     @IN addr_p - pointer to memory for deallocation.
@@ -64,11 +426,76 @@ void* fsa_alloc(const size_t bytes);
 void fsa_dealloc(void* addr_p);
 
 /*
-    This function is responsible for print the following infromations to stdio:
-    -number of allocated chunks
-    -size of each allocated chunk
-    -number of free chunks
-    -size of each free chunk
+    This function compute how many bytes can be used under address allocated from default pool, the same as
+    fsa_pool_get_usable_size does.
+
+    PARAMS:
+    @IN addr_p - address returned by fsa_alloc or fsa_slab_alloc.
+
+    RETURN:
+    @0 if address was not allocated from default pool.
+    @size in bytes if success.
+*/
+size_t fsa_get_usable_size(const void* addr_p);
+
+/*
+    This function set high water mark of calling thread cache. If cache keeps more chunks, the oldest are given back to
+    bitmap. Zero disables cache for calling thread. Without FSA_THREAD_CACHE it does nothing.
+
+    PARAMS:
+    @IN high_water_mark - max number of cached chunks (not bigger than FSA_CACHE_SIZE).
+
+    RETURN:
+    This is void function.
+*/
+void fsa_cache_set_high_water_mark(const size_t high_water_mark);
+
+/*
+    This function give back all chunks cached by calling thread to bitmap. Without FSA_THREAD_CACHE it does nothing.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void fsa_cache_flush(void);
+
+/*
+    This function take all slab locks of default pool, the same as fsa_pool_lock does.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void fsa_lock(void);
+
+/*
+    This function release all slab locks of default pool, the same as fsa_pool_unlock does.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void fsa_unlock(void);
+
+/*
+    This function fill statistics of default pool, the same as fsa_pool_read_statistics does.
+
+    PARAMS:
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_read_statistics(Fsa_statistics* stats_p);
+
+/*
+    This function is responsible for print statistics of default pool (see fsa_read_statistics) to stdio.
 
     PARAMS:
     @IN - void
@@ -78,6 +505,29 @@ void fsa_dealloc(void* addr_p);
 */
 void fsa_get_statistics(void);
 
+/*
+    This function fill fragmentation report of default pool, the same as fsa_pool_read_fragmentation does.
+
+    PARAMS:
+    @OUT frag_p - pointer to fragmentation report.
+
+    RETURN:
+    This is void function.
+*/
+void fsa_read_fragmentation(Fsa_fragmentation* frag_p);
+
+/*
+    This function is responsible for print fragmentation report of default pool (see fsa_read_fragmentation) to
+    stdio. Only not empty buckets of histogram are printed.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void fsa_get_fragmentation(void);
+
 /*
     Getter for size of memory array.
 
@@ -112,7 +562,8 @@ void* fsa_get_address_from_memory(const size_t index);
 size_t fsa_get_size_of_available_chunks(void);
 
 /*
-    Getter for member of available chunks.
+    Getter for member of available chunks. Bitmap is kept in 64-bit words, this getter return byte view of it, so
+    byte n keep informations about chunks n * 8 .. n * 8 + 7.
 
     PARAMS:
     @IN - index of array.
@@ -142,6 +593,6 @@ size_t fsa_get_size_of_number_of_chunks(void);
     RETURN:
     Number of chunks.
 */
-uint8_t fsa_get_number_of_chunks(const size_t index);
+size_t fsa_get_number_of_chunks(const size_t index);
 
 #endif /* FIXED_SIZE_ALLOCATOR_H */
\ No newline at end of file
@@ -0,0 +1,144 @@
+#ifndef FSA_POOL_GENERATOR_H
+#define FSA_POOL_GENERATOR_H
+
+/*
+    Generator of fixed-size pools specialized in compile time. Geometry of pool from fixed_size_allocator.c is kept in
+    runtime fields (chunk shift, number of words), DEFINE_FSA_POOL(name, chunk_size, chunk_count) emits pool with
+    static memory where all of them are constants: division by chunk size is folded to shift, word and bit of chunk
+    are taken by constant shift and mask, and loops over summary words are unrolled. Each subsystem can have own pool
+    for its objects without any pointer to descriptor.
+
+    Pool serves one chunk per allocation. Bitmap has the same two levels as fsa: leaf bit n is set if chunk n is
+    allocated and summary bit n is set if leaf word n is full, so zeroed (static) bitmap is empty pool and pool does
+    not need any init. Generated functions are static inline:
+
+    void* name_alloc(void) - lowest free chunk, NULL if pool is full.
+    void name_free(void* addr_p) - NULL, address outside of pool, not aligned address or free chunk is ignored.
+    bool name_owns(const void* addr_p) - true if address is inside memory of pool.
+    size_t name_get_nr_of_chunks_in_use(void) - number of allocated chunks.
+    void name_reset(void) - free all chunks, only bitmap is cleared.
+
+    Pool is not thread safe. It has to be defined once in translation unit which uses it, at file scope and with
+    semicolon after macro, for example: DEFINE_FSA_POOL(node_pool, 64, 1024);
+
+    author: Kamil Kielbasa
+    email: dusergithub@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <fixed_size_allocator.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* number of leaf words of pool with @chunk_count chunks */
+#define FSA_POOL_NR_OF_WORDS(chunk_count) (((chunk_count) + BITS_IN_WORD - 1) / BITS_IN_WORD)
+
+/* number of summary words of pool with @chunk_count chunks */
+#define FSA_POOL_NR_OF_SUMMARY_WORDS(chunk_count) \
+    ((FSA_POOL_NR_OF_WORDS(chunk_count) + BITS_IN_WORD - 1) / BITS_IN_WORD)
+
+/*
+    Invalid geometry gives array of negative size, so it is rejected in compile time also in C99. Chunk is aligned to
+    its size, so it has to be power of two which can keep pointer.
+*/
+#define DEFINE_FSA_POOL(name, chunk_size, chunk_count)                                                              \
+    typedef char name##_chunk_size_has_to_be_power_of_two[                                                         \
+        ((chunk_size) & ((chunk_size) - 1)) == 0 && (chunk_size) >= sizeof(void*) ? 1 : -1];                        \
+                                                                                                                    \
+    static uint8_t name##_memory[(size_t)(chunk_size) * (size_t)(chunk_count)] __attribute__((aligned(chunk_size))); \
+                                                                                                                    \
+    static struct                                                                                                   \
+    {                                                                                                               \
+        uint64_t allocated_chunks[FSA_POOL_NR_OF_WORDS(chunk_count)];                                               \
+        uint64_t full_words[FSA_POOL_NR_OF_SUMMARY_WORDS(chunk_count)];                                             \
+        size_t nr_of_chunks_in_use;                                                                                 \
+    } name##_bitmap;                                                                                                \
+                                                                                                                    \
+    static inline void* name##_alloc(void)                                                                          \
+    {                                                                                                               \
+        for (size_t i = 0; i < FSA_POOL_NR_OF_SUMMARY_WORDS(chunk_count); ++i)                                      \
+        {                                                                                                           \
+            const uint64_t full_words = name##_bitmap.full_words[i];                                                \
+                                                                                                                    \
+            if (__builtin_expect(full_words == ~(uint64_t)0, 0))                                                    \
+            {                                                                                                       \
+                continue;                                                                                           \
+            }                                                                                                       \
+                                                                                                                    \
+            /* bits after the last word (and after the last chunk) look free, all chunks before them are taken */   \
+            const size_t word = i * BITS_IN_WORD + (size_t)__builtin_ctzll(~full_words);                            \
+                                                                                                                    \
+            if (word >= FSA_POOL_NR_OF_WORDS(chunk_count))                                                          \
+            {                                                                                                       \
+                return NULL;                                                                                        \
+            }                                                                                                       \
+                                                                                                                    \
+            const uint64_t chunks = name##_bitmap.allocated_chunks[word];                                           \
+            const size_t index = word * BITS_IN_WORD + (size_t)__builtin_ctzll(~chunks);                            \
+                                                                                                                    \
+            if ((chunk_count) % BITS_IN_WORD != 0 && index >= (chunk_count))                                        \
+            {                                                                                                       \
+                return NULL;                                                                                        \
+            }                                                                                                       \
+                                                                                                                    \
+            const uint64_t new_chunks = chunks | (chunks + 1);                                                      \
+            name##_bitmap.allocated_chunks[word] = new_chunks;                                                      \
+                                                                                                                    \
+            if (new_chunks == ~(uint64_t)0)                                                                         \
+            {                                                                                                       \
+                name##_bitmap.full_words[i] = full_words | ((uint64_t)1 << (word % BITS_IN_WORD));                  \
+            }                                                                                                       \
+                                                                                                                    \
+            ++name##_bitmap.nr_of_chunks_in_use;                                                                    \
+                                                                                                                    \
+            return &name##_memory[index * (size_t)(chunk_size)];                                                    \
+        }                                                                                                           \
+                                                                                                                    \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline void name##_free(void* addr_p)                                                                    \
+    {                                                                                                               \
+        /* NULL and address before memory wrap around to big offset */                                            \
+        const size_t offset = (size_t)((uintptr_t)addr_p - (uintptr_t)&name##_memory[0]);                           \
+                                                                                                                    \
+        if (offset >= sizeof(name##_memory) || offset % (chunk_size) != 0)                                          \
+        {                                                                                                           \
+            return;                                                                                                 \
+        }                                                                                                           \
+                                                                                                                    \
+        const size_t index = offset / (chunk_size);                                                                 \
+        const size_t word = index / BITS_IN_WORD;                                                                   \
+        const uint64_t mask = (uint64_t)1 << (index % BITS_IN_WORD);                                                \
+                                                                                                                    \
+        if ((name##_bitmap.allocated_chunks[word] & mask) == 0)                                                     \
+        {                                                                                                           \
+            return;                                                                                                 \
+        }                                                                                                           \
+                                                                                                                    \
+        name##_bitmap.allocated_chunks[word] &= ~mask;                                                              \
+        name##_bitmap.full_words[word / BITS_IN_WORD] &= ~((uint64_t)1 << (word % BITS_IN_WORD));                   \
+        --name##_bitmap.nr_of_chunks_in_use;                                                                        \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline bool name##_owns(const void* addr_p)                                                              \
+    {                                                                                                               \
+        return (size_t)((uintptr_t)addr_p - (uintptr_t)&name##_memory[0]) < sizeof(name##_memory);                 \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline size_t name##_get_nr_of_chunks_in_use(void)                                                       \
+    {                                                                                                               \
+        return name##_bitmap.nr_of_chunks_in_use;                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    static inline void name##_reset(void)                                                                           \
+    {                                                                                                               \
+        (void)memset(&name##_bitmap, 0, sizeof(name##_bitmap));                                                     \
+    }                                                                                                               \
+                                                                                                                    \
+    typedef char name##_chunk_count_can_not_be_zero[(chunk_count) > 0 ? 1 : -1]
+
+#endif /* FSA_POOL_GENERATOR_H */
@@ -5,324 +5,2204 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef FSA_THREAD_CACHE
+#include <pthread.h>
+#endif
+
+#ifdef FSA_THREAD_SAFE
+#include <sched.h>
+#endif
 
 /* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
 
-/* macro for calculating size of arrays allocated on stack */
-#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* number of chunks (pages) managed by default pool */
+#define NR_OF_CHUNKS (MEMORY_SIZE / SIZE_OF_CHUNK)
+
+/* number of 64-bit words in leaf bitmap of default pool */
+#define NR_OF_WORDS ((NR_OF_CHUNKS + BITS_IN_WORD - 1) / BITS_IN_WORD)
+
+/* number of 64-bit words in summary bitmap of default pool */
+#define NR_OF_SUMMARY_WORDS ((NR_OF_WORDS + BITS_IN_WORD - 1) / BITS_IN_WORD)
+
+/* word with all chunks allocated */
+#define FULL_WORD (~(uint64_t)0)
+
+/* "FSA_SHM1", it marks shared region with ready metadata */
+#define FSA_SHARED_MAGIC 0x314d48535f415346ULL
+
+/* in thread safe mode bitmap words are modified only by atomic operations */
+#ifdef FSA_THREAD_SAFE
+#define WORD_LOAD(word) __atomic_load_n(&(word), __ATOMIC_RELAXED)
+#define WORD_OR(word, mask) (void)__atomic_fetch_or(&(word), mask, __ATOMIC_SEQ_CST)
+#define WORD_AND(word, mask) (void)__atomic_fetch_and(&(word), mask, __ATOMIC_SEQ_CST)
+#else
+#define WORD_LOAD(word) (word)
+#define WORD_OR(word, mask) (void)((word) |= (mask))
+#define WORD_AND(word, mask) (void)((word) &= (mask))
+#endif
+
+/* statistics counters are shared by threads in thread safe mode */
+#ifdef FSA_THREAD_SAFE
+#define STAT_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#define STAT_ADD(counter, value) __atomic_add_fetch(&(counter), value, __ATOMIC_RELAXED)
+#define STAT_SUB(counter, value) __atomic_sub_fetch(&(counter), value, __ATOMIC_RELAXED)
+#else
+#define STAT_LOAD(counter) (counter)
+#define STAT_ADD(counter, value) ((counter) += (value))
+#define STAT_SUB(counter, value) ((counter) -= (value))
+#endif
+
+/* slab lists of one size class are changed under spinlock in thread safe mode */
+#ifdef FSA_THREAD_SAFE
+#define SLAB_LOCK(lock) while (__atomic_test_and_set(&(lock), __ATOMIC_ACQUIRE)) { (void)sched_yield(); }
+#define SLAB_UNLOCK(lock) __atomic_clear(&(lock), __ATOMIC_RELEASE)
+#else
+#define SLAB_LOCK(lock) (void)(lock)
+#define SLAB_UNLOCK(lock) (void)(lock)
+#endif
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/*
+    Descriptor of chunk used by slab layer. Zeroed descriptor describes chunk which is not carved into slots. Page and
+    slot indexes are kept plus one, so 0 means end of list.
+*/
+struct Slab_page
+{
+    /* neighbours on list of partially used chunks of the same size class */
+    uint32_t next;
+    uint32_t prev;
+
+    /* size class plus one */
+    uint32_t size_class;
+    uint32_t nr_of_free_slots;
+
+    /* head of free list, each free slot keeps next one in its first 4 bytes */
+    uint32_t free_slot;
+
+    /* slots from this one to the end of chunk were never allocated */
+    uint32_t nr_of_carved_slots;
+};
+
+typedef struct Slab_page Slab_page;
+
+/*
+    Part of pool changed by alloc and dealloc besides bitmaps. Shared pool keeps it in shared region, so processes
+    take the same slab lists and locks and add to the same counters.
+*/
+struct Fsa_pool_state
+{
+    /* heads of partially used chunk lists for each size class */
+    uint32_t slab_partial[FSA_SLAB_NR_OF_CLASSES];
+    bool slab_locks[FSA_SLAB_NR_OF_CLASSES];
+
+    /* statistics counters, sizes are in chunks */
+    size_t chunks_in_use;
+    size_t peak_chunks_in_use;
+    size_t nr_of_allocs;
+    size_t nr_of_frees;
+    size_t nr_of_failures;
+
+    /* bytes requested by alloc and bytes given for them, chunks carved into slab slots are not counted */
+    size_t requested_bytes;
+    size_t allocated_bytes;
+};
+
+typedef struct Fsa_pool_state Fsa_pool_state;
+
+/*
+    Header at begin of shared region, see fsa_pool_create_shared. Metadata and memory of pool are kept at offsets from
+    begin of region, so each process builds own Fsa_pool with pointers into its mapping.
+*/
+struct Fsa_shared_header
+{
+    /* FSA_SHARED_MAGIC is written as the last one, when region is ready to attach */
+    uint64_t magic;
+    uint64_t size_of_region;
+
+    uint64_t size_of_chunk;
+    uint64_t nr_of_chunks;
+
+    /* offset of the first chunk from begin of region, it is multiple of chunk size */
+    uint64_t memory_offset;
+
+    Fsa_pool_state state;
+};
+
+typedef struct Fsa_shared_header Fsa_shared_header;
+
+struct Fsa_pool
+{
+    /* memory for allocations */
+    uint8_t* memory_p;
+    size_t size_of_memory;
+
+    /* chunk size is power of two, so chunk index is computed by shift */
+    size_t size_of_chunk;
+    size_t chunk_shift;
+
+    size_t nr_of_chunks;
+    size_t nr_of_words;
+    size_t nr_of_summary_words;
+
+    /*
+        This array (leaf level) keep informations about free or allocated chunks of memory. Chunk n is described by
+        bit (n % BITS_IN_WORD) of word (n / BITS_IN_WORD).
+        1* - 0 = free chunk of memory;
+        2* - 1 = allocated chunk of memory
+    */
+    uint64_t* available_chunks_p;
+
+    /*
+        This array (summary level) keep informations about words in available_chunks_p. Word n is described by bit
+        (n % BITS_IN_WORD) of word (n / BITS_IN_WORD).
+        1* - 0 = all chunks in word are allocated;
+        2* - 1 = at least one chunk in word is free
+    */
+    uint64_t* free_words_p;
+
+    /* This array keey information about number of allocated chunks, value is saved under index of first chunk */
+    uint32_t* number_of_chunks_p;
+
+    /* slab descriptor of each chunk */
+    Slab_page* slab_pages_p;
+
+    /* slab lists and counters, state of shared pool is in shared region, private pool points to own one */
+    Fsa_pool_state* state_p;
+    Fsa_pool_state state;
+
+    /* memory was mapped by fsa_pool_create_mapped or attached shared region, fsa_pool_destroy unmaps it */
+    bool is_mapped;
+    uint8_t* mapping_p;
+    size_t size_of_mapping;
+
+    /* freed runs of at least return_threshold chunks are given back to kernel, 0 = never */
+    size_t return_threshold;
+    size_t size_of_page;
+
+#ifdef FSA_THREAD_CACHE
+    /* index of thread cache used for this pool, FSA_MAX_CACHED_POOLS if pool is not cached */
+    size_t cache_index;
+
+    /* thread caches filled before last reset of pool are not valid, their chunks are free again */
+    size_t generation;
+#endif
+};
+
+#ifdef FSA_THREAD_CACHE
+
+/*
+    Cache of single chunks of one pool owned by one thread. Chunks inside cache are still marked as allocated in
+    bitmap, but number_of_chunks is zero for them. Stack top is at chunks[nr_of_chunks - 1].
+*/
+struct Thread_cache
+{
+    size_t generation;
+    size_t nr_of_chunks;
+
+    /* allocations and deallocations served by cache which are not added to pool statistics yet */
+    size_t nr_of_allocs;
+    size_t nr_of_frees;
+    size_t requested_bytes;
+    size_t allocated_bytes;
+
+    uint32_t chunks[FSA_CACHE_SIZE];
+};
+
+typedef struct Thread_cache Thread_cache;
+
+#endif
+
+/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+
+/* memory for allocations of default pool, aligned as chunks of mapped pools are */
+static uint8_t memory[MEMORY_SIZE] __attribute__((aligned(SIZE_OF_CHUNK)));
+
+/* bitmaps and metadata of default pool */
+static uint64_t available_chunks[NR_OF_WORDS];
+static uint64_t free_words[NR_OF_SUMMARY_WORDS];
+static uint32_t number_of_chunks[NR_OF_CHUNKS];
+static Slab_page slab_pages[NR_OF_CHUNKS];
+
+/* pool used by fsa_init, fsa_alloc, fsa_dealloc and getters */
+static Fsa_pool default_pool =
+{
+    .memory_p = &memory[0],
+    .size_of_memory = sizeof(memory),
+    .size_of_chunk = SIZE_OF_CHUNK,
+    .chunk_shift = (size_t)__builtin_ctz(SIZE_OF_CHUNK),
+    .nr_of_chunks = NR_OF_CHUNKS,
+    .nr_of_words = NR_OF_WORDS,
+    .nr_of_summary_words = NR_OF_SUMMARY_WORDS,
+    .available_chunks_p = &available_chunks[0],
+    .free_words_p = &free_words[0],
+    .number_of_chunks_p = &number_of_chunks[0],
+    .slab_pages_p = &slab_pages[0],
+    .state_p = &default_pool.state,
+    .state = {{0}, {false}, 0, 0, 0, 0, 0, 0, 0},
+    .is_mapped = false,
+    .mapping_p = NULL,
+    .size_of_mapping = 0,
+    .return_threshold = 0,
+    .size_of_page = 0,
+#ifdef FSA_THREAD_CACHE
+    .cache_index = 0,
+    .generation = 0,
+#endif
+};
+
+#ifdef FSA_THREAD_CACHE
+
+/* source of unique pool generations */
+static size_t cache_generation = 0;
+
+/* pools which own thread cache slots, slot 0 belongs to default pool */
+static Fsa_pool* cached_pools[FSA_MAX_CACHED_POOLS] = {&default_pool};
+
+/* key used to give back cached chunks to bitmap when thread exits */
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+/* caches of calling thread, one per cached pool */
+static __thread Thread_cache thread_caches[FSA_MAX_CACHED_POOLS];
+static __thread bool is_cache_registered = false;
+static __thread size_t cache_high_water_mark = FSA_CACHE_SIZE;
+
+#endif
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+	This function add allocations to statistics of pool and update peak of used chunks.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN nr_of_allocs - number of allocations.
+	@IN nr_of_chunks - number of allocated chunks.
+
+	RETURN:
+	This is void function.
+*/
+static inline void __statistics_alloc(Fsa_pool* const pool_p, const size_t nr_of_allocs, const size_t nr_of_chunks);
+
+/*
+	This function add deallocations to statistics of pool.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN nr_of_frees - number of deallocations.
+	@IN nr_of_chunks - number of freed chunks.
+
+	RETURN:
+	This is void function.
+*/
+static inline void __statistics_dealloc(Fsa_pool* const pool_p, const size_t nr_of_frees, const size_t nr_of_chunks);
+
+/*
+	This function add requested bytes and bytes given for them to counters of internal waste.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN requested_bytes - bytes requested by caller.
+	@IN allocated_bytes - bytes of chunks or slots given for request.
+
+	RETURN:
+	This is void function.
+*/
+static inline void __statistics_request(Fsa_pool* const pool_p,
+										const size_t requested_bytes,
+										const size_t allocated_bytes);
+
+/*
+	This function compute bucket of free extents histogram for run of chunks.
+
+	PARAMS:
+	@IN run - number of chunks in run, bigger than zero.
+
+	RETURN:
+	Index of bucket, floor(log2(run)) limited to the last bucket.
+*/
+static inline size_t __extent_bucket(const size_t run);
+
+/*
+	This function count runs of free chunks in bitmap and find the longest one.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@OUT free_extents_p - histogram of runs with FSA_FRAGMENTATION_NR_OF_BUCKETS buckets, NULL if not needed.
+	@OUT nr_of_free_blocks_p - number of free runs.
+	@OUT nr_of_free_chunks_p - number of free chunks.
+	@OUT largest_free_block_p - number of chunks in the longest free run.
+
+	RETURN:
+	This is void function.
+*/
+static void __bitmap_get_free_blocks(const Fsa_pool* const pool_p,
+									 size_t* const free_extents_p,
+									 size_t* const nr_of_free_blocks_p,
+									 size_t* const nr_of_free_chunks_p,
+									 size_t* const largest_free_block_p);
+
+/*
+	This function create pool structure with metadata over @region_p.
+
+	PARAMS:
+	@IN region_p - memory for allocations.
+	@IN size - size of region in bytes.
+	@IN chunk_size - size of one chunk in bytes.
+
+	RETURN:
+	@NULL if failure.
+	@Pointer to Fsa_pool if success.
+*/
+static Fsa_pool* __pool_create(void* const region_p, const size_t size, const size_t chunk_size);
+
+/*
+	This function compute size of bitmaps and chunk descriptors of pool.
+
+	PARAMS:
+	@IN nr_of_chunks - number of chunks.
+
+	RETURN:
+	Size of metadata in bytes.
+*/
+static size_t __pool_get_size_of_metadata(const size_t nr_of_chunks);
+
+/*
+	This function fill geometry of pool and place its metadata arrays one after another in @metadata_p.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN memory_p - memory for allocations.
+	@IN nr_of_chunks - number of chunks.
+	@IN chunk_shift - log2 of chunk size.
+	@IN metadata_p - memory for metadata (__pool_get_size_of_metadata bytes), aligned to 8.
+
+	RETURN:
+	This is void function.
+*/
+static void __pool_set_layout(Fsa_pool* const pool_p,
+							  uint8_t* const memory_p,
+							  const size_t nr_of_chunks,
+							  const size_t chunk_shift,
+							  uint8_t* const metadata_p);
+
+/*
+	This function create descriptor of process for mapped shared region. Metadata and state of pool stay in region,
+	descriptor keeps only pointers into this mapping.
+
+	PARAMS:
+	@IN header_p - begin of mapped region with filled geometry.
+
+	RETURN:
+	@NULL if failure.
+	@Pointer to Fsa_pool if success.
+*/
+static Fsa_pool* __pool_create_shared_descriptor(Fsa_shared_header* const header_p);
+
+/*
+	This function map anonymous memory aligned to @alignment. Memory is only reserved, pages are committed by kernel
+	when they are touched for the first time.
+
+	PARAMS:
+	@IN size - size of mapping in bytes.
+	@IN alignment - alignment of mapping (power of two, at least system page size).
+	@IN flags - additional flags for mmap.
+
+	RETURN:
+	@MAP_FAILED if failure.
+	@address if success.
+*/
+static void* __map_aligned(const size_t size, const size_t alignment, const int flags);
+
+/*
+	This function give back pages of run to kernel if run is long enough. It has to be called before run is marked as
+	free, so no one else can use these chunks in the meantime.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN index - index of first chunk.
+	@IN nr_of_chunks - number of chunks.
+
+	RETURN:
+	This is void function.
+*/
+static void __pool_return_pages(const Fsa_pool* const pool_p, const size_t index, const size_t nr_of_chunks);
+
+/*
+	This function set metadata of pool as after init, all chunks are free. Memory of chunks is not touched and only
+	descriptors of allocated chunks are cleared (free chunk has never got number of chunks or size class), so cost
+	does not depend on size of memory, only on size of bitmap (one bit per chunk) and number of allocated chunks.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+
+	RETURN:
+	This is void function.
+*/
+static void __pool_reset(Fsa_pool* const pool_p);
+
+/*
+	This function is looking for runs of free bits inside one word.
+
+	PARAMS:
+	@IN word - word from leaf bitmap.
+	@IN req_chunks - requested length of run (1 - BITS_IN_WORD).
+
+	RETURN:
+	Mask where bit n is set if bits n .. n + req_chunks - 1 are free in @word.
+*/
+static inline uint64_t __word_find_free_run(const uint64_t word, const size_t req_chunks);
+
+/*
+	This function is looking for first free chunk. First word with free chunk is taken from summary bitmap.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+
+	RETURN:
+	Index of chunk if success.
+	Number of chunks in pool if failure.
+*/
+static inline size_t __bitmap_find_free_chunk(const Fsa_pool* const pool_p);
+
+/*
+	This function is looking for first (lowest address) run of free chunks. Only words marked in summary bitmap are
+	visited, so full words are skipped 64 at once. Runs longer than word are counted through neighbour empty words.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN req_chunks - requested number of chunks.
+
+	RETURN:
+	Index of first chunk in run if success.
+	Number of chunks in pool if failure.
+*/
+static size_t __bitmap_find_free_run(const Fsa_pool* const pool_p, const size_t req_chunks);
+
+/*
+	This function mark chunks in one word as allocated. In thread safe mode chunks are claimed by compare and swap,
+	so only one thread can get them.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN word_index - index of word in leaf bitmap.
+	@IN mask - chunks to claim.
+
+	RETURN:
+	true if all chunks from @mask were free and now are allocated.
+	false if at least one chunk from @mask is already allocated.
+*/
+static inline bool __word_claim(Fsa_pool* const pool_p, const size_t word_index, const uint64_t mask);
+
+/*
+	This function mark chunks in one word as free and set word in summary bitmap.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN word_index - index of word in leaf bitmap.
+	@IN mask - chunks to release.
+
+	RETURN:
+	This is void function.
+*/
+static inline void __word_release(Fsa_pool* const pool_p, const size_t word_index, const uint64_t mask);
+
+/*
+	This function mark chunks as allocated in leaf bitmap and update summary bitmap. If another thread was faster and
+	took some of chunks, already claimed chunks are released.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN index - index of first chunk.
+	@IN nr_of_chunks - number of chunks.
+
+	RETURN:
+	true if all chunks are allocated by caller.
+	false if failure.
+*/
+static bool __bitmap_set(Fsa_pool* const pool_p, const size_t index, const size_t nr_of_chunks);
+
+/*
+	This function mark chunks as free in leaf bitmap and update summary bitmap.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN index - index of first chunk.
+	@IN nr_of_chunks - number of chunks.
+
+	RETURN:
+	This is void function.
+*/
+static void __bitmap_clear(Fsa_pool* const pool_p, const size_t index, const size_t nr_of_chunks);
+
+/*
+	This function compute size class of slab for @bytes.
+
+	PARAMS:
+	@IN bytes - requested memory size in bytes (not bigger than FSA_SLAB_MAX_SIZE).
+
+	RETURN:
+	Index of size class, slot size is 1 << (index + FSA_SLAB_MIN_SHIFT).
+*/
+static inline size_t __slab_class(const size_t bytes);
+
+/*
+	This function add chunk to list of partially used chunks of size class.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN size_class - index of size class.
+	@IN page - index of chunk.
+
+	RETURN:
+	This is void function.
+*/
+static void __slab_list_push(Fsa_pool* const pool_p, const size_t size_class, const size_t page);
+
+/*
+	This function remove chunk from list of partially used chunks of size class.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN size_class - index of size class.
+	@IN page - index of chunk.
+
+	RETURN:
+	This is void function.
+*/
+static void __slab_list_remove(Fsa_pool* const pool_p, const size_t size_class, const size_t page);
+
+/*
+	This function take slot of size class from the first partially used chunk. New chunk is carved if list is empty.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN size_class - index of size class.
+
+	RETURN:
+	@NULL if failure.
+	@address if success.
+*/
+static void* __slab_alloc(Fsa_pool* const pool_p, const size_t size_class);
+
+/*
+	This function allocate run of chunks for @bytes, it is body of fsa_pool_alloc.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN bytes - requested memory size in bytes.
+	@IN is_request - false for chunk carved into slab slots, it is not counted in internal waste.
+
+	RETURN:
+	@NULL if failure.
+	@address if success.
+*/
+static void* __pool_alloc(Fsa_pool* const pool_p, const size_t bytes, const bool is_request);
+
+/*
+	This function give back slot to its chunk. Empty chunk is given back to pool, if it is not the last partially used
+	chunk of size class.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN page - index of chunk.
+	@IN addr_p - address of slot.
+
+	RETURN:
+	This is void function.
+*/
+static void __slab_dealloc(Fsa_pool* const pool_p, const size_t page, uint8_t* const addr_p);
+
+#ifdef FSA_THREAD_CACHE
+
+/*
+	This function claim up to @nr_of_chunks single chunks from bitmap. All free chunks from one word are claimed by one
+	compare and swap.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@OUT chunks_p - array for indexes of claimed chunks (in increasing order).
+	@IN nr_of_chunks - requested number of chunks.
+
+	RETURN:
+	Number of claimed chunks.
+*/
+static size_t __bitmap_claim_chunks(Fsa_pool* const pool_p, uint32_t* const chunks_p, const size_t nr_of_chunks);
+
+/*
+	This function create key for thread caches. It is called once by pthread_once.
+
+	PARAMS:
+	@IN - void
+
+	RETURN:
+	This is void function.
+*/
+static void __thread_cache_key_create(void);
+
+/*
+	This function give back all cached chunks to bitmaps of their pools when thread exits.
+
+	PARAMS:
+	@IN caches_p - pointer to thread_caches of exiting thread.
+
+	RETURN:
+	This is void function.
+*/
+static void __thread_cache_destroy(void* caches_p);
+
+/*
+	Getter for cache of calling thread for @pool_p. If cache was filled before last reset of pool it is emptied.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+
+	RETURN:
+	Pointer to Thread_cache of calling thread.
+	NULL if pool is not cached or cache is disabled for calling thread.
+*/
+static inline Thread_cache* __thread_cache_get(const Fsa_pool* const pool_p);
+
+/*
+	This function fill empty cache with half of high water mark chunks.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN cache_p - pointer to Thread_cache.
+
+	RETURN:
+	This is void function.
+*/
+static void __thread_cache_refill(Fsa_pool* const pool_p, Thread_cache* const cache_p);
+
+/*
+	This function give back @nr_of_chunks the oldest chunks from cache to bitmap.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN cache_p - pointer to Thread_cache.
+	@IN nr_of_chunks - number of chunks to give back.
+
+	RETURN:
+	This is void function.
+*/
+static void __thread_cache_flush(Fsa_pool* const pool_p, Thread_cache* const cache_p, const size_t nr_of_chunks);
+
+/*
+	This function add allocations and deallocations served by thread cache to statistics of pool.
+
+	PARAMS:
+	@IN pool_p - pointer to pool.
+	@IN cache_p - pointer to Thread_cache.
+
+	RETURN:
+	This is void function.
+*/
+static void __thread_cache_publish(Fsa_pool* const pool_p, Thread_cache* const cache_p);
+
+/*
+	This function trim all valid caches of calling thread to @high_water_mark chunks.
+
+	PARAMS:
+	@IN caches_p - pointer to thread_caches.
+	@IN high_water_mark - number of chunks left in each cache.
+
+	RETURN:
+	This is void function.
+*/
+static void __thread_caches_trim(Thread_cache* const caches_p, const size_t high_water_mark);
+
+#endif
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline void __statistics_alloc(Fsa_pool* const pool_p, const size_t nr_of_allocs, const size_t nr_of_chunks)
+{
+	(void)STAT_ADD(pool_p->state_p->nr_of_allocs, nr_of_allocs);
+	const size_t chunks_in_use = STAT_ADD(pool_p->state_p->chunks_in_use, nr_of_chunks);
+
+#ifdef FSA_THREAD_SAFE
+	size_t peak = __atomic_load_n(&pool_p->state_p->peak_chunks_in_use, __ATOMIC_RELAXED);
+
+	while (chunks_in_use > peak &&
+		   !__atomic_compare_exchange_n(&pool_p->state_p->peak_chunks_in_use, &peak, chunks_in_use, true,
+										__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	{
+	}
+#else
+	if (chunks_in_use > pool_p->state_p->peak_chunks_in_use)
+	{
+		pool_p->state_p->peak_chunks_in_use = chunks_in_use;
+	}
+#endif
+}
+
+static inline void __statistics_dealloc(Fsa_pool* const pool_p, const size_t nr_of_frees, const size_t nr_of_chunks)
+{
+	(void)STAT_ADD(pool_p->state_p->nr_of_frees, nr_of_frees);
+	(void)STAT_SUB(pool_p->state_p->chunks_in_use, nr_of_chunks);
+}
+
+static inline void __statistics_request(Fsa_pool* const pool_p,
+										const size_t requested_bytes,
+										const size_t allocated_bytes)
+{
+	(void)STAT_ADD(pool_p->state_p->requested_bytes, requested_bytes);
+	(void)STAT_ADD(pool_p->state_p->allocated_bytes, allocated_bytes);
+}
+
+static inline size_t __extent_bucket(const size_t run)
+{
+	const size_t bucket = (size_t)(63 - __builtin_clzll((unsigned long long)run));
+
+	return bucket < FSA_FRAGMENTATION_NR_OF_BUCKETS ? bucket : FSA_FRAGMENTATION_NR_OF_BUCKETS - 1;
+}
+
+static void __bitmap_get_free_blocks(const Fsa_pool* const pool_p,
+									 size_t* const free_extents_p,
+									 size_t* const nr_of_free_blocks_p,
+									 size_t* const nr_of_free_chunks_p,
+									 size_t* const largest_free_block_p)
+{
+	size_t nr_of_free_blocks = 0;
+	size_t nr_of_free_chunks = 0;
+	size_t largest_free_block = 0;
+
+	/* length of free run which is still open at the end of previous word */
+	size_t run = 0;
+
+	for (size_t i = 0; i < pool_p->nr_of_words; ++i)
+	{
+		const uint64_t free_chunks = ~WORD_LOAD(pool_p->available_chunks_p[i]);
+		size_t bit = 0;
+
+		/* go through word run by run, chunks behind the end of memory are allocated so they close the last run */
+		while (bit < BITS_IN_WORD)
+		{
+			const uint64_t rest = free_chunks >> bit;
+			const size_t allocated = rest == 0 ? BITS_IN_WORD - bit : (size_t)__builtin_ctzll(rest);
+
+			if (allocated > 0)
+			{
+				if (run > 0)
+				{
+					++nr_of_free_blocks;
+					nr_of_free_chunks += run;
+					largest_free_block = run > largest_free_block ? run : largest_free_block;
+
+					if (free_extents_p != NULL)
+					{
+						++free_extents_p[__extent_bucket(run)];
+					}
+
+					run = 0;
+				}
+
+				bit += allocated;
+				continue;
+			}
+
+			/* upper bits of shifted word are zero, so counting stops at the end of word */
+			const size_t free = rest == FULL_WORD ? BITS_IN_WORD : (size_t)__builtin_ctzll(~rest);
+
+			run += free;
+			bit += free;
+		}
+	}
+
+	if (run > 0)
+	{
+		++nr_of_free_blocks;
+		nr_of_free_chunks += run;
+		largest_free_block = run > largest_free_block ? run : largest_free_block;
+
+		if (free_extents_p != NULL)
+		{
+			++free_extents_p[__extent_bucket(run)];
+		}
+	}
+
+	*nr_of_free_blocks_p = nr_of_free_blocks;
+	*nr_of_free_chunks_p = nr_of_free_chunks;
+	*largest_free_block_p = largest_free_block;
+}
+
+static Fsa_pool* __pool_create(void* const region_p, const size_t size, const size_t chunk_size)
+{
+	/* chunk size has to be power of two */
+	if (region_p == NULL || chunk_size == 0 || (chunk_size & (chunk_size - 1)) != 0 || size < chunk_size)
+	{
+		return NULL;
+	}
+
+	const size_t chunk_shift = (size_t)__builtin_ctzll(chunk_size);
+	const size_t nr_of_chunks = size >> chunk_shift;
+
+	if (nr_of_chunks > UINT32_MAX)
+	{
+		return NULL;
+	}
+
+	/* pool structure and all metadata are kept in one block */
+	Fsa_pool* const pool_p = (Fsa_pool*)calloc(1, sizeof(Fsa_pool) + __pool_get_size_of_metadata(nr_of_chunks));
+
+	if (pool_p == NULL)
+	{
+		return NULL;
+	}
+
+	__pool_set_layout(pool_p, (uint8_t*)region_p, nr_of_chunks, chunk_shift, (uint8_t*)(void*)(pool_p + 1));
+	pool_p->size_of_memory = size;
+	pool_p->state_p = &pool_p->state;
+
+	__pool_reset(pool_p);
+
+#ifdef FSA_THREAD_CACHE
+	/* take first free thread cache slot, without slot pool works without cache */
+	pool_p->cache_index = FSA_MAX_CACHED_POOLS;
+
+	for (size_t i = 1; i < FSA_MAX_CACHED_POOLS; ++i)
+	{
+		Fsa_pool* expected_p = NULL;
+
+		if (__atomic_compare_exchange_n(&cached_pools[i], &expected_p, pool_p, false,
+										__ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+		{
+			pool_p->cache_index = i;
+			break;
+		}
+	}
+#endif
+
+	return pool_p;
+}
+
+static size_t __pool_get_size_of_metadata(const size_t nr_of_chunks)
+{
+	const size_t nr_of_words = (nr_of_chunks + BITS_IN_WORD - 1) / BITS_IN_WORD;
+	const size_t nr_of_summary_words = (nr_of_words + BITS_IN_WORD - 1) / BITS_IN_WORD;
+
+	return (nr_of_words + nr_of_summary_words) * sizeof(uint64_t) +
+		   nr_of_chunks * (sizeof(uint32_t) + sizeof(Slab_page));
+}
+
+static void __pool_set_layout(Fsa_pool* const pool_p,
+							  uint8_t* const memory_p,
+							  const size_t nr_of_chunks,
+							  const size_t chunk_shift,
+							  uint8_t* const metadata_p)
+{
+	const size_t nr_of_words = (nr_of_chunks + BITS_IN_WORD - 1) / BITS_IN_WORD;
+	const size_t nr_of_summary_words = (nr_of_words + BITS_IN_WORD - 1) / BITS_IN_WORD;
+
+	pool_p->memory_p = memory_p;
+	pool_p->size_of_chunk = (size_t)1 << chunk_shift;
+	pool_p->chunk_shift = chunk_shift;
+	pool_p->nr_of_chunks = nr_of_chunks;
+	pool_p->nr_of_words = nr_of_words;
+	pool_p->nr_of_summary_words = nr_of_summary_words;
+	pool_p->available_chunks_p = (uint64_t*)(void*)metadata_p;
+	pool_p->free_words_p = pool_p->available_chunks_p + nr_of_words;
+	pool_p->number_of_chunks_p = (uint32_t*)(void*)(pool_p->free_words_p + nr_of_summary_words);
+	pool_p->slab_pages_p = (Slab_page*)(void*)(pool_p->number_of_chunks_p + nr_of_chunks);
+}
+
+static Fsa_pool* __pool_create_shared_descriptor(Fsa_shared_header* const header_p)
+{
+	Fsa_pool* const pool_p = (Fsa_pool*)calloc(1, sizeof(Fsa_pool));
+
+	if (pool_p == NULL)
+	{
+		return NULL;
+	}
+
+	uint8_t* const region_p = (uint8_t*)header_p;
+	const size_t nr_of_chunks = (size_t)header_p->nr_of_chunks;
+	const size_t chunk_shift = (size_t)__builtin_ctzll(header_p->size_of_chunk);
+
+	__pool_set_layout(pool_p, region_p + header_p->memory_offset, nr_of_chunks, chunk_shift,
+					  (uint8_t*)(void*)(header_p + 1));
+	pool_p->size_of_memory = nr_of_chunks << chunk_shift;
+	pool_p->state_p = &header_p->state;
+
+	pool_p->is_mapped = true;
+	pool_p->mapping_p = region_p;
+	pool_p->size_of_mapping = (size_t)header_p->size_of_region;
+
+#ifdef FSA_THREAD_CACHE
+	/* cached chunks are allocated in shared bitmap, process which exits without flush would lose them for others */
+	pool_p->cache_index = FSA_MAX_CACHED_POOLS;
+#endif
+
+	return pool_p;
+}
+
+static void* __map_aligned(const size_t size, const size_t alignment, const int flags)
+{
+	/* reserve more and cut unaligned head and tail */
+	const size_t size_of_reservation = size + alignment - (size_t)sysconf(_SC_PAGESIZE);
+	uint8_t* const reservation_p = (uint8_t*)mmap(NULL, size_of_reservation, PROT_READ | PROT_WRITE,
+												  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | flags, -1, 0);
+
+	if ((void*)reservation_p == MAP_FAILED)
+	{
+		return MAP_FAILED;
+	}
+
+	uint8_t* const address_p = (uint8_t*)(((uintptr_t)reservation_p + alignment - 1) & ~((uintptr_t)alignment - 1));
+	const size_t size_of_head = (size_t)(address_p - reservation_p);
+	const size_t size_of_tail = size_of_reservation - size_of_head - size;
+
+	if (size_of_head > 0)
+	{
+		(void)munmap(reservation_p, size_of_head);
+	}
+
+	if (size_of_tail > 0)
+	{
+		(void)munmap(address_p + size, size_of_tail);
+	}
+
+	return (void*)address_p;
+}
+
+static void __pool_return_pages(const Fsa_pool* const pool_p, const size_t index, const size_t nr_of_chunks)
+{
+	if (pool_p->return_threshold == 0 || nr_of_chunks < pool_p->return_threshold)
+	{
+		return;
+	}
+
+	/* only whole pages inside run can be given back */
+	const uintptr_t page_mask = (uintptr_t)pool_p->size_of_page - 1;
+	const uintptr_t begin = ((uintptr_t)&pool_p->memory_p[index << pool_p->chunk_shift] + page_mask) & ~page_mask;
+	const uintptr_t end = (uintptr_t)&pool_p->memory_p[(index + nr_of_chunks) << pool_p->chunk_shift] & ~page_mask;
+
+	if (end > begin)
+	{
+		(void)madvise((void*)begin, (size_t)(end - begin), MADV_DONTNEED);
+	}
+}
+
+static void __pool_reset(Fsa_pool* const pool_p)
+{
+	/* only allocated chunks (and chunks cached by threads) can have non zero descriptor */
+	for (size_t i = 0; i < pool_p->nr_of_words; ++i)
+	{
+		for (uint64_t word = pool_p->available_chunks_p[i]; word != 0; word &= word - 1)
+		{
+			const size_t index = (i * BITS_IN_WORD) + (size_t)__builtin_ctzll(word);
+
+			/* chunks behind the end of memory have not got descriptors */
+			if (index >= pool_p->nr_of_chunks)
+			{
+				break;
+			}
+
+			pool_p->number_of_chunks_p[index] = 0;
+			pool_p->slab_pages_p[index].size_class = 0;
+		}
+	}
+
+	(void)memset(pool_p->available_chunks_p, 0, pool_p->nr_of_words * sizeof(*pool_p->available_chunks_p));
+	(void)memset(pool_p->state_p->slab_partial, 0, sizeof(pool_p->state_p->slab_partial));
+	(void)memset(pool_p->state_p->slab_locks, 0, sizeof(pool_p->state_p->slab_locks));
+
+	/* chunks behind the end of memory are marked as allocated forever */
+	if (pool_p->nr_of_chunks % BITS_IN_WORD != 0)
+	{
+		pool_p->available_chunks_p[pool_p->nr_of_words - 1] = FULL_WORD << (pool_p->nr_of_chunks % BITS_IN_WORD);
+	}
+
+	/* every existing word has got at least one free chunk */
+	(void)memset(pool_p->free_words_p, 0xff, pool_p->nr_of_summary_words * sizeof(*pool_p->free_words_p));
+
+	if (pool_p->nr_of_words % BITS_IN_WORD != 0)
+	{
+		pool_p->free_words_p[pool_p->nr_of_summary_words - 1] =
+			~(FULL_WORD << (pool_p->nr_of_words % BITS_IN_WORD));
+	}
+
+	pool_p->state_p->chunks_in_use = 0;
+	pool_p->state_p->peak_chunks_in_use = 0;
+	pool_p->state_p->nr_of_allocs = 0;
+	pool_p->state_p->nr_of_frees = 0;
+	pool_p->state_p->nr_of_failures = 0;
+	pool_p->state_p->requested_bytes = 0;
+	pool_p->state_p->allocated_bytes = 0;
+
+#ifdef FSA_THREAD_CACHE
+	/* chunks cached by threads are free now */
+	pool_p->generation = __atomic_add_fetch(&cache_generation, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline uint64_t __word_find_free_run(const uint64_t word, const size_t req_chunks)
+{
+	uint64_t runs = ~word;
+
+	/* after each step bit n is set if run of @run_length free bits starts at bit n */
+	for (size_t run_length = 1; run_length < req_chunks && runs != 0;)
+	{
+		const size_t shift = run_length < req_chunks - run_length ? run_length : req_chunks - run_length;
+
+		runs &= runs >> shift;
+		run_length += shift;
+	}
+
+	return runs;
+}
+
+static inline size_t __bitmap_find_free_chunk(const Fsa_pool* const pool_p)
+{
+	for (size_t i = 0; i < pool_p->nr_of_summary_words; ++i)
+	{
+		for (uint64_t summary = WORD_LOAD(pool_p->free_words_p[i]); summary != 0; summary &= summary - 1)
+		{
+			const size_t word_index = (i * BITS_IN_WORD) + (size_t)__builtin_ctzll(summary);
+			const uint64_t word = WORD_LOAD(pool_p->available_chunks_p[word_index]);
+
+			/* summary could be not up to date in thread safe mode */
+			if (word != FULL_WORD)
+			{
+				return (word_index * BITS_IN_WORD) + (size_t)__builtin_ctzll(~word);
+			}
+		}
+	}
+
+	return pool_p->nr_of_chunks;
+}
+
+static size_t __bitmap_find_free_run(const Fsa_pool* const pool_p, const size_t req_chunks)
+{
+	/* number of free chunks at the end of previous visited word (and empty words before it) */
+	size_t tail = 0;
+	size_t prev_word = pool_p->nr_of_words;
+
+	for (size_t i = 0; i < pool_p->nr_of_summary_words; ++i)
+	{
+		for (uint64_t summary = WORD_LOAD(pool_p->free_words_p[i]); summary != 0; summary &= summary - 1)
+		{
+			const size_t word_index = (i * BITS_IN_WORD) + (size_t)__builtin_ctzll(summary);
+			const uint64_t word = WORD_LOAD(pool_p->available_chunks_p[word_index]);
+
+			/* previous word was full, so nothing from it can be joined with this word */
+			if (word_index != prev_word + 1)
+			{
+				tail = 0;
+			}
+
+			/* take a look between two words, run starts in previous word */
+			if (tail > 0)
+			{
+				const size_t head = word == 0 ? BITS_IN_WORD : (size_t)__builtin_ctzll(word);
+
+				if (tail + head >= req_chunks)
+				{
+					return (word_index * BITS_IN_WORD) - tail;
+				}
+			}
+
+			/* take a look inside word */
+			if (req_chunks <= BITS_IN_WORD)
+			{
+				const uint64_t runs = __word_find_free_run(word, req_chunks);
+
+				if (runs != 0)
+				{
+					return (word_index * BITS_IN_WORD) + (size_t)__builtin_ctzll(runs);
+				}
+			}
+
+			tail = word == 0 ? tail + BITS_IN_WORD : (size_t)__builtin_clzll(word);
+			prev_word = word_index;
+		}
+	}
+
+	return pool_p->nr_of_chunks;
+}
+
+static inline bool __word_claim(Fsa_pool* const pool_p, const size_t word_index, const uint64_t mask)
+{
+	uint64_t* const word_p = &pool_p->available_chunks_p[word_index];
+	uint64_t* const summary_p = &pool_p->free_words_p[word_index / BITS_IN_WORD];
+	const uint64_t summary_mask = (uint64_t)1 << (word_index % BITS_IN_WORD);
+
+#ifdef FSA_THREAD_SAFE
+	uint64_t word = __atomic_load_n(word_p, __ATOMIC_RELAXED);
+
+	do
+	{
+		if ((word & mask) != 0)
+		{
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(word_p, &word, word | mask, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	if ((word | mask) == FULL_WORD)
+	{
+		WORD_AND(*summary_p, ~summary_mask);
+
+		/* chunk could be released between claim and summary update, do not lose this word */
+		if (__atomic_load_n(word_p, __ATOMIC_SEQ_CST) != FULL_WORD)
+		{
+			WORD_OR(*summary_p, summary_mask);
+		}
+	}
+#else
+	if ((*word_p & mask) != 0)
+	{
+		return false;
+	}
+
+	*word_p |= mask;
+
+	if (*word_p == FULL_WORD)
+	{
+		*summary_p &= ~summary_mask;
+	}
+#endif
+
+	return true;
+}
+
+static inline void __word_release(Fsa_pool* const pool_p, const size_t word_index, const uint64_t mask)
+{
+	WORD_AND(pool_p->available_chunks_p[word_index], ~mask);
+	WORD_OR(pool_p->free_words_p[word_index / BITS_IN_WORD], (uint64_t)1 << (word_index % BITS_IN_WORD));
+}
+
+static bool __bitmap_set(Fsa_pool* const pool_p, const size_t index, const size_t nr_of_chunks)
+{
+	size_t chunk = index;
+	const size_t end = index + nr_of_chunks;
+
+	while (chunk < end)
+	{
+		const size_t word_index = chunk / BITS_IN_WORD;
+		const size_t bit = chunk % BITS_IN_WORD;
+		const size_t bits = end - chunk < BITS_IN_WORD - bit ? end - chunk : BITS_IN_WORD - bit;
+		const uint64_t mask = (bits == BITS_IN_WORD ? FULL_WORD : (((uint64_t)1 << bits) - 1)) << bit;
+
+		if (!__word_claim(pool_p, word_index, mask))
+		{
+			/* give back already claimed part of run */
+			__bitmap_clear(pool_p, index, chunk - index);
+
+			return false;
+		}
+
+		chunk += bits;
+	}
+
+	return true;
+}
+
+static void __bitmap_clear(Fsa_pool* const pool_p, const size_t index, const size_t nr_of_chunks)
+{
+	size_t chunk = index;
+	const size_t end = index + nr_of_chunks;
+
+	while (chunk < end)
+	{
+		const size_t word_index = chunk / BITS_IN_WORD;
+		const size_t bit = chunk % BITS_IN_WORD;
+		const size_t bits = end - chunk < BITS_IN_WORD - bit ? end - chunk : BITS_IN_WORD - bit;
+		const uint64_t mask = (bits == BITS_IN_WORD ? FULL_WORD : (((uint64_t)1 << bits) - 1)) << bit;
+
+		__word_release(pool_p, word_index, mask);
+
+		chunk += bits;
+	}
+}
+
+static inline size_t __slab_class(const size_t bytes)
+{
+	if (bytes <= FSA_SLAB_MIN_SIZE)
+	{
+		return 0;
+	}
+
+	return (size_t)(BITS_IN_WORD - __builtin_clzll((uint64_t)bytes - 1)) - FSA_SLAB_MIN_SHIFT;
+}
+
+static void __slab_list_push(Fsa_pool* const pool_p, const size_t size_class, const size_t page)
+{
+	Slab_page* const slab_p = &pool_p->slab_pages_p[page];
+	const uint32_t head = pool_p->state_p->slab_partial[size_class];
+
+	slab_p->prev = 0;
+	slab_p->next = head;
+
+	if (head != 0)
+	{
+		pool_p->slab_pages_p[head - 1].prev = (uint32_t)(page + 1);
+	}
+
+	pool_p->state_p->slab_partial[size_class] = (uint32_t)(page + 1);
+}
+
+static void __slab_list_remove(Fsa_pool* const pool_p, const size_t size_class, const size_t page)
+{
+	Slab_page* const slab_p = &pool_p->slab_pages_p[page];
+
+	if (slab_p->prev != 0)
+	{
+		pool_p->slab_pages_p[slab_p->prev - 1].next = slab_p->next;
+	}
+	else
+	{
+		pool_p->state_p->slab_partial[size_class] = slab_p->next;
+	}
+
+	if (slab_p->next != 0)
+	{
+		pool_p->slab_pages_p[slab_p->next - 1].prev = slab_p->prev;
+	}
+
+	slab_p->next = 0;
+	slab_p->prev = 0;
+}
+
+static void* __slab_alloc(Fsa_pool* const pool_p, const size_t size_class)
+{
+	const size_t slot_shift = size_class + FSA_SLAB_MIN_SHIFT;
+
+	SLAB_LOCK(pool_p->state_p->slab_locks[size_class]);
+
+	size_t page;
+
+	if (pool_p->state_p->slab_partial[size_class] == 0)
+	{
+		uint8_t* const chunk_p = (uint8_t*)__pool_alloc(pool_p, pool_p->size_of_chunk, false);
+
+		if (chunk_p == NULL)
+		{
+			SLAB_UNLOCK(pool_p->state_p->slab_locks[size_class]);
+			return NULL;
+		}
+
+		page = (size_t)(chunk_p - pool_p->memory_p) >> pool_p->chunk_shift;
+
+		Slab_page* const slab_p = &pool_p->slab_pages_p[page];
+
+		slab_p->nr_of_free_slots = (uint32_t)(pool_p->size_of_chunk >> slot_shift);
+		slab_p->free_slot = 0;
+		slab_p->nr_of_carved_slots = 0;
+		slab_p->size_class = (uint32_t)(size_class + 1);
+
+		__slab_list_push(pool_p, size_class, page);
+	}
+	else
+	{
+		page = (size_t)pool_p->state_p->slab_partial[size_class] - 1;
+	}
+
+	Slab_page* const slab_p = &pool_p->slab_pages_p[page];
+	uint8_t* const chunk_p = &pool_p->memory_p[page << pool_p->chunk_shift];
+	size_t slot;
+
+	/* recently freed slot is still in cache, so take it before untouched one */
+	if (slab_p->free_slot != 0)
+	{
+		slot = (size_t)slab_p->free_slot - 1;
+		(void)memcpy(&slab_p->free_slot, &chunk_p[slot << slot_shift], sizeof(slab_p->free_slot));
+	}
+	else
+	{
+		slot = slab_p->nr_of_carved_slots;
+		++slab_p->nr_of_carved_slots;
+	}
+
+	--slab_p->nr_of_free_slots;
+
+	if (slab_p->nr_of_free_slots == 0)
+	{
+		__slab_list_remove(pool_p, size_class, page);
+	}
+
+	SLAB_UNLOCK(pool_p->state_p->slab_locks[size_class]);
+
+	return (void*)&chunk_p[slot << slot_shift];
+}
+
+static void __slab_dealloc(Fsa_pool* const pool_p, const size_t page, uint8_t* const addr_p)
+{
+	Slab_page* const slab_p = &pool_p->slab_pages_p[page];
+
+	/* size class can not change while any slot of chunk is allocated */
+	const size_t size_class = (size_t)slab_p->size_class - 1;
+	const size_t slot_shift = size_class + FSA_SLAB_MIN_SHIFT;
+	uint8_t* const chunk_p = &pool_p->memory_p[page << pool_p->chunk_shift];
+	const size_t offset = (size_t)(addr_p - chunk_p);
+
+	if ((offset & (((size_t)1 << slot_shift) - 1)) != 0)
+	{
+		return;
+	}
+
+	SLAB_LOCK(pool_p->state_p->slab_locks[size_class]);
+
+	(void)memcpy(addr_p, &slab_p->free_slot, sizeof(slab_p->free_slot));
+	slab_p->free_slot = (uint32_t)((offset >> slot_shift) + 1);
+	++slab_p->nr_of_free_slots;
+
+	/* full chunk is not on list */
+	if (slab_p->nr_of_free_slots == 1)
+	{
+		__slab_list_push(pool_p, size_class, page);
+	}
+
+	/* keep one empty chunk for size class, so alloc and dealloc of single slot do not carve chunk each time */
+	if (slab_p->nr_of_free_slots == (pool_p->size_of_chunk >> slot_shift) && (slab_p->next != 0 || slab_p->prev != 0))
+	{
+		__slab_list_remove(pool_p, size_class, page);
+		slab_p->size_class = 0;
+
+		SLAB_UNLOCK(pool_p->state_p->slab_locks[size_class]);
+
+		fsa_pool_dealloc(pool_p, chunk_p);
+		return;
+	}
+
+	SLAB_UNLOCK(pool_p->state_p->slab_locks[size_class]);
+}
+
+#ifdef FSA_THREAD_CACHE
+
+static size_t __bitmap_claim_chunks(Fsa_pool* const pool_p, uint32_t* const chunks_p, const size_t nr_of_chunks)
+{
+	size_t nr_of_claimed = 0;
+
+	for (size_t i = 0; i < pool_p->nr_of_summary_words && nr_of_claimed < nr_of_chunks; ++i)
+	{
+		for (uint64_t summary = WORD_LOAD(pool_p->free_words_p[i]); summary != 0; summary &= summary - 1)
+		{
+			const size_t word_index = (i * BITS_IN_WORD) + (size_t)__builtin_ctzll(summary);
+			uint64_t mask;
+
+			/* take the lowest free chunks from word, repeat if another thread was faster */
+			do
+			{
+				uint64_t free_chunks = ~WORD_LOAD(pool_p->available_chunks_p[word_index]);
+				mask = 0;
+
+				for (size_t n = nr_of_claimed; free_chunks != 0 && n < nr_of_chunks; ++n)
+				{
+					mask |= free_chunks & (~free_chunks + 1);
+					free_chunks &= free_chunks - 1;
+				}
+			} while (mask != 0 && !__word_claim(pool_p, word_index, mask));
+
+			for (; mask != 0; mask &= mask - 1)
+			{
+				chunks_p[nr_of_claimed] = (uint32_t)((word_index * BITS_IN_WORD) + (size_t)__builtin_ctzll(mask));
+				++nr_of_claimed;
+			}
+
+			if (nr_of_claimed == nr_of_chunks)
+			{
+				break;
+			}
+		}
+	}
+
+	return nr_of_claimed;
+}
+
+static void __thread_cache_key_create(void)
+{
+	const int ret = pthread_key_create(&cache_key, __thread_cache_destroy);
+	assert(ret == 0);
+	(void)ret;
+}
+
+static void __thread_cache_destroy(void* caches_p)
+{
+	__thread_caches_trim((Thread_cache*)caches_p, 0);
+}
+
+static inline Thread_cache* __thread_cache_get(const Fsa_pool* const pool_p)
+{
+	if (pool_p->cache_index >= FSA_MAX_CACHED_POOLS || cache_high_water_mark == 0)
+	{
+		return NULL;
+	}
+
+	Thread_cache* const cache_p = &thread_caches[pool_p->cache_index];
+
+	if (cache_p->generation != pool_p->generation)
+	{
+		cache_p->generation = pool_p->generation;
+		cache_p->nr_of_chunks = 0;
+		cache_p->nr_of_allocs = 0;
+		cache_p->nr_of_frees = 0;
+		cache_p->requested_bytes = 0;
+		cache_p->allocated_bytes = 0;
+
+		if (!is_cache_registered)
+		{
+			(void)pthread_once(&cache_key_once, __thread_cache_key_create);
+			(void)pthread_setspecific(cache_key, &thread_caches[0]);
+			is_cache_registered = true;
+		}
+	}
+
+	return cache_p;
+}
+
+static void __thread_cache_refill(Fsa_pool* const pool_p, Thread_cache* const cache_p)
+{
+	const size_t batch = cache_high_water_mark > 1 ? cache_high_water_mark / 2 : 1;
+
+	__thread_cache_publish(pool_p, cache_p);
+	const size_t nr_of_claimed = __bitmap_claim_chunks(pool_p, &cache_p->chunks[0], batch);
+
+	/* the lowest chunk goes to stack top */
+	for (size_t i = 0; i < nr_of_claimed / 2; ++i)
+	{
+		const uint32_t chunk = cache_p->chunks[i];
+		cache_p->chunks[i] = cache_p->chunks[nr_of_claimed - i - 1];
+		cache_p->chunks[nr_of_claimed - i - 1] = chunk;
+	}
+
+	cache_p->nr_of_chunks = nr_of_claimed;
+}
+
+static void __thread_cache_flush(Fsa_pool* const pool_p, Thread_cache* const cache_p, const size_t nr_of_chunks)
+{
+	size_t word_index = pool_p->nr_of_words;
+	uint64_t mask = 0;
+
+	__thread_cache_publish(pool_p, cache_p);
+
+	/* chunks from the same word are released together */
+	for (size_t i = 0; i < nr_of_chunks; ++i)
+	{
+		const size_t chunk = cache_p->chunks[i];
+
+		if (chunk / BITS_IN_WORD != word_index)
+		{
+			if (mask != 0)
+			{
+				__word_release(pool_p, word_index, mask);
+			}
+
+			word_index = chunk / BITS_IN_WORD;
+			mask = 0;
+		}
+
+		mask |= (uint64_t)1 << (chunk % BITS_IN_WORD);
+	}
+
+	if (mask != 0)
+	{
+		__word_release(pool_p, word_index, mask);
+	}
+
+	cache_p->nr_of_chunks -= nr_of_chunks;
+	(void)memmove(&cache_p->chunks[0], &cache_p->chunks[nr_of_chunks], cache_p->nr_of_chunks * sizeof(uint32_t));
+}
+
+static void __thread_cache_publish(Fsa_pool* const pool_p, Thread_cache* const cache_p)
+{
+	if (cache_p->nr_of_allocs > 0)
+	{
+		__statistics_alloc(pool_p, cache_p->nr_of_allocs, cache_p->nr_of_allocs);
+		cache_p->nr_of_allocs = 0;
+	}
+
+	if (cache_p->allocated_bytes > 0)
+	{
+		__statistics_request(pool_p, cache_p->requested_bytes, cache_p->allocated_bytes);
+		cache_p->requested_bytes = 0;
+		cache_p->allocated_bytes = 0;
+	}
+
+	if (cache_p->nr_of_frees > 0)
+	{
+		__statistics_dealloc(pool_p, cache_p->nr_of_frees, cache_p->nr_of_frees);
+		cache_p->nr_of_frees = 0;
+	}
+}
+
+static void __thread_caches_trim(Thread_cache* const caches_p, const size_t high_water_mark)
+{
+	for (size_t i = 0; i < FSA_MAX_CACHED_POOLS; ++i)
+	{
+		Fsa_pool* const pool_p = __atomic_load_n(&cached_pools[i], __ATOMIC_ACQUIRE);
+
+		/* cache of destroyed or reset pool has nothing to give back */
+		if (pool_p == NULL || caches_p[i].generation != pool_p->generation)
+		{
+			continue;
+		}
+
+		__thread_cache_publish(pool_p, &caches_p[i]);
+
+		if (caches_p[i].nr_of_chunks > high_water_mark)
+		{
+			__thread_cache_flush(pool_p, &caches_p[i], caches_p[i].nr_of_chunks - high_water_mark);
+		}
+	}
+}
+
+#endif
+
+static void* __pool_alloc(Fsa_pool* const pool_p, const size_t bytes, const bool is_request)
+{
+	/* check if requested bytes if bigger than zero */
+	if (pool_p == NULL || bytes == 0)
+	{
+		return NULL;
+	}
+
+	/* calculate requested chunks, bytes are rounded up to whole chunks */
+	const size_t req_chunks = ((bytes - 1) >> pool_p->chunk_shift) + 1;
+
+	/* check if requested number of chunks is not bigger than memory */
+	if (req_chunks > pool_p->nr_of_chunks)
+	{
+		(void)STAT_ADD(pool_p->state_p->nr_of_failures, 1);
+		return NULL;
+	}
+
+#ifdef FSA_THREAD_CACHE
+	if (req_chunks == 1)
+	{
+		Thread_cache* const cache_p = __thread_cache_get(pool_p);
+
+		if (cache_p != NULL)
+		{
+			if (cache_p->nr_of_chunks == 0)
+			{
+				__thread_cache_refill(pool_p, cache_p);
 
-/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+				if (cache_p->nr_of_chunks == 0)
+				{
+					(void)STAT_ADD(pool_p->state_p->nr_of_failures, 1);
+					return NULL;
+				}
+			}
 
-/* memory for allocations */
-static uint8_t memory[MEMORY_SIZE];
+			--cache_p->nr_of_chunks;
+			++cache_p->nr_of_allocs;
 
-/* 
-    This array keep informations about free or allocated chunks of memory. 
-    1* - 0 = free chunk of memory; 
-    2* - 1 = allocated chunk of memory
-*/
-static uint8_t available_chunks[(MEMORY_SIZE / SIZE_OF_CHUNK) / BITS_IN_BYTE];
+			if (is_request)
+			{
+				cache_p->requested_bytes += bytes;
+				cache_p->allocated_bytes += pool_p->size_of_chunk;
+			}
 
-/* This array keey information about number of allocated chunks */
-static uint8_t number_of_chunks[(MEMORY_SIZE / SIZE_OF_CHUNK)];
+			const size_t cached = cache_p->chunks[cache_p->nr_of_chunks];
+			pool_p->number_of_chunks_p[cached] = 1;
 
-/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+			return (void*)&pool_p->memory_p[cached << pool_p->chunk_shift];
+		}
+	}
+#endif
 
-struct Memory_statistic
-{
-    size_t nr_of_allocated_chunks;
-    size_t* size_of_allocated_chunks_p;
+	size_t index;
 
-    size_t nr_of_free_chunks;
-    size_t* size_of_free_chunks_p;
-};
+	/* in thread safe mode found chunks could be taken by another thread before we mark them, then search again */
+	do
+	{
+		index = req_chunks == 1 ? __bitmap_find_free_chunk(pool_p) : __bitmap_find_free_run(pool_p, req_chunks);
 
-typedef struct Memory_statistic Memory_statistic;
+		if (index >= pool_p->nr_of_chunks)
+		{
+			(void)STAT_ADD(pool_p->state_p->nr_of_failures, 1);
+			return NULL;
+		}
+	} while (!__bitmap_set(pool_p, index, req_chunks));
 
-/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+	/* save number of allocated chunks */
+	pool_p->number_of_chunks_p[index] = (uint32_t)req_chunks;
 
-/*
-	This function is responsible for collect informations about allocated/free memory chunks.
+	__statistics_alloc(pool_p, 1, req_chunks);
 
-	PARAMS:
-	@IN void
+	if (is_request)
+	{
+		__statistics_request(pool_p, bytes, req_chunks << pool_p->chunk_shift);
+	}
 
-	RETURN:
-	@Pointer to Memory_statistic if success
-*/
-static Memory_statistic* __memory_get_statistic(void);
+	const size_t offset = index << pool_p->chunk_shift;
+	return (void*)&pool_p->memory_p[offset];
+}
 
-/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
 
-static Memory_statistic* __memory_get_statistic(void)
+Fsa_pool* fsa_pool_create(void* region_p, const size_t size, const size_t chunk_size)
 {
-	Memory_statistic* ms_p = calloc(1, sizeof(*ms_p));
-	assert(ms_p != NULL);
+	if (region_p == NULL)
+	{
+		return fsa_pool_create_mapped(size, chunk_size, 0, 0);
+	}
 
-	size_t sizes[(MEMORY_SIZE / SIZE_OF_CHUNK)] = {0};
+	return __pool_create(region_p, size, chunk_size);
+}
 
-	for (size_t i = 0; i < ARRAY_SIZE(number_of_chunks); ++i)
+Fsa_pool* fsa_pool_create_mapped(const size_t size,
+								 const size_t chunk_size,
+								 const unsigned int flags,
+								 const size_t return_threshold)
+{
+	/* chunk size has to be power of two */
+	if (chunk_size == 0 || (chunk_size & (chunk_size - 1)) != 0 || size < chunk_size)
 	{
-		if (number_of_chunks[i] != 0)
-		{
-			sizes[ms_p->nr_of_allocated_chunks] = number_of_chunks[i];
-			++ms_p->nr_of_allocated_chunks;
-		}
+		return NULL;
 	}
 
-	if (ms_p->nr_of_allocated_chunks > 0)
-	{
-		ms_p->size_of_allocated_chunks_p = (size_t*)calloc(ms_p->nr_of_allocated_chunks,
-													  	   sizeof(*ms_p->size_of_allocated_chunks_p));
-		assert(ms_p->size_of_allocated_chunks_p != NULL);
+	const size_t system_page_size = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t huge_page_mask = FSA_HUGE_PAGE_SIZE - 1;
+
+	size_t size_of_mapping = size;
+	size_t size_of_page = system_page_size;
+	void* region_p = MAP_FAILED;
 
-		(void)memcpy(ms_p->size_of_allocated_chunks_p, 
-					 &sizes[0], 
-					 ms_p->nr_of_allocated_chunks * sizeof(*ms_p->size_of_allocated_chunks_p));
+#ifdef MAP_HUGETLB
+	if ((flags & FSA_POOL_EXPLICIT_HUGE_PAGES) != 0)
+	{
+		size_of_mapping = (size + huge_page_mask) & ~huge_page_mask;
+		size_of_page = FSA_HUGE_PAGE_SIZE;
+		/* no MAP_NORESERVE here, huge pages are reserved now so we fail instead of SIGBUS on first touch */
+		region_p = mmap(NULL, size_of_mapping, PROT_READ | PROT_WRITE,
+						MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
 	}
+#endif
 
-	if ((MEMORY_SIZE / SIZE_OF_CHUNK) - ms_p->nr_of_allocated_chunks > 0)
+	/* without explicit huge pages (or if there are no reserved huge pages) try transparent ones */
+	if (region_p == MAP_FAILED)
 	{
-		(void)memset(&sizes[0], 0, sizeof(sizes));
-		size_t accumulator = 0;
+		const bool huge_pages = (flags & (FSA_POOL_TRANSPARENT_HUGE_PAGES | FSA_POOL_EXPLICIT_HUGE_PAGES)) != 0;
 
-		for (size_t i = 0; i < ARRAY_SIZE(number_of_chunks); ++i)
-		{
-			if (number_of_chunks[i] != 0)
-			{
-				if (accumulator > 0)
-				{
-					sizes[ms_p->nr_of_free_chunks] = accumulator;
-					++ms_p->nr_of_free_chunks;
-					accumulator = 0;
-				}
+		size_of_mapping = huge_pages ? (size + huge_page_mask) & ~huge_page_mask
+									 : (size + system_page_size - 1) & ~(system_page_size - 1);
+		size_of_page = system_page_size;
+		region_p = __map_aligned(size_of_mapping, huge_pages ? FSA_HUGE_PAGE_SIZE : system_page_size, 0);
 
-				i += (size_t)number_of_chunks[i] - 1;
-			}
-			else
-			{
-				++accumulator;
-			}
+		if (region_p == MAP_FAILED)
+		{
+			return NULL;
 		}
 
-		if (accumulator != 0)
+#ifdef MADV_HUGEPAGE
+		if (huge_pages)
 		{
-			sizes[ms_p->nr_of_free_chunks] = accumulator;
-			++ms_p->nr_of_free_chunks;
+			(void)madvise(region_p, size_of_mapping, MADV_HUGEPAGE);
 		}
+#endif
+	}
 
-		ms_p->size_of_free_chunks_p = (size_t*)calloc(ms_p->nr_of_free_chunks,
-													  sizeof(*ms_p->size_of_free_chunks_p));
-		assert(ms_p->size_of_free_chunks_p != NULL);
+	Fsa_pool* const pool_p = __pool_create(region_p, size, chunk_size);
 
-		(void)memcpy(ms_p->size_of_free_chunks_p, 
-					 &sizes[0], 
-					 ms_p->nr_of_free_chunks * sizeof(*ms_p->size_of_free_chunks_p));
+	if (pool_p == NULL)
+	{
+		(void)munmap(region_p, size_of_mapping);
+		return NULL;
 	}
 
-	return ms_p;
-}
-
-/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+	pool_p->is_mapped = true;
+	pool_p->mapping_p = (uint8_t*)region_p;
+	pool_p->size_of_mapping = size_of_mapping;
+	pool_p->size_of_page = size_of_page;
+	pool_p->return_threshold = return_threshold == 0 ? 0 : ((return_threshold - 1) >> pool_p->chunk_shift) + 1;
 
-void fsa_init(void)
-{
-	(void)memset(&memory[0], 0, sizeof(memory));
-	(void)memset(&available_chunks[0], 0, sizeof(available_chunks));
-	(void)memset(&number_of_chunks[0], 0, sizeof(number_of_chunks));
+	return pool_p;
 }
 
-void* fsa_alloc(const size_t bytes)
+Fsa_pool* fsa_pool_create_shared(const int fd, const size_t size, const size_t chunk_size)
 {
-	/* check if requested bytes if bigger than zero */
-	if (bytes == 0)
+	/* chunk size has to be power of two */
+	if (fd < 0 || chunk_size == 0 || (chunk_size & (chunk_size - 1)) != 0 || size < chunk_size)
 	{
 		return NULL;
 	}
 
-	/* calculate requested chunks */
-	const size_t req_chunks = (bytes / SIZE_OF_CHUNK) + 1;
+	const size_t chunk_shift = (size_t)__builtin_ctzll(chunk_size);
+	const size_t nr_of_chunks = size >> chunk_shift;
 
-	/* check if requested number of chunks is smaller than 8 chunks */
-	if (req_chunks > BITS_IN_BYTE)
+	if (nr_of_chunks > UINT32_MAX)
 	{
 		return NULL;
 	}
 
-	uint8_t mask = 0;
+	/* chunks start at offset which is multiple of chunk size, mapping is page aligned in every process */
+	const size_t size_of_metadata = sizeof(Fsa_shared_header) + __pool_get_size_of_metadata(nr_of_chunks);
+	const size_t memory_offset = (size_of_metadata + chunk_size - 1) & ~(chunk_size - 1);
+	const size_t size_of_region = memory_offset + (nr_of_chunks << chunk_shift);
 
-	/* create proper mask for allocation */
-	for (size_t i = 0; i < req_chunks; ++i)
+	if (ftruncate(fd, (off_t)size_of_region) != 0)
 	{
-		mask <<= 1;
-		mask |= 1;
+		return NULL;
 	}
 
-	uint8_t copy_mask8 = 0;
-	uint16_t copy_mask16 = 0;
+	void* const region_p = mmap(NULL, size_of_region, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
-	/* looking for available memory */
-	for (size_t i = 0; i < ARRAY_SIZE(available_chunks); ++i)
+	if (region_p == MAP_FAILED)
 	{
-		copy_mask8 = mask;
+		return NULL;
+	}
 
-		/* take a look in inside byte */
-		for (size_t j = 0; j < BITS_IN_BYTE - req_chunks + 1; ++j)
-		{
-			/* check for empty chunks */
-			if ((available_chunks[i] & copy_mask8) == 0)
-			{
-				/* mark these chunks already allocated */
-				available_chunks[i] |= copy_mask8;
+	Fsa_shared_header* const header_p = (Fsa_shared_header*)region_p;
 
-				/* calculated allocated bit in metadata array */
-				const size_t index = (i * BITS_IN_BYTE) + j; 
+	/* file could keep older pool, so metadata is cleared, memory of chunks is not touched */
+	__atomic_store_n(&header_p->magic, 0, __ATOMIC_RELAXED);
+	(void)memset((uint8_t*)region_p + sizeof(header_p->magic), 0, size_of_metadata - sizeof(header_p->magic));
 
-				/* save number of allocated chunks */
-				number_of_chunks[index] = (uint8_t)req_chunks;
+	header_p->size_of_region = size_of_region;
+	header_p->size_of_chunk = chunk_size;
+	header_p->nr_of_chunks = nr_of_chunks;
+	header_p->memory_offset = memory_offset;
 
-				const size_t offset = index * SIZE_OF_CHUNK;
-				return (void*)&memory[offset];
-			}
+	Fsa_pool* const pool_p = __pool_create_shared_descriptor(header_p);
 
-			copy_mask8 <<= 1;
-		}
+	if (pool_p == NULL)
+	{
+		(void)munmap(region_p, size_of_region);
+		return NULL;
+	}
 
-		/* take a look between two metadata array index */
-		if (i + 1 < ARRAY_SIZE(available_chunks))
-		{
-			copy_mask16 = (uint16_t)mask;
+	__pool_reset(pool_p);
 
-			/* shift bits to the end of uint8_t */
-			for (size_t j = 0; j < BITS_IN_BYTE - req_chunks; ++j)
-			{
-				copy_mask16 <<= 1;
-			}
+	/* process which attaches sees magic only after all metadata */
+	__atomic_store_n(&header_p->magic, FSA_SHARED_MAGIC, __ATOMIC_RELEASE);
 
-			uint16_t* memory_p = (uint16_t*)&available_chunks[i];
+	return pool_p;
+}
 
-			for (size_t j = 0; j < req_chunks; ++j)
-			{
-				if ((*memory_p & copy_mask16) == 0)
-				{
-					/* mark these chunks already allocated */
-					*memory_p |= copy_mask16;
+Fsa_pool* fsa_pool_attach_shared(const int fd)
+{
+	struct stat file_stat;
 
-					/* calculated allocated bit in metadata array */
-					const size_t index = (i * BITS_IN_BYTE) + (BITS_IN_BYTE - req_chunks) + j;
+	if (fd < 0 || fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(Fsa_shared_header))
+	{
+		return NULL;
+	}
 
-					/* save number of allocated chunks */
-					number_of_chunks[index] = (uint8_t)req_chunks;
+	const size_t size_of_mapping = (size_t)file_stat.st_size;
+	void* const region_p = mmap(NULL, size_of_mapping, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
-					const size_t offset = index * SIZE_OF_CHUNK;
-					return (void*)&memory[offset];
-				}
+	if (region_p == MAP_FAILED)
+	{
+		return NULL;
+	}
 
-				/* shift bits for check new possible free bits */
-				copy_mask16 <<= 1;
-			}
-		}
+	const Fsa_shared_header* const header_p = (const Fsa_shared_header*)region_p;
+	const size_t size_of_chunk = (size_t)header_p->size_of_chunk;
+	const size_t nr_of_chunks = (size_t)header_p->nr_of_chunks;
+
+	/* geometry is checked against size of file, so broken or foreign file can not move pointers out of mapping */
+	const bool is_valid = __atomic_load_n(&header_p->magic, __ATOMIC_ACQUIRE) == FSA_SHARED_MAGIC &&
+						  header_p->size_of_region == size_of_mapping &&
+						  size_of_chunk != 0 && (size_of_chunk & (size_of_chunk - 1)) == 0 &&
+						  nr_of_chunks != 0 && nr_of_chunks <= UINT32_MAX &&
+						  header_p->memory_offset >= sizeof(Fsa_shared_header) +
+													 __pool_get_size_of_metadata(nr_of_chunks) &&
+						  header_p->memory_offset < size_of_mapping &&
+						  (size_of_mapping - header_p->memory_offset) / size_of_chunk == nr_of_chunks;
+
+	Fsa_pool* const pool_p = is_valid ? __pool_create_shared_descriptor((Fsa_shared_header*)region_p) : NULL;
+
+	if (pool_p == NULL)
+	{
+		(void)munmap(region_p, size_of_mapping);
+		return NULL;
 	}
 
-	return NULL;
+	return pool_p;
 }
 
-void fsa_dealloc(void* addr_p)
+void fsa_pool_reset(Fsa_pool* pool_p)
 {
-	if (addr_p == NULL)
+	if (pool_p == NULL)
 	{
 		return;
 	}
 
-	if ((uint8_t*)addr_p < &memory[0] || (uint8_t*)addr_p > &memory[MEMORY_SIZE - 1])
+	__pool_reset(pool_p);
+}
+
+void fsa_pool_lock(Fsa_pool* pool_p)
+{
+	if (pool_p == NULL)
 	{
 		return;
 	}
 
-	const ptrdiff_t diff = (uint8_t*)addr_p - &memory[0];
-	const size_t index = diff / SIZE_OF_CHUNK;
-	const size_t allocated_chunks = number_of_chunks[index];
+	/* always in the same order, so two callers can not deadlock */
+	for (size_t i = 0; i < FSA_SLAB_NR_OF_CLASSES; ++i)
+	{
+		SLAB_LOCK(pool_p->state_p->slab_locks[i]);
+	}
+}
 
-	if (allocated_chunks == 0 || allocated_chunks > BITS_IN_BYTE)
+void fsa_pool_unlock(Fsa_pool* pool_p)
+{
+	if (pool_p == NULL)
 	{
 		return;
 	}
 
-	uint16_t mask = 0;
+	for (size_t i = FSA_SLAB_NR_OF_CLASSES; i > 0; --i)
+	{
+		SLAB_UNLOCK(pool_p->state_p->slab_locks[i - 1]);
+	}
+}
 
-	for (size_t i = 0; i < allocated_chunks; ++i)
+void fsa_pool_destroy(Fsa_pool* pool_p)
+{
+	if (pool_p == NULL || pool_p == &default_pool)
 	{
-		mask <<= 1;
-		mask |= 1;
+		return;
 	}
 
-	/* calculate first allocated chunk in metadata bitmap */
-	uint16_t* metadata_p = (uint16_t*)&available_chunks[(index / BITS_IN_BYTE)];
+#ifdef FSA_THREAD_CACHE
+	if (pool_p->cache_index < FSA_MAX_CACHED_POOLS)
+	{
+		__atomic_store_n(&cached_pools[pool_p->cache_index], NULL, __ATOMIC_RELEASE);
+	}
+#endif
 
-	for (size_t i = 0; i < (index % BITS_IN_BYTE); ++i)
+	if (pool_p->is_mapped)
 	{
-		mask <<= 1;
+		(void)munmap(pool_p->mapping_p, pool_p->size_of_mapping);
 	}
 
-	*metadata_p ^= mask;
-	number_of_chunks[index] = 0;
+	free(pool_p);
 }
 
-void fsa_get_statistics(void)
+void* fsa_pool_alloc(Fsa_pool* pool_p, const size_t bytes)
 {
-    const Memory_statistic* const ms_p = __memory_get_statistic();
+	return __pool_alloc(pool_p, bytes, true);
+}
+
+void fsa_pool_dealloc(Fsa_pool* pool_p, void* addr_p)
+{
+	if (pool_p == NULL || addr_p == NULL)
+	{
+		return;
+	}
+
+	if ((uint8_t*)addr_p < pool_p->memory_p ||
+		(uint8_t*)addr_p >= pool_p->memory_p + (pool_p->nr_of_chunks << pool_p->chunk_shift))
+	{
+		return;
+	}
+
+	const size_t diff = (size_t)((uint8_t*)addr_p - pool_p->memory_p);
+	const size_t index = diff >> pool_p->chunk_shift;
+
+	if (pool_p->slab_pages_p[index].size_class != 0)
+	{
+		__slab_dealloc(pool_p, index, (uint8_t*)addr_p);
+		return;
+	}
+
+	/* only the first byte of chunk could be returned by alloc */
+	if ((diff & (pool_p->size_of_chunk - 1)) != 0)
+	{
+		return;
+	}
 
-    printf("number of allocated chunks = %zu\n", ms_p->nr_of_allocated_chunks);
+	const size_t allocated_chunks = pool_p->number_of_chunks_p[index];
 
-	if (ms_p->nr_of_allocated_chunks != 0)
+	if (allocated_chunks == 0 || index + allocated_chunks > pool_p->nr_of_chunks)
 	{
-		double size_of_med = 0;
+		return;
+	}
+
+	/* clear metadata before chunks can be allocated by another thread */
+	pool_p->number_of_chunks_p[index] = 0;
 
-		printf("sizes: ");
+	__pool_return_pages(pool_p, index, allocated_chunks);
+
+#ifdef FSA_THREAD_CACHE
+	if (allocated_chunks == 1)
+	{
+		Thread_cache* const cache_p = __thread_cache_get(pool_p);
 
-		for (size_t i = 0; i < ms_p->nr_of_allocated_chunks; ++i)
+		if (cache_p != NULL)
 		{
-			size_of_med += (double)ms_p->size_of_allocated_chunks_p[i];
+			if (cache_p->nr_of_chunks >= cache_high_water_mark)
+			{
+				__thread_cache_flush(pool_p, cache_p, cache_high_water_mark > 1 ? cache_high_water_mark / 2 : 1);
+			}
 
-			printf("%zu ", ms_p->size_of_allocated_chunks_p[i]);
+			cache_p->chunks[cache_p->nr_of_chunks] = (uint32_t)index;
+			++cache_p->nr_of_chunks;
+			++cache_p->nr_of_frees;
+
+			return;
 		}
+	}
+#endif
 
-		size_of_med /= (double)ms_p->nr_of_allocated_chunks;
+	__statistics_dealloc(pool_p, 1, allocated_chunks);
+	__bitmap_clear(pool_p, index, allocated_chunks);
+}
+
+size_t fsa_pool_get_usable_size(const Fsa_pool* pool_p, const void* addr_p)
+{
+	if (pool_p == NULL || addr_p == NULL)
+	{
+		return 0;
+	}
 
-		printf("\nsize_of medium = %lf\n", size_of_med);
+	if ((const uint8_t*)addr_p < pool_p->memory_p ||
+		(const uint8_t*)addr_p >= pool_p->memory_p + (pool_p->nr_of_chunks << pool_p->chunk_shift))
+	{
+		return 0;
 	}
 
-    printf("number of free chunks = %zu\n", ms_p->nr_of_free_chunks);
+	const size_t diff = (size_t)((const uint8_t*)addr_p - pool_p->memory_p);
+	const size_t index = diff >> pool_p->chunk_shift;
+	const size_t size_class = pool_p->slab_pages_p[index].size_class;
 
-	if (ms_p->nr_of_free_chunks != 0)
+	if (size_class != 0)
 	{
-		double size_of_med = 0;
+		return (size_t)1 << (size_class - 1 + FSA_SLAB_MIN_SHIFT);
+	}
 
-		printf("sizes: ");
+	if ((diff & (pool_p->size_of_chunk - 1)) != 0)
+	{
+		return 0;
+	}
 
-		for (size_t i = 0; i < ms_p->nr_of_free_chunks; ++i)
-		{
-			size_of_med += (double)ms_p->size_of_free_chunks_p[i];
+	return (size_t)pool_p->number_of_chunks_p[index] << pool_p->chunk_shift;
+}
 
-			printf("%zu ", ms_p->size_of_free_chunks_p[i]);
-		}
+void* fsa_pool_calloc(Fsa_pool* pool_p, const size_t nr_of_members, const size_t size)
+{
+	size_t bytes;
+
+	if (__builtin_mul_overflow(nr_of_members, size, &bytes))
+	{
+		return NULL;
+	}
+
+	void* const addr_p = fsa_pool_slab_alloc(pool_p, bytes);
+
+	/* init does not zero memory, so only returned bytes are zeroed */
+	if (addr_p != NULL)
+	{
+		(void)memset(addr_p, 0, bytes);
+	}
+
+	return addr_p;
+}
+
+void* fsa_pool_slab_alloc(Fsa_pool* pool_p, const size_t bytes)
+{
+	if (pool_p == NULL || bytes == 0)
+	{
+		return NULL;
+	}
+
+	/* at least two slots have to fit in chunk, otherwise there is nothing to share */
+	if (bytes > FSA_SLAB_MAX_SIZE || bytes > (pool_p->size_of_chunk >> 1))
+	{
+		return fsa_pool_alloc(pool_p, bytes);
+	}
+
+	const size_t size_class = __slab_class(bytes);
+	void* const addr_p = __slab_alloc(pool_p, size_class);
+
+	if (addr_p != NULL)
+	{
+		__statistics_request(pool_p, bytes, (size_t)FSA_SLAB_MIN_SIZE << size_class);
+	}
+
+	return addr_p;
+}
+
+void fsa_pool_read_statistics(const Fsa_pool* pool_p, Fsa_statistics* stats_p)
+{
+	if (pool_p == NULL || stats_p == NULL)
+	{
+		return;
+	}
+
+	/* counters of thread caches are added in batches, so for a moment frees could be ahead of allocations */
+	const size_t chunks_in_use = STAT_LOAD(pool_p->state_p->chunks_in_use);
+
+	stats_p->nr_of_chunks_in_use = chunks_in_use > pool_p->nr_of_chunks ? 0 : chunks_in_use;
+	stats_p->bytes_in_use = stats_p->nr_of_chunks_in_use << pool_p->chunk_shift;
+	stats_p->peak_bytes_in_use = STAT_LOAD(pool_p->state_p->peak_chunks_in_use) << pool_p->chunk_shift;
+
+	stats_p->nr_of_allocs = STAT_LOAD(pool_p->state_p->nr_of_allocs);
+	stats_p->nr_of_frees = STAT_LOAD(pool_p->state_p->nr_of_frees);
+	stats_p->nr_of_failures = STAT_LOAD(pool_p->state_p->nr_of_failures);
+}
+
+void fsa_pool_read_fragmentation(const Fsa_pool* pool_p, Fsa_fragmentation* frag_p)
+{
+	if (pool_p == NULL || frag_p == NULL)
+	{
+		return;
+	}
+
+	*frag_p = (Fsa_fragmentation){0};
+
+	size_t nr_of_free_chunks;
+	size_t largest_free_extent;
+	__bitmap_get_free_blocks(pool_p, &frag_p->free_extents[0], &frag_p->nr_of_free_extents, &nr_of_free_chunks,
+							 &largest_free_extent);
+
+	frag_p->free_bytes = nr_of_free_chunks << pool_p->chunk_shift;
+	frag_p->size_of_largest_free_extent = largest_free_extent << pool_p->chunk_shift;
+
+	if (nr_of_free_chunks > 0)
+	{
+		frag_p->external_fragmentation = 1.0 - (double)largest_free_extent / (double)nr_of_free_chunks;
+	}
+
+	/* counters are not read together, so in thread safe mode requests could be ahead of allocated bytes */
+	frag_p->allocated_bytes = STAT_LOAD(pool_p->state_p->allocated_bytes);
+	frag_p->requested_bytes = STAT_LOAD(pool_p->state_p->requested_bytes);
+
+	if (frag_p->requested_bytes > frag_p->allocated_bytes)
+	{
+		frag_p->requested_bytes = frag_p->allocated_bytes;
+	}
 
-		size_of_med /= (double)ms_p->nr_of_free_chunks;
+	if (frag_p->allocated_bytes > 0)
+	{
+		frag_p->internal_waste = 1.0 - (double)frag_p->requested_bytes / (double)frag_p->allocated_bytes;
+	}
+}
 
-		printf("\nsize_of medium = %lf\n", size_of_med);
+size_t fsa_pool_get_offset(const Fsa_pool* pool_p, const void* addr_p)
+{
+	if (pool_p == NULL)
+	{
+		return FSA_INVALID_OFFSET;
 	}
 
-	if (ms_p->nr_of_allocated_chunks != 0)
+	/* NULL and address before memory wrap around to big offset */
+	const size_t offset = (size_t)((uintptr_t)addr_p - (uintptr_t)pool_p->memory_p);
+
+	return offset < (pool_p->nr_of_chunks << pool_p->chunk_shift) ? offset : FSA_INVALID_OFFSET;
+}
+
+void* fsa_pool_get_address(const Fsa_pool* pool_p, const size_t offset)
+{
+	if (pool_p == NULL || offset >= (pool_p->nr_of_chunks << pool_p->chunk_shift))
 	{
-		free((void*)ms_p->size_of_allocated_chunks_p);
+		return NULL;
 	}
 
-	if (ms_p->nr_of_free_chunks != 0)
+	return (void*)&pool_p->memory_p[offset];
+}
+
+void fsa_init(void)
+{
+	__pool_reset(&default_pool);
+}
+
+void* fsa_alloc(const size_t bytes)
+{
+	return fsa_pool_alloc(&default_pool, bytes);
+}
+
+void* fsa_slab_alloc(const size_t bytes)
+{
+	return fsa_pool_slab_alloc(&default_pool, bytes);
+}
+
+void* fsa_calloc(const size_t nr_of_members, const size_t size)
+{
+	return fsa_pool_calloc(&default_pool, nr_of_members, size);
+}
+
+void fsa_dealloc(void* addr_p)
+{
+	fsa_pool_dealloc(&default_pool, addr_p);
+}
+
+size_t fsa_get_usable_size(const void* addr_p)
+{
+	return fsa_pool_get_usable_size(&default_pool, addr_p);
+}
+
+void fsa_cache_set_high_water_mark(const size_t high_water_mark)
+{
+#ifdef FSA_THREAD_CACHE
+	const size_t hwm = high_water_mark < FSA_CACHE_SIZE ? high_water_mark : FSA_CACHE_SIZE;
+
+	__thread_caches_trim(&thread_caches[0], hwm);
+	cache_high_water_mark = hwm;
+#else
+	(void)high_water_mark;
+#endif
+}
+
+void fsa_cache_flush(void)
+{
+#ifdef FSA_THREAD_CACHE
+	__thread_caches_trim(&thread_caches[0], 0);
+#endif
+}
+
+void fsa_lock(void)
+{
+	fsa_pool_lock(&default_pool);
+}
+
+void fsa_unlock(void)
+{
+	fsa_pool_unlock(&default_pool);
+}
+
+void fsa_read_statistics(Fsa_statistics* stats_p)
+{
+	fsa_pool_read_statistics(&default_pool, stats_p);
+}
+
+void fsa_get_statistics(void)
+{
+	Fsa_statistics stats;
+	fsa_read_statistics(&stats);
+
+	printf("number of allocated chunks = %zu\n", stats.nr_of_chunks_in_use);
+	printf("bytes in use = %zu (peak = %zu)\n", stats.bytes_in_use, stats.peak_bytes_in_use);
+	printf("allocs = %zu, frees = %zu, failures = %zu\n", stats.nr_of_allocs, stats.nr_of_frees, stats.nr_of_failures);
+}
+
+void fsa_read_fragmentation(Fsa_fragmentation* frag_p)
+{
+	fsa_pool_read_fragmentation(&default_pool, frag_p);
+}
+
+void fsa_get_fragmentation(void)
+{
+	Fsa_fragmentation frag;
+	fsa_read_fragmentation(&frag);
+
+	printf("free bytes = %zu in %zu extents\n", frag.free_bytes, frag.nr_of_free_extents);
+	printf("size of largest free extent = %zu\n", frag.size_of_largest_free_extent);
+	printf("external fragmentation = %.3f\n", frag.external_fragmentation);
+
+	for (size_t i = 0; i < FSA_FRAGMENTATION_NR_OF_BUCKETS; ++i)
 	{
-		free((void*)ms_p->size_of_free_chunks_p);
+		if (frag.free_extents[i] > 0)
+		{
+			printf("extents of %zu+ chunks = %zu\n", (size_t)1 << i, frag.free_extents[i]);
+		}
 	}
 
-    free((void*)ms_p);
+	printf("requested bytes = %zu, allocated bytes = %zu, internal waste = %.3f\n", frag.requested_bytes,
+		   frag.allocated_bytes, frag.internal_waste);
 }
 
 size_t fsa_get_size_of_memory(void)
@@ -337,12 +2217,15 @@ void* fsa_get_address_from_memory(const size_t index)
 
 size_t fsa_get_size_of_available_chunks(void)
 {
-	return ARRAY_SIZE(available_chunks);
+	return NR_OF_CHUNKS / BITS_IN_BYTE;
 }
 
 uint8_t fsa_get_available_chunks(const size_t index)
 {
-	return available_chunks[index];
+	/* byte view of leaf bitmap, byte n keep chunks n * 8 .. n * 8 + 7 */
+	const uint64_t word = WORD_LOAD(available_chunks[index / (BITS_IN_WORD / BITS_IN_BYTE)]);
+
+	return (uint8_t)(word >> ((index % (BITS_IN_WORD / BITS_IN_BYTE)) * BITS_IN_BYTE));
 }
 
 size_t fsa_get_size_of_number_of_chunks(void)
@@ -350,7 +2233,7 @@ size_t fsa_get_size_of_number_of_chunks(void)
 	return ARRAY_SIZE(number_of_chunks);
 }
 
-uint8_t fsa_get_number_of_chunks(const size_t index)
+size_t fsa_get_number_of_chunks(const size_t index)
 {
 	return number_of_chunks[index];
-}
\ No newline at end of file
+}
@@ -1,12 +1,59 @@
+/* memfd_create is GNU extension */
+#define _GNU_SOURCE
+
 #include <fixed_size_allocator.h>
+#include <fsa_pool_generator.h>
+#include <benchmark.h>
 #include <assert.h>
 #include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef FSA_THREAD_SAFE
+#include <pthread.h>
+#endif
 
 /* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
 
 /* macro for calculating size of arrays allocated on stack */
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
 
+#ifdef FSA_THREAD_SAFE
+
+/* max number of threads used by stress test and benchmark */
+#define MAX_NR_OF_THREADS 16
+
+/* number of alloc/dealloc pairs done by each thread */
+#define NR_OF_ITERATIONS (1 << 18)
+
+/* number of allocations kept by each thread at the same time */
+#define NR_OF_LIVE_ALLOCATIONS 4
+
+/* number of alloc/free pairs and number of buffers kept at once by each process using shared pool */
+#define NR_OF_SHARED_ITERATIONS (1 << 14)
+#define NR_OF_LIVE_SHARED_BUFFERS 4
+
+#endif
+
+/* number of chunks of generated pools, the second one needs two summary words */
+#define NR_OF_SMALL_POOL_CHUNKS 1000
+#define NR_OF_BIG_POOL_CHUNKS 5000
+
+/* geometry of pool in shared memory file */
+#define SHARED_POOL_CHUNK_SIZE 256
+#define SHARED_POOL_NR_OF_CHUNKS 64
+
+/* number of alloc/free pairs and number of allocations kept at once in benchmark of generated pool */
+#define NR_OF_POOL_ITERATIONS (1 << 22)
+#define NR_OF_POOL_LIVE_CHUNKS 64
+
+/* --------------------------------------------- GENERATED POOLS --------------------------------------------------- */
+
+DEFINE_FSA_POOL(small_pool, 64, NR_OF_SMALL_POOL_CHUNKS);
+DEFINE_FSA_POOL(big_pool, 16, NR_OF_BIG_POOL_CHUNKS);
+
 /* ------------------------------------------- FUNCTION DECLARATION ------------------------------------------------ */
 
 /*
@@ -64,6 +111,283 @@ static void test_frees(void);
 */
 static void test_allocations_find_empty_bits(void);
 
+/*
+    In this test case we want to allocate pages between 64-bit words of bitmap and allocate all available pages, to
+    make sure that summary bitmap skip full words and find last free page.
+
+    word index:          0                   1
+    word  bits: |1111 ... 1111 1111|1111 1111 0000 ...|...
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_allocations_between_words(void);
+
+/*
+    In this test case we want to allocate runs longer than one byte and one word of bitmap (up to whole memory) and
+    make sure that freed long runs can be allocated once again.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_allocations_long_runs(void);
+
+/*
+    In this test case we want to create many pools with different chunk size over caller-provided and mapped memory
+    and make sure that they work independently of each other and of default pool.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_pools(void);
+
+/*
+    Count pages of @size bytes from @addr_p which are resident in RAM.
+
+    PARAMS:
+    @IN addr_p - page aligned address.
+    @IN size - number of bytes.
+
+    RETURN:
+    Number of resident pages.
+*/
+static size_t __count_resident_pages(void* addr_p, const size_t size);
+
+/*
+    In this test case we want to create pools over mapped memory (also with huge pages) and make sure that pages are
+    committed when they are touched and long freed runs are given back to kernel.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_mapped_pools(void);
+
+/*
+    In this test case we want to check that statistics follow allocations and deallocations, also when free blocks
+    cross bitmap words.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_statistics(void);
+
+/*
+    In this test case we want to make sure that fragmentation report counts free extents in log2 buckets, computes
+    external fragmentation from the largest extent and internal waste from rounding of alloc and slab alloc.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_fragmentation(void);
+
+/*
+    In this test case we want to allocate small objects by slab layer and make sure that they are packed in chunks,
+    freed slots are reused and empty chunks are given back.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_slab(void);
+
+/*
+    In this test case we want to make sure that reset frees all chunks and slots without touching memory of chunks,
+    so pages of big mapped pool are not committed by reset, and fsa_calloc zeroes returned bytes.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_reset(void);
+
+/*
+    In this test case we want to make sure that pool in shared memory file can be attached at other address and by
+    other process, buffers are passed by offsets without copy and bitmap and counters are shared.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_shared_pools(void);
+
+#ifdef FSA_THREAD_SAFE
+
+/*
+    This function allocate and free chunks of shared pool, each buffer is filled with @pattern and checked before it
+    is freed, so buffer given to two processes at once is found.
+
+    PARAMS:
+    @IN pool_p - pointer to attached shared pool.
+    @IN pattern - byte written to buffers.
+
+    RETURN:
+    This is void function.
+*/
+static void __shared_pool_loop(Fsa_pool* pool_p, const uint8_t pattern);
+
+#endif
+
+/*
+    In this test case we want to fill pools generated by DEFINE_FSA_POOL (one and two summary words) and make sure
+    that chunks are aligned, distinct and lowest free chunk is reused, invalid frees are ignored and reset frees all.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_generated_pools(void);
+
+/*
+    Alloc and free NR_OF_POOL_ITERATIONS chunks of pool generated by DEFINE_FSA_POOL, NR_OF_POOL_LIVE_CHUNKS of them
+    are kept at once.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __generated_pool_loop(void);
+
+/*
+    Alloc and free chunks of runtime pool like __generated_pool_loop.
+
+    PARAMS:
+    @IN pool_p - pointer to pool.
+
+    RETURN:
+    This is void function.
+*/
+static void __runtime_pool_loop(Fsa_pool* pool_p);
+
+/*
+    Benchmark of alloc and free of 64 B chunks, pool generated by DEFINE_FSA_POOL against runtime pool of the same
+    geometry.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_generated_pool(void);
+
+#ifdef FSA_THREAD_CACHE
+
+/*
+    In this test case we want to make sure that single chunks are taken from bitmap and given back to bitmap in
+    batches by thread cache and that high water mark limits number of cached chunks.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_thread_cache(void);
+
+#endif
+
+#ifdef FSA_THREAD_SAFE
+
+/*
+    Thread routine for stress test. Thread allocates runs of 1 - 4 chunks, fill them with own id and check that no one
+    else wrote to them before deallocation.
+
+    PARAMS:
+    @IN arg_p - thread id casted to pointer.
+
+    RETURN:
+    NULL.
+*/
+static void* __stress_thread(void* arg_p);
+
+/*
+    Thread routine for stress test of slab layer. Thread allocates objects of random size, fills them by its id and
+    checks them before deallocation.
+
+    PARAMS:
+    @IN arg_p - id of thread.
+
+    RETURN:
+    NULL.
+*/
+static void* __slab_stress_thread(void* arg_p);
+
+/*
+    Thread routine for benchmark. Thread allocates and deallocates single chunk NR_OF_ITERATIONS times.
+
+    PARAMS:
+    @IN arg_p - not used.
+
+    RETURN:
+    NULL.
+*/
+static void* __benchmark_thread(void* arg_p);
+
+/*
+    Run @nr_of_threads threads with @routine and wait for them.
+
+    PARAMS:
+    @IN routine - thread routine, thread id is passed as argument.
+    @IN nr_of_threads - number of threads.
+
+    RETURN:
+    This is void function.
+*/
+static void __run_threads(void* (*routine)(void*), const size_t nr_of_threads);
+
+/*
+    In this test case we want to allocate and deallocate memory from many threads at the same time and make sure that
+    the same chunk is never given to two threads and all chunks are free at the end.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_threads_stress(void);
+
+/*
+    Benchmark of single chunk alloc/dealloc from 1 to N threads.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_threads_scaling(void);
+
+#endif
+
 /* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
 
 static void test_allocations(void)
@@ -327,15 +651,1114 @@ static void test_allocations_find_empty_bits(void)
     */
 }
 
-/* ----------------------------------------------- MAIN FUNCTION --------------------------------------------------- */
+static void test_allocations_between_words(void)
+{
+    fsa_init();
 
-int main(void)
+    const size_t nr_of_chunks = fsa_get_size_of_number_of_chunks();
+    void* ptr_p = NULL;
+
+    for (size_t i = 0; i < BITS_IN_WORD - 4; ++i)
+    {
+        ptr_p = fsa_alloc(1);
+        assert(ptr_p == fsa_get_address_from_memory(i * PAGE_SIZE));
+    }
+
+    /* 8 chunks starting in word 0 and finishing in word 1 */
+    ptr_p = fsa_alloc((7 * PAGE_SIZE) + 1);
+    assert(ptr_p == fsa_get_address_from_memory((BITS_IN_WORD - 4) * PAGE_SIZE));
+    assert(fsa_get_number_of_chunks(BITS_IN_WORD - 4) == 8);
+    assert(fsa_get_available_chunks(BITS_IN_WORD / BITS_IN_BYTE - 1) == 0xff);
+    assert(fsa_get_available_chunks(BITS_IN_WORD / BITS_IN_BYTE) == 0x0f);
+
+    /* allocate all remaining chunks */
+    for (size_t i = BITS_IN_WORD + 4; i < nr_of_chunks; ++i)
+    {
+        ptr_p = fsa_alloc(1);
+        assert(ptr_p == fsa_get_address_from_memory(i * PAGE_SIZE));
+    }
+
+    assert(fsa_alloc(1) == NULL);
+
+    /* free one chunk from the middle of memory, it is the only one which can be found */
+    fsa_dealloc(fsa_get_address_from_memory((nr_of_chunks / 2) * PAGE_SIZE));
+    assert(fsa_alloc((1 * PAGE_SIZE) + 1) == NULL);
+
+    ptr_p = fsa_alloc(1);
+    assert(ptr_p == fsa_get_address_from_memory((nr_of_chunks / 2) * PAGE_SIZE));
+    assert(fsa_alloc(1) == NULL);
+}
+
+static void test_allocations_long_runs(void)
 {
-    test_allocations();
-    test_allocations_between_index();
-    test_frees();
-    test_allocations_find_empty_bits();
+    fsa_init();
 
-    return 0;
+    const size_t nr_of_chunks = fsa_get_size_of_number_of_chunks();
+    void* address[3] = {0};
+
+    /* 40 kB buffer and one byte */
+    address[0] = fsa_alloc((40 * 1024) + 1);
+    assert(address[0] == fsa_get_address_from_memory(0));
+    assert(fsa_get_number_of_chunks(0) == (40 * 1024) / PAGE_SIZE + 1);
+
+    /* run through three words of bitmap */
+    address[1] = fsa_alloc((99 * PAGE_SIZE) + 1);
+    assert(address[1] == fsa_get_address_from_memory(11 * PAGE_SIZE));
+    assert(fsa_get_number_of_chunks(11) == 100);
+    assert(fsa_get_available_chunks(13) == 0x7f);
+    assert(fsa_get_available_chunks(14) == 0x00);
+
+    address[2] = fsa_alloc(1);
+    assert(address[2] == fsa_get_address_from_memory(111 * PAGE_SIZE));
+
+    /* too long for free run at the beginning, have to go behind single page */
+    fsa_dealloc(address[1]);
+    assert(fsa_get_number_of_chunks(11) == 0);
+    assert(fsa_get_available_chunks(2) == 0x00);
+
+    address[1] = fsa_alloc((100 * PAGE_SIZE) + 1);
+    assert(address[1] == fsa_get_address_from_memory(112 * PAGE_SIZE));
+    fsa_dealloc(address[1]);
+
+    address[1] = fsa_alloc((98 * PAGE_SIZE) + 1);
+    assert(address[1] == fsa_get_address_from_memory(11 * PAGE_SIZE));
+
+    /* whole memory */
+    fsa_init();
+
+    address[0] = fsa_alloc(MEMORY_SIZE - 1);
+    assert(address[0] == fsa_get_address_from_memory(0));
+    assert(fsa_get_number_of_chunks(0) == nr_of_chunks);
+    assert(fsa_alloc(1) == NULL);
+
+    fsa_dealloc(address[0]);
+    assert(fsa_get_available_chunks(fsa_get_size_of_available_chunks() - 1) == 0x00);
+
+    /* request of exactly memory size fits in empty pool */
+    address[0] = fsa_alloc(MEMORY_SIZE);
+    assert(address[0] == fsa_get_address_from_memory(0));
+    assert(fsa_get_number_of_chunks(0) == nr_of_chunks);
+
+    fsa_dealloc(address[0]);
+    assert(fsa_alloc(MEMORY_SIZE + 1) == NULL);
 }
 
+static void test_pools(void)
+{
+    fsa_init();
+
+    static uint8_t region[64 * 100] __attribute__((aligned(64)));
+
+    assert(fsa_pool_create(NULL, 1 << 20, 3000) == NULL);
+    assert(fsa_pool_create(&region[0], 32, 64) == NULL);
+
+    Fsa_pool* const message_pool_p = fsa_pool_create(&region[0], sizeof(region), 64);
+    Fsa_pool* const page_pool_p = fsa_pool_create(NULL, 1 << 20, 1 << 12);
+    Fsa_pool* const io_pool_p = fsa_pool_create(NULL, 1 << 24, 1 << 16);
+
+    assert(message_pool_p != NULL);
+    assert(page_pool_p != NULL);
+    assert(io_pool_p != NULL);
+
+    uint8_t* message_p[100] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(message_p); ++i)
+    {
+        message_p[i] = (uint8_t*)fsa_pool_alloc(message_pool_p, 63);
+        assert(message_p[i] == &region[i * 64]);
+    }
+
+    assert(fsa_pool_alloc(message_pool_p, 1) == NULL);
+
+    /* two chunks of 64 B */
+    fsa_pool_dealloc(message_pool_p, message_p[10]);
+    fsa_pool_dealloc(message_pool_p, message_p[11]);
+    assert(fsa_pool_alloc(message_pool_p, 65) == message_p[10]);
+
+    uint8_t* const page_p = (uint8_t*)fsa_pool_alloc(page_pool_p, (40 * 1024) + 1);
+    uint8_t* const io_p = (uint8_t*)fsa_pool_alloc(io_pool_p, (1 << 20) + 1);
+    assert(page_p != NULL);
+    assert(io_p != NULL);
+
+    (void)memset(page_p, 0xaa, 40 * 1024);
+    (void)memset(io_p, 0xbb, 1 << 20);
+
+    /* pools do not share chunks with default pool and with each other */
+    assert(fsa_get_available_chunks(0) == 0x00);
+    assert(fsa_pool_alloc(io_pool_p, 1) == io_p + (17 << 16));
+    assert(fsa_pool_alloc(page_pool_p, 1) == page_p + (11 << 12));
+
+    /* pointer from another pool is ignored */
+    fsa_pool_dealloc(page_pool_p, io_p);
+    fsa_dealloc(page_p);
+    assert(fsa_pool_alloc(io_pool_p, 1) == io_p + (18 << 16));
+    assert(fsa_pool_alloc(page_pool_p, 1) == page_p + (12 << 12));
+
+    fsa_pool_dealloc(io_pool_p, io_p);
+    assert(fsa_pool_alloc(io_pool_p, (16 << 16) + 1) == io_p);
+
+    fsa_pool_destroy(message_pool_p);
+    fsa_pool_destroy(page_pool_p);
+    fsa_pool_destroy(io_pool_p);
+}
+
+static size_t __count_resident_pages(void* addr_p, const size_t size)
+{
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t nr_of_pages = (size + page_size - 1) / page_size;
+
+    unsigned char* const vec_p = (unsigned char*)calloc(nr_of_pages, sizeof(*vec_p));
+    assert(vec_p != NULL);
+
+    const int ret = mincore(addr_p, size, vec_p);
+    assert(ret == 0);
+    (void)ret;
+
+    size_t nr_of_resident = 0;
+
+    for (size_t i = 0; i < nr_of_pages; ++i)
+    {
+        nr_of_resident += vec_p[i] & 1;
+    }
+
+    free(vec_p);
+
+    return nr_of_resident;
+}
+
+static void test_mapped_pools(void)
+{
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t size_of_run = 8 << 20;
+
+    Fsa_pool* const pool_p = fsa_pool_create_mapped(64 << 20, 1 << 12, FSA_POOL_TRANSPARENT_HUGE_PAGES, 1 << 20);
+    assert(pool_p != NULL);
+
+    /* mapping is aligned to huge page and nothing is committed before first touch */
+    uint8_t* const run_p = (uint8_t*)fsa_pool_alloc(pool_p, size_of_run - 1);
+    assert(run_p != NULL);
+    assert((uintptr_t)run_p % FSA_HUGE_PAGE_SIZE == 0);
+    assert(__count_resident_pages(run_p, size_of_run) == 0);
+
+    (void)memset(run_p, 0xaa, size_of_run);
+    assert(__count_resident_pages(run_p, size_of_run) == size_of_run / page_size);
+
+    /* short run stays resident */
+    uint8_t* const small_p = (uint8_t*)fsa_pool_alloc(pool_p, 1);
+    assert(small_p == run_p + size_of_run);
+
+    (void)memset(small_p, 0xbb, 1 << 12);
+    fsa_pool_dealloc(pool_p, small_p);
+    assert(__count_resident_pages(small_p, 1 << 12) == (1 << 12) / page_size);
+
+    /* long run goes back to kernel and is zeroed on next touch */
+    fsa_pool_dealloc(pool_p, run_p);
+    assert(__count_resident_pages(run_p, size_of_run) == 0);
+
+    assert(fsa_pool_alloc(pool_p, size_of_run - 1) == run_p);
+    assert(run_p[0] == 0 && run_p[size_of_run - 1] == 0);
+
+    fsa_pool_destroy(pool_p);
+
+    /* without reserved huge pages explicit huge pages fall back to transparent ones */
+    Fsa_pool* const huge_pool_p = fsa_pool_create_mapped(3 << 20, 1 << 16, FSA_POOL_EXPLICIT_HUGE_PAGES, 0);
+    assert(huge_pool_p != NULL);
+
+    uint8_t* const huge_p = (uint8_t*)fsa_pool_alloc(huge_pool_p, (3 << 20) - 1);
+    assert(huge_p != NULL);
+    (void)memset(huge_p, 0xcc, 3 << 20);
+
+    fsa_pool_dealloc(huge_pool_p, huge_p);
+    fsa_pool_destroy(huge_pool_p);
+}
+
+static void test_statistics(void)
+{
+    fsa_init();
+
+    const size_t nr_of_chunks = MEMORY_SIZE / SIZE_OF_CHUNK;
+    Fsa_statistics stats;
+    Fsa_fragmentation frag;
+
+    /* free blocks are not counters, they are read from fragmentation report */
+    fsa_read_statistics(&stats);
+    fsa_read_fragmentation(&frag);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.bytes_in_use == 0 && stats.peak_bytes_in_use == 0);
+    assert(frag.nr_of_free_extents == 1 && frag.size_of_largest_free_extent == MEMORY_SIZE);
+    assert(stats.nr_of_allocs == 0 && stats.nr_of_frees == 0 && stats.nr_of_failures == 0);
+
+    /* 1 + 3 + 1 chunks */
+    void* const first_p = fsa_alloc(1);
+    void* const second_p = fsa_alloc(SIZE_OF_CHUNK * 3);
+    void* const third_p = fsa_alloc(1);
+    assert(first_p != NULL && second_p != NULL && third_p != NULL);
+
+    fsa_read_statistics(&stats);
+    fsa_read_fragmentation(&frag);
+    assert(stats.nr_of_chunks_in_use == 5 && stats.bytes_in_use == 5 * SIZE_OF_CHUNK);
+    assert(frag.nr_of_free_extents == 1 && frag.size_of_largest_free_extent == MEMORY_SIZE - 5 * SIZE_OF_CHUNK);
+
+    fsa_dealloc(second_p);
+    assert(fsa_alloc(MEMORY_SIZE) == NULL);
+
+    fsa_read_statistics(&stats);
+    fsa_read_fragmentation(&frag);
+    assert(stats.nr_of_chunks_in_use == 2 && stats.peak_bytes_in_use == 5 * SIZE_OF_CHUNK);
+    assert(frag.nr_of_free_extents == 2 && frag.size_of_largest_free_extent == MEMORY_SIZE - 5 * SIZE_OF_CHUNK);
+    assert(stats.nr_of_allocs == 3 && stats.nr_of_frees == 1 && stats.nr_of_failures == 1);
+
+    fsa_dealloc(first_p);
+    fsa_dealloc(third_p);
+
+    fsa_read_statistics(&stats);
+    fsa_read_fragmentation(&frag);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.nr_of_frees == 3);
+    assert(frag.nr_of_free_extents == 1 && frag.size_of_largest_free_extent == MEMORY_SIZE);
+
+    /* chunks 0, 63 and 64 stay allocated, the second free block starts in word 1 and ends at the end of memory */
+    void* address[130] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = fsa_alloc(1);
+        assert(address[i] != NULL);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        if (i != 0 && i != 63 && i != 64)
+        {
+            fsa_dealloc(address[i]);
+        }
+    }
+
+    fsa_read_statistics(&stats);
+    fsa_read_fragmentation(&frag);
+    assert(stats.nr_of_chunks_in_use == 3 && stats.peak_bytes_in_use == ARRAY_SIZE(address) * SIZE_OF_CHUNK);
+    assert(frag.nr_of_free_extents == 2);
+    assert(frag.size_of_largest_free_extent == (nr_of_chunks - 65) * SIZE_OF_CHUNK);
+
+    /* reset clears counters */
+    fsa_init();
+
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_allocs == 0 && stats.peak_bytes_in_use == 0 && stats.nr_of_chunks_in_use == 0);
+}
+
+static void test_fragmentation(void)
+{
+    fsa_init();
+
+    const size_t nr_of_chunks = MEMORY_SIZE / SIZE_OF_CHUNK;
+    const size_t last_bucket = (size_t)(63 - __builtin_clzll(nr_of_chunks));
+    Fsa_fragmentation frag;
+
+    fsa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 1 && frag.free_extents[last_bucket] == 1);
+    assert(frag.free_bytes == MEMORY_SIZE && frag.size_of_largest_free_extent == MEMORY_SIZE);
+    assert(frag.external_fragmentation == 0.0);
+    assert(frag.requested_bytes == 0 && frag.allocated_bytes == 0 && frag.internal_waste == 0.0);
+
+    /* 100 bytes take whole chunk */
+    void* address[10] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = fsa_alloc(100);
+        assert(address[i] != NULL);
+    }
+
+    /* free chunks 1, 3, 5 and 7 are single extents between allocated ones */
+    for (size_t i = 1; i < 8; i += 2)
+    {
+        fsa_dealloc(address[i]);
+    }
+
+    const size_t largest = nr_of_chunks - ARRAY_SIZE(address);
+    const size_t free = largest + 4;
+
+    fsa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 5 && frag.free_extents[0] == 4);
+    assert(frag.free_extents[(size_t)(63 - __builtin_clzll(largest))] == 1);
+    assert(frag.free_bytes == free * SIZE_OF_CHUNK && frag.size_of_largest_free_extent == largest * SIZE_OF_CHUNK);
+    assert(frag.external_fragmentation == 1.0 - (double)largest / (double)free);
+
+    /* waste is counted since init, frees do not change it */
+    assert(frag.requested_bytes == 1000 && frag.allocated_bytes == ARRAY_SIZE(address) * SIZE_OF_CHUNK);
+    assert(frag.internal_waste == 1.0 - 1000.0 / (double)(ARRAY_SIZE(address) * SIZE_OF_CHUNK));
+
+    /* 24 bytes take slot of 32 bytes, chunk carved into slots is not counted as request */
+    void* const slot_p = fsa_slab_alloc(24);
+    assert(slot_p != NULL);
+
+    /* multiple of chunk is not rounded up, two chunks are taken from the largest extent */
+    void* const run_p = fsa_alloc(2 * SIZE_OF_CHUNK);
+    assert(run_p != NULL);
+
+    fsa_read_fragmentation(&frag);
+    assert(frag.requested_bytes == 1000 + 24 + 2 * SIZE_OF_CHUNK);
+    assert(frag.allocated_bytes == (ARRAY_SIZE(address) + 2) * SIZE_OF_CHUNK + 32);
+
+    /* slab took the first free extent, so 3 single extents are left */
+    assert(frag.free_extents[0] == 3);
+
+    /* pool with small chunks */
+    static uint8_t region[64 * 64] __attribute__((aligned(64)));
+    Fsa_pool* const pool_p = fsa_pool_create(&region[0], sizeof(region), 64);
+    assert(pool_p != NULL);
+
+    /* 1 + 2 + 1 chunks, the middle run is freed */
+    void* const first_p = fsa_pool_alloc(pool_p, 10);
+    void* const second_p = fsa_pool_alloc(pool_p, 100);
+    void* const third_p = fsa_pool_alloc(pool_p, 10);
+    assert(first_p != NULL && second_p != NULL && third_p != NULL);
+
+    fsa_pool_dealloc(pool_p, second_p);
+
+    fsa_pool_read_fragmentation(pool_p, &frag);
+    assert(frag.nr_of_free_extents == 2 && frag.free_extents[1] == 1 && frag.free_extents[5] == 1);
+    assert(frag.free_bytes == 62 * 64 && frag.size_of_largest_free_extent == 60 * 64);
+    assert(frag.requested_bytes == 120 && frag.allocated_bytes == 4 * 64);
+
+    /* whole pool is allocated */
+    fsa_pool_dealloc(pool_p, third_p);
+    assert(fsa_pool_alloc(pool_p, 63 * 64 - 1) != NULL);
+
+    fsa_pool_read_fragmentation(pool_p, &frag);
+    assert(frag.nr_of_free_extents == 0 && frag.free_bytes == 0 && frag.external_fragmentation == 0.0);
+
+    fsa_pool_destroy(pool_p);
+
+    /* reset clears counters */
+    fsa_init();
+
+    fsa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 1 && frag.requested_bytes == 0 && frag.allocated_bytes == 0);
+}
+
+static void test_slab(void)
+{
+    fsa_init();
+
+    Fsa_statistics stats;
+    uint8_t* address[SIZE_OF_CHUNK / 16 + 1] = {0};
+
+    assert(fsa_slab_alloc(0) == NULL);
+
+    /* 9 - 16 bytes go to 16 B slots of one chunk */
+    for (size_t i = 0; i < ARRAY_SIZE(address) - 1; ++i)
+    {
+        address[i] = (uint8_t*)fsa_slab_alloc(9 + i % 8);
+        assert(address[i] == address[0] + i * 16);
+    }
+
+    assert((uintptr_t)address[0] % 16 == 0);
+
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 1);
+
+    /* chunk is full, next one is carved */
+    address[ARRAY_SIZE(address) - 1] = (uint8_t*)fsa_slab_alloc(16);
+    assert(address[ARRAY_SIZE(address) - 1] != NULL);
+
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 2);
+
+    /* freed slot is taken first */
+    fsa_dealloc(address[5]);
+    assert(fsa_slab_alloc(10) == address[5]);
+
+    /* empty chunk goes back to pool, the last one of size class is kept */
+    for (size_t i = 0; i < ARRAY_SIZE(address) - 1; ++i)
+    {
+        fsa_dealloc(address[i]);
+    }
+
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 1);
+
+    fsa_dealloc(address[ARRAY_SIZE(address) - 1]);
+
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 1);
+
+    /* each size class has got its own chunks */
+    uint8_t* const tiny_p = (uint8_t*)fsa_slab_alloc(1);
+    uint8_t* const big_p = (uint8_t*)fsa_slab_alloc(FSA_SLAB_MAX_SIZE);
+    uint8_t* const other_big_p = (uint8_t*)fsa_slab_alloc(FSA_SLAB_MAX_SIZE - 1);
+    assert(tiny_p != NULL && big_p != NULL && other_big_p == big_p + FSA_SLAB_MAX_SIZE);
+
+    (void)memset(tiny_p, 0x11, FSA_SLAB_MIN_SIZE);
+    (void)memset(big_p, 0x22, FSA_SLAB_MAX_SIZE);
+    (void)memset(other_big_p, 0x33, FSA_SLAB_MAX_SIZE);
+    assert(tiny_p[FSA_SLAB_MIN_SIZE - 1] == 0x11 && big_p[FSA_SLAB_MAX_SIZE - 1] == 0x22);
+
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 3);
+
+    /* usable size is size of slot */
+    assert(fsa_get_usable_size(tiny_p) == FSA_SLAB_MIN_SIZE);
+    assert(fsa_get_usable_size(other_big_p) == FSA_SLAB_MAX_SIZE);
+
+    /* bigger requests take whole chunks */
+    uint8_t* const chunk_p = (uint8_t*)fsa_slab_alloc(FSA_SLAB_MAX_SIZE + 1);
+    assert(chunk_p != NULL && (chunk_p - (uint8_t*)fsa_get_address_from_memory(0)) % SIZE_OF_CHUNK == 0);
+    assert(fsa_get_usable_size(chunk_p) == SIZE_OF_CHUNK);
+    assert(fsa_get_usable_size(chunk_p + 1) == 0 && fsa_get_usable_size(&stats) == 0);
+
+    fsa_dealloc(chunk_p);
+    fsa_dealloc(tiny_p);
+    fsa_dealloc(big_p);
+    fsa_dealloc(other_big_p);
+
+    /* slot can not be bigger than half of chunk in pool with small chunks */
+    static uint8_t region[64 * 4] __attribute__((aligned(64)));
+    Fsa_pool* const pool_p = fsa_pool_create(&region[0], sizeof(region), 64);
+    assert(pool_p != NULL);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        assert(fsa_pool_slab_alloc(pool_p, 16) == &region[i * 16]);
+    }
+
+    assert(fsa_pool_slab_alloc(pool_p, 40) == &region[64]);
+
+    fsa_pool_destroy(pool_p);
+
+    /* slab locks taken before fork are released in parent and in child, so both of them can use slab after it */
+    fsa_lock();
+
+    const pid_t pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0)
+    {
+        fsa_unlock();
+        _exit(fsa_slab_alloc(24) != NULL ? 0 : 1);
+    }
+
+    fsa_unlock();
+
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    void* const slot_p = fsa_slab_alloc(24);
+    assert(slot_p != NULL);
+    fsa_dealloc(slot_p);
+}
+
+static void test_reset(void)
+{
+    fsa_init();
+
+    /* memory is not zeroed by init */
+    uint8_t* const chunk_p = (uint8_t*)fsa_alloc(1);
+    (void)memset(chunk_p, 0xee, SIZE_OF_CHUNK);
+
+    fsa_init();
+    assert(fsa_alloc(1) == chunk_p && chunk_p[0] == 0xee && chunk_p[SIZE_OF_CHUNK - 1] == 0xee);
+
+    uint32_t* const array_p = (uint32_t*)fsa_calloc(SIZE_OF_CHUNK / sizeof(uint32_t), sizeof(uint32_t));
+    assert(array_p != NULL);
+
+    for (size_t i = 0; i < SIZE_OF_CHUNK / sizeof(uint32_t); ++i)
+    {
+        assert(array_p[i] == 0);
+    }
+
+    assert(fsa_calloc(SIZE_MAX / 2, 3) == NULL);
+
+    /* 1 GB pool, reset has to touch only bitmap and descriptors of allocated chunks */
+    const size_t size = (size_t)1 << 30;
+    Fsa_pool* const pool_p = fsa_pool_create_mapped(size, SIZE_OF_CHUNK, 0, 0);
+    assert(pool_p != NULL);
+
+    uint8_t* const first_p = (uint8_t*)fsa_pool_alloc(pool_p, 1);
+    uint8_t* const slot_p = (uint8_t*)fsa_pool_slab_alloc(pool_p, 100);
+    uint8_t* const run_p = (uint8_t*)fsa_pool_alloc(pool_p, 3 * SIZE_OF_CHUNK);
+    assert(first_p != NULL && slot_p != NULL && run_p != NULL);
+
+    first_p[0] = 1;
+    slot_p[0] = 2;
+    run_p[0] = 3;
+
+    const size_t nr_of_resident = __count_resident_pages(first_p, size);
+
+    fsa_pool_reset(pool_p);
+
+    assert(__count_resident_pages(first_p, size) == nr_of_resident);
+
+    Fsa_statistics stats;
+    Fsa_fragmentation frag;
+    fsa_pool_read_statistics(pool_p, &stats);
+    fsa_pool_read_fragmentation(pool_p, &frag);
+    assert(stats.nr_of_chunks_in_use == 0);
+    assert(frag.nr_of_free_extents == 1 && frag.size_of_largest_free_extent == size);
+
+    /* chunk of slab is whole chunk again, freed run has not got its size */
+    assert(fsa_pool_get_usable_size(pool_p, slot_p) == 0);
+    assert(fsa_pool_get_usable_size(pool_p, run_p) == 0);
+
+    uint8_t* const chunks_p = (uint8_t*)fsa_pool_alloc(pool_p, 5 * SIZE_OF_CHUNK - 1);
+    assert(chunks_p == first_p && fsa_pool_get_usable_size(pool_p, chunks_p) == 5 * SIZE_OF_CHUNK);
+    assert(chunks_p[0] == 1);
+
+    fsa_pool_dealloc(pool_p, chunks_p);
+    fsa_pool_read_statistics(pool_p, &stats);
+    assert(stats.nr_of_chunks_in_use == 0);
+
+    fsa_pool_destroy(pool_p);
+}
+
+#ifdef FSA_THREAD_CACHE
+
+static void test_thread_cache(void)
+{
+    fsa_init();
+    fsa_cache_set_high_water_mark(8);
+
+    /* cache takes 4 chunks from bitmap */
+    void* ptr_p = fsa_alloc(1);
+    assert(ptr_p == fsa_get_address_from_memory(0));
+    assert(fsa_get_number_of_chunks(0) == 1);
+    assert(fsa_get_available_chunks(0) == 0x0f);
+
+    /* chunk goes back to cache, not to bitmap */
+    fsa_dealloc(ptr_p);
+    assert(fsa_get_number_of_chunks(0) == 0);
+    assert(fsa_get_available_chunks(0) == 0x0f);
+    assert(fsa_alloc(1) == ptr_p);
+
+    void* address[8] = {ptr_p};
+
+    for (size_t i = 1; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = fsa_alloc(1);
+        assert(address[i] == fsa_get_address_from_memory(i * PAGE_SIZE));
+    }
+
+    assert(fsa_get_available_chunks(0) == 0xff);
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        fsa_dealloc(address[i]);
+    }
+
+    assert(fsa_get_available_chunks(0) == 0xff);
+
+    /* the oldest chunks are given back */
+    fsa_cache_set_high_water_mark(4);
+    assert(fsa_get_available_chunks(0) == 0xf0);
+
+    fsa_cache_flush();
+    assert(fsa_get_available_chunks(0) == 0x00);
+
+    /* chunks 0 - 5 are taken by cache, 5 of them are allocated */
+    for (size_t i = 0; i < 5; ++i)
+    {
+        address[i] = fsa_alloc(1);
+        assert(address[i] == fsa_get_address_from_memory(i * PAGE_SIZE));
+    }
+
+    assert(fsa_get_available_chunks(0) == 0x3f);
+
+    /* cache is full when 4th chunk comes, chunks 5 and 0 are given back */
+    for (size_t i = 0; i < 5; ++i)
+    {
+        fsa_dealloc(address[i]);
+    }
+
+    assert(fsa_get_available_chunks(0) == 0x1e);
+
+    fsa_cache_set_high_water_mark(0);
+    assert(fsa_get_available_chunks(0) == 0x00);
+
+    /* counts of cached allocations are added to pool when cache is trimmed */
+    Fsa_statistics stats;
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_allocs == 14 && stats.nr_of_frees == 14 && stats.nr_of_chunks_in_use == 0);
+
+    Fsa_fragmentation frag;
+    fsa_read_fragmentation(&frag);
+    assert(frag.requested_bytes == 14 && frag.allocated_bytes == 14 * PAGE_SIZE);
+}
+
+#endif
+
+#ifdef FSA_THREAD_SAFE
+
+static void* __stress_thread(void* arg_p)
+{
+    const uint8_t id = (uint8_t)(uintptr_t)arg_p;
+    uint8_t* address[NR_OF_LIVE_ALLOCATIONS] = {0};
+    size_t chunks[NR_OF_LIVE_ALLOCATIONS] = {0};
+    unsigned int seed = id;
+
+    for (size_t i = 0; i < NR_OF_ITERATIONS / 4; ++i)
+    {
+        const size_t slot = i % NR_OF_LIVE_ALLOCATIONS;
+
+        if (address[slot] != NULL)
+        {
+            for (size_t j = 0; j < chunks[slot]; ++j)
+            {
+                assert(address[slot][j * PAGE_SIZE] == id);
+                assert(address[slot][(j + 1) * PAGE_SIZE - 1] == id);
+            }
+
+            fsa_dealloc(address[slot]);
+            address[slot] = NULL;
+        }
+
+        chunks[slot] = (size_t)(rand_r(&seed) % 4) + 1;
+        address[slot] = fsa_alloc((chunks[slot] - 1) * PAGE_SIZE + 1);
+
+        /* memory could be exhausted by other threads */
+        if (address[slot] != NULL)
+        {
+            for (size_t j = 0; j < chunks[slot]; ++j)
+            {
+                address[slot][j * PAGE_SIZE] = id;
+                address[slot][(j + 1) * PAGE_SIZE - 1] = id;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < NR_OF_LIVE_ALLOCATIONS; ++i)
+    {
+        fsa_dealloc(address[i]);
+    }
+
+    return NULL;
+}
+
+static void* __slab_stress_thread(void* arg_p)
+{
+    const uint8_t id = (uint8_t)(uintptr_t)arg_p;
+    uint8_t* address[NR_OF_LIVE_ALLOCATIONS] = {0};
+    size_t sizes[NR_OF_LIVE_ALLOCATIONS] = {0};
+    unsigned int seed = id;
+
+    for (size_t i = 0; i < NR_OF_ITERATIONS; ++i)
+    {
+        const size_t slot = i % NR_OF_LIVE_ALLOCATIONS;
+
+        if (address[slot] != NULL)
+        {
+            assert(address[slot][0] == id);
+            assert(address[slot][sizes[slot] - 1] == id);
+
+            fsa_dealloc(address[slot]);
+            address[slot] = NULL;
+        }
+
+        sizes[slot] = (size_t)(rand_r(&seed) % FSA_SLAB_MAX_SIZE) + 1;
+        address[slot] = (uint8_t*)fsa_slab_alloc(sizes[slot]);
+
+        if (address[slot] != NULL)
+        {
+            address[slot][0] = id;
+            address[slot][sizes[slot] - 1] = id;
+        }
+    }
+
+    for (size_t i = 0; i < NR_OF_LIVE_ALLOCATIONS; ++i)
+    {
+        fsa_dealloc(address[i]);
+    }
+
+    return NULL;
+}
+
+static void* __benchmark_thread(void* arg_p)
+{
+    (void)arg_p;
+
+    for (size_t i = 0; i < NR_OF_ITERATIONS; ++i)
+    {
+        void* ptr_p = fsa_alloc(1);
+        assert(ptr_p != NULL);
+
+        fsa_dealloc(ptr_p);
+    }
+
+    return NULL;
+}
+
+static void __run_threads(void* (*routine)(void*), const size_t nr_of_threads)
+{
+    pthread_t threads[MAX_NR_OF_THREADS];
+
+    for (size_t i = 0; i < nr_of_threads; ++i)
+    {
+        const int ret = pthread_create(&threads[i], NULL, routine, (void*)(uintptr_t)(i + 1));
+        assert(ret == 0);
+        (void)ret;
+    }
+
+    for (size_t i = 0; i < nr_of_threads; ++i)
+    {
+        (void)pthread_join(threads[i], NULL);
+    }
+}
+
+static void test_threads_stress(void)
+{
+    fsa_init();
+
+    __run_threads(__stress_thread, MAX_NR_OF_THREADS);
+
+    for (size_t i = 0; i < fsa_get_size_of_available_chunks(); ++i)
+    {
+        assert(fsa_get_available_chunks(i) == 0x00);
+    }
+
+    for (size_t i = 0; i < fsa_get_size_of_number_of_chunks(); ++i)
+    {
+        assert(fsa_get_number_of_chunks(i) == 0);
+    }
+
+    /* only the last empty chunk of each size class is kept by slab layer */
+    __run_threads(__slab_stress_thread, MAX_NR_OF_THREADS);
+
+    Fsa_statistics stats;
+    fsa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use <= FSA_SLAB_NR_OF_CLASSES);
+}
+
+static void benchmark_threads_scaling(void)
+{
+    fsa_init();
+
+    const long nr_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t max_threads = nr_of_cpus > 0 && nr_of_cpus < MAX_NR_OF_THREADS ? (size_t)nr_of_cpus
+                                                                                : MAX_NR_OF_THREADS;
+
+    printf("FSA THREADS SCALING, %d alloc/dealloc per thread\n", NR_OF_ITERATIONS);
+
+    /* powers of two and at the end number of cpus, also if it is not power of two */
+    for (size_t i = 1; i <= max_threads; i = (i << 1) > max_threads && i < max_threads ? max_threads : i << 1)
+    {
+        printf("threads = %zu\n", i);
+        MEASURE_FUNCTION(__run_threads(__benchmark_thread, i), "fsa_alloc/fsa_dealloc");
+    }
+}
+
+#endif
+
+static void test_generated_pools(void)
+{
+    static uint8_t* chunks[NR_OF_BIG_POOL_CHUNKS];
+
+    assert(small_pool_alloc() != NULL && small_pool_get_nr_of_chunks_in_use() == 1);
+    small_pool_reset();
+    assert(small_pool_get_nr_of_chunks_in_use() == 0);
+
+    for (size_t i = 0; i < NR_OF_SMALL_POOL_CHUNKS; ++i)
+    {
+        chunks[i] = small_pool_alloc();
+
+        /* the lowest free chunk is taken, so chunks follow each other */
+        assert(chunks[i] != NULL && ((uintptr_t)chunks[i] & 63) == 0);
+        assert(i == 0 || chunks[i] == chunks[i - 1] + 64);
+        assert(small_pool_owns(chunks[i]));
+    }
+
+    assert(small_pool_alloc() == NULL && small_pool_get_nr_of_chunks_in_use() == NR_OF_SMALL_POOL_CHUNKS);
+
+    /* NULL, address outside of pool and address inside of chunk are ignored */
+    uint8_t foreign = 0;
+    small_pool_free(NULL);
+    small_pool_free(&foreign);
+    small_pool_free(chunks[10] + 1);
+    assert(!small_pool_owns(&foreign));
+    assert(small_pool_get_nr_of_chunks_in_use() == NR_OF_SMALL_POOL_CHUNKS);
+
+    small_pool_free(chunks[700]);
+    small_pool_free(chunks[700]);
+    small_pool_free(chunks[5]);
+    assert(small_pool_get_nr_of_chunks_in_use() == NR_OF_SMALL_POOL_CHUNKS - 2);
+
+    assert(small_pool_alloc() == chunks[5]);
+    assert(small_pool_alloc() == chunks[700]);
+    assert(small_pool_alloc() == NULL);
+
+    for (size_t i = 0; i < NR_OF_SMALL_POOL_CHUNKS; ++i)
+    {
+        small_pool_free(chunks[i]);
+    }
+
+    assert(small_pool_get_nr_of_chunks_in_use() == 0);
+
+    /* more than 4096 chunks, so words of the second summary word are used too */
+    for (size_t i = 0; i < NR_OF_BIG_POOL_CHUNKS; ++i)
+    {
+        chunks[i] = big_pool_alloc();
+        assert(chunks[i] != NULL && ((uintptr_t)chunks[i] & 15) == 0);
+        assert(i == 0 || chunks[i] == chunks[i - 1] + 16);
+    }
+
+    assert(big_pool_alloc() == NULL);
+
+    big_pool_free(chunks[4100]);
+    big_pool_free(chunks[64]);
+    assert(big_pool_alloc() == chunks[64]);
+    assert(big_pool_alloc() == chunks[4100]);
+
+    big_pool_reset();
+    assert(big_pool_get_nr_of_chunks_in_use() == 0 && big_pool_alloc() == chunks[0]);
+    big_pool_reset();
+}
+
+static void __generated_pool_loop(void)
+{
+    void* live[NR_OF_POOL_LIVE_CHUNKS] = {NULL};
+
+    for (size_t i = 0; i < NR_OF_POOL_ITERATIONS; ++i)
+    {
+        const size_t slot = (i * 7) % NR_OF_POOL_LIVE_CHUNKS;
+
+        small_pool_free(live[slot]);
+        live[slot] = small_pool_alloc();
+    }
+
+    for (size_t i = 0; i < NR_OF_POOL_LIVE_CHUNKS; ++i)
+    {
+        small_pool_free(live[i]);
+    }
+}
+
+static void __runtime_pool_loop(Fsa_pool* pool_p)
+{
+    void* live[NR_OF_POOL_LIVE_CHUNKS] = {NULL};
+
+    for (size_t i = 0; i < NR_OF_POOL_ITERATIONS; ++i)
+    {
+        const size_t slot = (i * 7) % NR_OF_POOL_LIVE_CHUNKS;
+
+        fsa_pool_dealloc(pool_p, live[slot]);
+        live[slot] = fsa_pool_alloc(pool_p, 1);
+    }
+
+    for (size_t i = 0; i < NR_OF_POOL_LIVE_CHUNKS; ++i)
+    {
+        fsa_pool_dealloc(pool_p, live[i]);
+    }
+}
+
+static void benchmark_generated_pool(void)
+{
+    Fsa_pool* const pool_p = fsa_pool_create(NULL, 64 * NR_OF_SMALL_POOL_CHUNKS, 64);
+    assert(pool_p != NULL);
+
+    printf("GENERATED POOL, 64 B chunks, %d allocations\n", NR_OF_POOL_ITERATIONS);
+
+    MEASURE_FUNCTION(__runtime_pool_loop(pool_p), "runtime pool");
+    MEASURE_FUNCTION(__generated_pool_loop(), "generated pool");
+
+    assert(small_pool_get_nr_of_chunks_in_use() == 0);
+
+    fsa_pool_destroy(pool_p);
+}
+
+static void test_shared_pools(void)
+{
+    const int fd = memfd_create("fsa_shared_pool", 0);
+    assert(fd >= 0);
+
+    /* empty file has got no pool */
+    assert(fsa_pool_attach_shared(fd) == NULL);
+    assert(fsa_pool_create_shared(fd, SHARED_POOL_CHUNK_SIZE, 100) == NULL);
+
+    Fsa_pool* const pool_p =
+        fsa_pool_create_shared(fd, SHARED_POOL_NR_OF_CHUNKS * SHARED_POOL_CHUNK_SIZE, SHARED_POOL_CHUNK_SIZE);
+    assert(pool_p != NULL);
+
+    /* the second mapping of the same file is at other address, buffer is found there by offset */
+    Fsa_pool* const view_p = fsa_pool_attach_shared(fd);
+    assert(view_p != NULL);
+
+    uint8_t* const buffer_p = (uint8_t*)fsa_pool_alloc(pool_p, 100);
+    assert(buffer_p != NULL);
+    (void)memset(buffer_p, 0xab, 100);
+
+    const size_t offset = fsa_pool_get_offset(pool_p, buffer_p);
+    assert(offset != FSA_INVALID_OFFSET && offset % SHARED_POOL_CHUNK_SIZE == 0);
+
+    uint8_t* const view_buffer_p = (uint8_t*)fsa_pool_get_address(view_p, offset);
+    assert(view_buffer_p != NULL && view_buffer_p != buffer_p && view_buffer_p[99] == 0xab);
+
+    assert(fsa_pool_get_offset(view_p, buffer_p) == FSA_INVALID_OFFSET);
+    assert(fsa_pool_get_offset(view_p, NULL) == FSA_INVALID_OFFSET);
+    assert(fsa_pool_get_address(view_p, SHARED_POOL_NR_OF_CHUNKS * SHARED_POOL_CHUNK_SIZE) == NULL);
+
+    /* bitmap is shared, so chunk freed through one mapping is taken again through the other one */
+    fsa_pool_dealloc(view_p, view_buffer_p);
+    assert(fsa_pool_alloc(pool_p, 100) == buffer_p);
+
+    /* child fills slots and hands them over by offsets written to shared buffer */
+    size_t* const offsets_p = (size_t*)(void*)buffer_p;
+    const pid_t pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0)
+    {
+        Fsa_pool* const child_pool_p = fsa_pool_attach_shared(fd);
+        assert(child_pool_p != NULL);
+
+        size_t* const child_offsets_p = (size_t*)fsa_pool_get_address(child_pool_p, offset);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            uint8_t* const slot_p = (uint8_t*)fsa_pool_slab_alloc(child_pool_p, 32);
+            assert(slot_p != NULL);
+
+            (void)memset(slot_p, (int)i + 1, 32);
+            child_offsets_p[i] = fsa_pool_get_offset(child_pool_p, slot_p);
+        }
+
+        fsa_pool_destroy(child_pool_p);
+        _exit(0);
+    }
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        uint8_t* const slot_p = (uint8_t*)fsa_pool_get_address(pool_p, offsets_p[i]);
+        assert(slot_p != NULL && slot_p[0] == i + 1 && slot_p[31] == i + 1);
+
+        fsa_pool_dealloc(pool_p, slot_p);
+    }
+
+    /* counters are in shared region too */
+    Fsa_fragmentation frag;
+    fsa_pool_read_fragmentation(view_p, &frag);
+    assert(frag.requested_bytes == 100 + 100 + 4 * 32);
+
+    Fsa_statistics stats;
+    fsa_pool_read_statistics(view_p, &stats);
+
+    const size_t nr_of_chunks_in_use = stats.nr_of_chunks_in_use;
+    assert(stats.nr_of_failures == 0);
+
+#ifdef FSA_THREAD_SAFE
+    /* processes allocate and free in the same pool at the same time */
+    pid_t pids[3];
+
+    for (size_t i = 0; i < ARRAY_SIZE(pids); ++i)
+    {
+        pids[i] = fork();
+        assert(pids[i] >= 0);
+
+        if (pids[i] == 0)
+        {
+            Fsa_pool* const child_pool_p = fsa_pool_attach_shared(fd);
+            assert(child_pool_p != NULL);
+
+            __shared_pool_loop(child_pool_p, (uint8_t)(i + 1));
+            _exit(0);
+        }
+    }
+
+    __shared_pool_loop(pool_p, 0xff);
+
+    for (size_t i = 0; i < ARRAY_SIZE(pids); ++i)
+    {
+        assert(waitpid(pids[i], &status, 0) == pids[i] && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    fsa_pool_read_statistics(view_p, &stats);
+    assert(stats.nr_of_chunks_in_use == nr_of_chunks_in_use && stats.nr_of_failures == 0);
+#else
+    (void)nr_of_chunks_in_use;
+#endif
+
+    /* pool created again over the same file starts empty */
+    fsa_pool_destroy(view_p);
+    fsa_pool_destroy(pool_p);
+
+    Fsa_pool* const new_pool_p = fsa_pool_create_shared(fd, 4 * SHARED_POOL_CHUNK_SIZE, SHARED_POOL_CHUNK_SIZE);
+    assert(new_pool_p != NULL);
+
+    fsa_pool_read_statistics(new_pool_p, &stats);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.nr_of_allocs == 0);
+
+    fsa_pool_read_fragmentation(new_pool_p, &frag);
+    assert(frag.nr_of_free_extents == 1 && frag.size_of_largest_free_extent == 4 * SHARED_POOL_CHUNK_SIZE);
+
+    fsa_pool_destroy(new_pool_p);
+    (void)close(fd);
+}
+
+#ifdef FSA_THREAD_SAFE
+
+static void __shared_pool_loop(Fsa_pool* pool_p, const uint8_t pattern)
+{
+    uint8_t* live[NR_OF_LIVE_SHARED_BUFFERS] = {NULL};
+    unsigned int seed = pattern;
+
+    for (size_t i = 0; i < NR_OF_SHARED_ITERATIONS; ++i)
+    {
+        const size_t slot = i % ARRAY_SIZE(live);
+
+        if (live[slot] != NULL)
+        {
+            /* the shortest buffer has got one byte less than chunk */
+            assert(live[slot][0] == pattern && live[slot][SHARED_POOL_CHUNK_SIZE - 2] == pattern);
+            fsa_pool_dealloc(pool_p, live[slot]);
+        }
+
+        /* 1 - 3 chunks */
+        const size_t bytes = SHARED_POOL_CHUNK_SIZE * (size_t)(rand_r(&seed) % 3) + SHARED_POOL_CHUNK_SIZE - 1;
+
+        live[slot] = (uint8_t*)fsa_pool_alloc(pool_p, bytes);
+        assert(live[slot] != NULL);
+
+        (void)memset(live[slot], pattern, bytes);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(live); ++i)
+    {
+        fsa_pool_dealloc(pool_p, live[i]);
+    }
+}
+
+#endif
+
+/* ----------------------------------------------- MAIN FUNCTION --------------------------------------------------- */
+
+int main(void)
+{
+    /* tests below check bitmap after each call, so chunks can not stay in cache */
+    fsa_cache_set_high_water_mark(0);
+
+    test_allocations();
+    test_allocations_between_index();
+    test_frees();
+    test_allocations_find_empty_bits();
+    test_allocations_between_words();
+    test_allocations_long_runs();
+    test_pools();
+    test_mapped_pools();
+    test_statistics();
+    test_fragmentation();
+    test_slab();
+    test_reset();
+    test_shared_pools();
+    test_generated_pools();
+
+#ifdef FSA_THREAD_CACHE
+    test_thread_cache();
+#endif
+
+#ifdef FSA_THREAD_SAFE
+    test_threads_stress();
+    benchmark_threads_scaling();
+#endif
+
+    benchmark_generated_pool();
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef MALLOC_INTERPOSER_H
+#define MALLOC_INTERPOSER_H
+
+/*
+    Implementation of malloc, free, calloc, realloc, posix_memalign, aligned_alloc, memalign, valloc, pvalloc and
+    malloc_usable_size on top of fixed-size and split-size allocators. Built as shared library it replaces allocator of
+    unmodified binary by LD_PRELOAD, for example LD_PRELOAD=./libmalloc_interposer.so ./service.
+
+    Requests up to INTERPOSER_SLAB_MAX_SIZE bytes are served by slab layer of fsa (lock-free, FSA_THREAD_SAFE), bigger
+    requests and small ones which do not fit in fsa memory are served by ssa under one mutex. Owner of address is
+    found by range of fsa memory, so free does not need any header or lookup.
+
+    If environment variable INTERPOSER_TRACE keeps path, each operation is recorded to this file in format of
+    trace_replay.h, so it can be replayed on other allocators. Operations are serialized while trace is recorded. Forked
+    child does not record, program executed by traced one inherits variable and overwrites the file.
+
+    Nothing is forwarded to libc allocator, so dlsym is never called and there is no bootstrap allocation. Allocators
+    are initialized by the first call from any thread.
+
+    author: Kamil Kielbasa
+    email: dusergithub@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <fixed_size_allocator.h>
+#include <split_size_allocator.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* the biggest request served by fsa slab layer, could be passed in compile time by -D option */
+#ifndef INTERPOSER_SLAB_MAX_SIZE
+#define INTERPOSER_SLAB_MAX_SIZE FSA_SLAB_MAX_SIZE
+#endif
+
+/* number of trace events written to file at once, could be passed in compile time by -D option */
+#ifndef INTERPOSER_TRACE_BUFFER_SIZE
+#define INTERPOSER_TRACE_BUFFER_SIZE 4096
+#endif
+
+/* smaller requests are rounded up, so each address returned by malloc is aligned as max_align_t */
+#define INTERPOSER_MIN_ALIGNMENT 16
+
+/*
+    Statistics of both allocators. If environment variable INTERPOSER_STATISTICS is set, they are printed to stderr
+    when program exits.
+*/
+struct Interposer_statistics
+{
+    Fsa_statistics slab;
+    Ssa_statistics split;
+};
+
+typedef struct Interposer_statistics Interposer_statistics;
+
+/*
+    This function fill statistics of both allocators.
+
+    PARAMS:
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void interposer_read_statistics(Interposer_statistics* stats_p);
+
+/*
+    This function is responsible for print statistics of both allocators (see interposer_read_statistics) to stdio.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void interposer_get_statistics(void);
+
+/*
+    This function start recording of trace to file, see trace_replay.h. Events of previous recording are lost.
+
+    PARAMS:
+    @IN path - path of trace file.
+
+    RETURN:
+    @true if success.
+    @false if file can not be written or trace is already recorded.
+*/
+bool interposer_trace_start(const char* path);
+
+/*
+    This function write buffered events and stop recording of trace.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void interposer_trace_stop(void);
+
+#endif /* MALLOC_INTERPOSER_H */
@@ -0,0 +1,829 @@
+/* pvalloc and valloc are GNU extensions */
+#define _GNU_SOURCE
+
+#include <malloc_interposer.h>
+#include <trace_replay.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+#if INTERPOSER_SLAB_MAX_SIZE > FSA_SLAB_MAX_SIZE
+#error "INTERPOSER_SLAB_MAX_SIZE can not be bigger than FSA_SLAB_MAX_SIZE"
+#endif
+
+/* size has got 48 bits in trace event */
+#define TRACE_SIZE_MASK (((uint64_t)1 << 48) - 1)
+
+/* thread has got 12 bits in trace event */
+#define TRACE_THREAD_MASK ((1 << 12) - 1)
+
+#ifndef FSA_THREAD_SAFE
+#error "fixed-size allocator has to be built with FSA_THREAD_SAFE"
+#endif
+
+/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+
+/* ssa is not thread safe, each call goes under this lock */
+static pthread_mutex_t ssa_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* set by the first call, after both allocators are initialized */
+static bool is_initialized;
+
+/* range of fsa memory, addresses inside belong to slab layer */
+static const uint8_t* slab_begin_p;
+static const uint8_t* slab_end_p;
+
+/* operations are done and recorded under this lock while trace is recorded, so order of events is order of them */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool is_tracing;
+
+/* events are written to file when buffer is full */
+static int trace_fd = -1;
+static Trace_event trace_buffer[INTERPOSER_TRACE_BUFFER_SIZE];
+static size_t trace_buffer_length;
+
+static struct timespec trace_start;
+static uint32_t nr_of_trace_threads;
+
+/* index of calling thread in trace plus one, 0 if thread has not recorded anything */
+static __thread uint32_t trace_thread __attribute__((tls_model("initial-exec")));
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+    This function initialize both allocators once, the first caller does it under ssa lock.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static inline void __init(void);
+
+/*
+    This function check if address was allocated by fsa slab layer.
+
+    PARAMS:
+    @IN addr_p - allocated address.
+
+    RETURN:
+    @true if address is inside fsa memory.
+    @false otherwise.
+*/
+static inline bool __is_slab_address(const void* addr_p);
+
+/*
+    This function allocate memory from slab layer if @bytes is small enough and from ssa otherwise (or if fsa memory
+    is full).
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __alloc(const size_t bytes);
+
+/*
+    This function allocate zeroed memory like __alloc. Only slot of slab layer is zeroed here, ssa zeroes its chunk
+    itself and does not touch pages of fresh mapping.
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __calloc(const size_t bytes);
+
+/*
+    This function free memory allocated by __alloc or __alloc_aligned.
+
+    PARAMS:
+    @IN addr_p - pointer to memory for freeing.
+
+    RETURN:
+    This is void function.
+*/
+static void __free(void* addr_p);
+
+/*
+    This function allocate memory aligned to @alignment. Slots of slab layer are aligned to their size, so small
+    requests are served by slot of size not smaller than @alignment.
+
+    PARAMS:
+    @IN alignment - power of two.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __alloc_aligned(const size_t alignment, const size_t bytes);
+
+/*
+    This function change size of memory allocated by __alloc or __alloc_aligned.
+
+    PARAMS:
+    @IN addr_p - pointer to allocated memory.
+    @IN bytes - new memory size in bytes.
+
+    RETURN:
+    @NULL if failure (memory is not freed).
+    @address if success.
+*/
+static void* __realloc(void* addr_p, const size_t bytes);
+
+/*
+    This function check alignment and allocate aligned memory, as aligned_alloc does.
+
+    PARAMS:
+    @IN alignment - requested alignment.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __aligned_alloc(const size_t alignment, const size_t bytes);
+
+/*
+    This function take trace lock if trace is recorded. It is called before each operation.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    @true if trace is recorded, operation has to be finished by __trace_end.
+    @false otherwise.
+*/
+static inline bool __trace_begin(void);
+
+/*
+    This function record event if trace is recorded and release trace lock.
+
+    PARAMS:
+    @IN is_traced - value returned by __trace_begin.
+    @IN type - type of event.
+    @IN id - address of block, nothing is recorded if it is NULL.
+    @IN new_id - address of block after realloc.
+    @IN size - requested bytes.
+
+    RETURN:
+    This is void function.
+*/
+static inline void __trace_end(const bool is_traced,
+                               const unsigned int type,
+                               const void* id,
+                               const void* new_id,
+                               const size_t size);
+
+/*
+    This function write buffered events to trace file, trace lock has to be taken.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __trace_flush(void);
+
+/*
+    This function print statistics of both allocators to @stream_p.
+
+    PARAMS:
+    @IN stream_p - output stream.
+
+    RETURN:
+    This is void function.
+*/
+static void __statistics_print(FILE* stream_p);
+
+/*
+    Fork handlers, child gets ssa and fsa slab layer in consistent state and unlocked. Child does not record trace of
+    parent.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __fork_prepare(void);
+static void __fork_parent(void);
+static void __fork_child(void);
+
+/*
+    Constructor of library, it register fork handlers and start recording of trace if environment variable
+    INTERPOSER_TRACE keeps path of trace file. pthread_atfork could allocate, so it is not called by __init under ssa
+    lock.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __constructor(void) __attribute__((constructor));
+
+/*
+    Destructor of library, it stop recording of trace and print statistics to stderr if environment variable
+    INTERPOSER_STATISTICS is set. Stdout of program is not touched, because it could be read by another program.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __destructor(void) __attribute__((destructor));
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline void __init(void)
+{
+    if (__atomic_load_n(&is_initialized, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    (void)pthread_mutex_lock(&ssa_lock);
+
+    if (!__atomic_load_n(&is_initialized, __ATOMIC_RELAXED))
+    {
+        fsa_init();
+        ssa_init();
+
+        slab_begin_p = (const uint8_t*)fsa_get_address_from_memory(0);
+        slab_end_p = slab_begin_p + fsa_get_size_of_memory();
+
+        __atomic_store_n(&is_initialized, true, __ATOMIC_RELEASE);
+    }
+
+    (void)pthread_mutex_unlock(&ssa_lock);
+}
+
+static inline bool __is_slab_address(const void* addr_p)
+{
+    return (const uint8_t*)addr_p >= slab_begin_p && (const uint8_t*)addr_p < slab_end_p;
+}
+
+static void* __alloc(const size_t bytes)
+{
+    __init();
+
+    /* malloc(0) returns unique address */
+    const size_t size = bytes == 0 ? 1 : bytes;
+
+    if (size <= INTERPOSER_SLAB_MAX_SIZE)
+    {
+        void* const addr_p = fsa_slab_alloc(size < INTERPOSER_MIN_ALIGNMENT ? INTERPOSER_MIN_ALIGNMENT : size);
+
+        if (addr_p != NULL)
+        {
+            return addr_p;
+        }
+    }
+
+    (void)pthread_mutex_lock(&ssa_lock);
+    void* const addr_p = ssa_alloc(size);
+    (void)pthread_mutex_unlock(&ssa_lock);
+
+    if (addr_p == NULL)
+    {
+        errno = ENOMEM;
+    }
+
+    return addr_p;
+}
+
+static void* __calloc(const size_t bytes)
+{
+    __init();
+
+    const size_t size = bytes == 0 ? 1 : bytes;
+
+    if (size <= INTERPOSER_SLAB_MAX_SIZE)
+    {
+        void* const addr_p = fsa_slab_alloc(size < INTERPOSER_MIN_ALIGNMENT ? INTERPOSER_MIN_ALIGNMENT : size);
+
+        if (addr_p != NULL)
+        {
+            return memset(addr_p, 0, size);
+        }
+    }
+
+    (void)pthread_mutex_lock(&ssa_lock);
+    void* const addr_p = ssa_calloc(1, size);
+    (void)pthread_mutex_unlock(&ssa_lock);
+
+    if (addr_p == NULL)
+    {
+        errno = ENOMEM;
+    }
+
+    return addr_p;
+}
+
+static void* __alloc_aligned(const size_t alignment, const size_t bytes)
+{
+    if (alignment <= INTERPOSER_MIN_ALIGNMENT)
+    {
+        return __alloc(bytes);
+    }
+
+    __init();
+
+    const size_t size = bytes == 0 ? 1 : bytes;
+
+    if (size <= INTERPOSER_SLAB_MAX_SIZE && alignment <= INTERPOSER_SLAB_MAX_SIZE)
+    {
+        void* const addr_p = fsa_slab_alloc(size < alignment ? alignment : size);
+
+        if (addr_p != NULL)
+        {
+            return addr_p;
+        }
+    }
+
+    (void)pthread_mutex_lock(&ssa_lock);
+    void* const addr_p = ssa_alloc_aligned(size, alignment);
+    (void)pthread_mutex_unlock(&ssa_lock);
+
+    if (addr_p == NULL)
+    {
+        errno = ENOMEM;
+    }
+
+    return addr_p;
+}
+
+static void __free(void* addr_p)
+{
+    if (addr_p == NULL)
+    {
+        return;
+    }
+
+    if (__is_slab_address(addr_p))
+    {
+        fsa_dealloc(addr_p);
+        return;
+    }
+
+    (void)pthread_mutex_lock(&ssa_lock);
+    ssa_dealloc(addr_p);
+    (void)pthread_mutex_unlock(&ssa_lock);
+}
+
+static void* __realloc(void* addr_p, const size_t bytes)
+{
+    if (__is_slab_address(addr_p))
+    {
+        const size_t usable = fsa_get_usable_size(addr_p);
+
+        /* slot keeps new size and it is not too big for it */
+        if (bytes <= usable && (bytes > (usable >> 1) || usable == INTERPOSER_MIN_ALIGNMENT))
+        {
+            return addr_p;
+        }
+
+        void* const new_addr_p = __alloc(bytes);
+
+        if (new_addr_p == NULL)
+        {
+            return NULL;
+        }
+
+        (void)memcpy(new_addr_p, addr_p, bytes < usable ? bytes : usable);
+        fsa_dealloc(addr_p);
+
+        return new_addr_p;
+    }
+
+    (void)pthread_mutex_lock(&ssa_lock);
+    void* const new_addr_p = ssa_realloc(addr_p, bytes);
+    (void)pthread_mutex_unlock(&ssa_lock);
+
+    if (new_addr_p == NULL)
+    {
+        errno = ENOMEM;
+    }
+
+    return new_addr_p;
+}
+
+static void* __aligned_alloc(const size_t alignment, const size_t bytes)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return __alloc_aligned(alignment, bytes);
+}
+
+static inline bool __trace_begin(void)
+{
+    if (!__atomic_load_n(&is_tracing, __ATOMIC_RELAXED))
+    {
+        return false;
+    }
+
+    (void)pthread_mutex_lock(&trace_lock);
+
+    /* recording could be stopped while lock was taken */
+    if (!is_tracing)
+    {
+        (void)pthread_mutex_unlock(&trace_lock);
+        return false;
+    }
+
+    return true;
+}
+
+static inline void __trace_end(const bool is_traced,
+                               const unsigned int type,
+                               const void* id,
+                               const void* new_id,
+                               const size_t size)
+{
+    if (!is_traced)
+    {
+        return;
+    }
+
+    if (id != NULL)
+    {
+        if (trace_thread == 0)
+        {
+            trace_thread = ++nr_of_trace_threads;
+        }
+
+        struct timespec now;
+        (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+        Trace_event* const event_p = &trace_buffer[trace_buffer_length];
+        event_p->id = (uint64_t)(uintptr_t)id;
+        event_p->new_id = (uint64_t)(uintptr_t)new_id;
+        event_p->size = (uint64_t)size & TRACE_SIZE_MASK;
+        event_p->thread = (trace_thread - 1) & TRACE_THREAD_MASK;
+        event_p->type = type & 0xf;
+        event_p->timestamp = (uint64_t)(now.tv_sec - trace_start.tv_sec) * 1000000000ULL +
+            (uint64_t)now.tv_nsec - (uint64_t)trace_start.tv_nsec;
+
+        if (++trace_buffer_length == INTERPOSER_TRACE_BUFFER_SIZE)
+        {
+            __trace_flush();
+        }
+    }
+
+    (void)pthread_mutex_unlock(&trace_lock);
+}
+
+static void __trace_flush(void)
+{
+    const uint8_t* data_p = (const uint8_t*)&trace_buffer[0];
+    size_t size = trace_buffer_length * sizeof(Trace_event);
+
+    while (size > 0)
+    {
+        const ssize_t written = write(trace_fd, data_p, size);
+
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        /* file can not be written, so recording is stopped */
+        if (written <= 0)
+        {
+            is_tracing = false;
+            break;
+        }
+
+        data_p += written;
+        size -= (size_t)written;
+    }
+
+    trace_buffer_length = 0;
+}
+
+static void __statistics_print(FILE* stream_p)
+{
+    Interposer_statistics stats;
+    interposer_read_statistics(&stats);
+
+    fprintf(stream_p, "slab: chunks in use = %zu, bytes in use = %zu (peak = %zu)\n",
+            stats.slab.nr_of_chunks_in_use, stats.slab.bytes_in_use, stats.slab.peak_bytes_in_use);
+    fprintf(stream_p, "slab: allocs = %zu, frees = %zu, failures = %zu\n",
+            stats.slab.nr_of_allocs, stats.slab.nr_of_frees, stats.slab.nr_of_failures);
+    fprintf(stream_p, "split: size of heap = %zu (segments = %zu), mapped chunks = %zu\n",
+            stats.split.size_of_heap, stats.split.nr_of_segments, stats.split.nr_of_mapped_chunks);
+    fprintf(stream_p, "split: chunks in use = %zu, bytes in use = %zu (peak = %zu)\n",
+            stats.split.nr_of_chunks_in_use, stats.split.bytes_in_use, stats.split.peak_bytes_in_use);
+    fprintf(stream_p, "split: allocs = %zu, frees = %zu, failures = %zu\n",
+            stats.split.nr_of_allocs, stats.split.nr_of_frees, stats.split.nr_of_failures);
+}
+
+static void __fork_prepare(void)
+{
+    (void)pthread_mutex_lock(&trace_lock);
+    (void)pthread_mutex_lock(&ssa_lock);
+    fsa_lock();
+}
+
+static void __fork_parent(void)
+{
+    fsa_unlock();
+    (void)pthread_mutex_unlock(&ssa_lock);
+    (void)pthread_mutex_unlock(&trace_lock);
+}
+
+static void __fork_child(void)
+{
+    if (is_tracing)
+    {
+        is_tracing = false;
+        trace_buffer_length = 0;
+
+        (void)close(trace_fd);
+        trace_fd = -1;
+    }
+
+    fsa_unlock();
+    (void)pthread_mutex_unlock(&ssa_lock);
+    (void)pthread_mutex_unlock(&trace_lock);
+}
+
+static void __constructor(void)
+{
+    __init();
+
+    (void)pthread_atfork(__fork_prepare, __fork_parent, __fork_child);
+
+    const char* const path = getenv("INTERPOSER_TRACE");
+
+    if (path != NULL)
+    {
+        (void)interposer_trace_start(path);
+    }
+}
+
+static void __destructor(void)
+{
+    interposer_trace_stop();
+
+    if (getenv("INTERPOSER_STATISTICS") != NULL)
+    {
+        __statistics_print(stderr);
+    }
+}
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+void* malloc(size_t size)
+{
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __alloc(size);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, size);
+
+    return addr_p;
+}
+
+void free(void* ptr)
+{
+    const bool is_traced = __trace_begin();
+
+    __free(ptr);
+    __trace_end(is_traced, TRACE_FREE, ptr, NULL, 0);
+}
+
+void* calloc(size_t nmemb, size_t size)
+{
+    size_t bytes;
+
+    if (__builtin_mul_overflow(nmemb, size, &bytes))
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __calloc(bytes);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, bytes);
+
+    return addr_p;
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    const bool is_traced = __trace_begin();
+
+    if (ptr == NULL)
+    {
+        void* const addr_p = __alloc(size);
+        __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, size);
+
+        return addr_p;
+    }
+
+    if (size == 0)
+    {
+        __free(ptr);
+        __trace_end(is_traced, TRACE_FREE, ptr, NULL, 0);
+
+        return NULL;
+    }
+
+    void* const new_ptr = __realloc(ptr, size);
+
+    /* failed realloc keeps block, so there is no event */
+    __trace_end(is_traced, TRACE_REALLOC, new_ptr == NULL ? NULL : ptr, new_ptr, size);
+
+    return new_ptr;
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __alloc_aligned(alignment, size);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, size);
+
+    if (addr_p == NULL)
+    {
+        return ENOMEM;
+    }
+
+    *memptr = addr_p;
+
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __aligned_alloc(alignment, size);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, size);
+
+    return addr_p;
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __aligned_alloc(alignment, size);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, size);
+
+    return addr_p;
+}
+
+void* valloc(size_t size)
+{
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __alloc_aligned((size_t)sysconf(_SC_PAGESIZE), size);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, size);
+
+    return addr_p;
+}
+
+void* pvalloc(size_t size)
+{
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    if (size > SIZE_MAX - page_size)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    const size_t bytes = (size + page_size - 1) & ~(page_size - 1);
+    const bool is_traced = __trace_begin();
+    void* const addr_p = __alloc_aligned(page_size, bytes);
+
+    __trace_end(is_traced, TRACE_ALLOC, addr_p, NULL, bytes);
+
+    return addr_p;
+}
+
+size_t malloc_usable_size(void* ptr)
+{
+    if (ptr == NULL)
+    {
+        return 0;
+    }
+
+    if (__is_slab_address(ptr))
+    {
+        return fsa_get_usable_size(ptr);
+    }
+
+    return ssa_get_usable_size(ptr);
+}
+
+void interposer_read_statistics(Interposer_statistics* stats_p)
+{
+    if (stats_p == NULL)
+    {
+        return;
+    }
+
+    __init();
+
+    fsa_read_statistics(&stats_p->slab);
+
+    (void)pthread_mutex_lock(&ssa_lock);
+    ssa_read_statistics(&stats_p->split);
+    (void)pthread_mutex_unlock(&ssa_lock);
+}
+
+void interposer_get_statistics(void)
+{
+    __statistics_print(stdout);
+}
+
+bool interposer_trace_start(const char* path)
+{
+    if (path == NULL)
+    {
+        return false;
+    }
+
+    __init();
+
+    (void)pthread_mutex_lock(&trace_lock);
+
+    if (is_tracing)
+    {
+        (void)pthread_mutex_unlock(&trace_lock);
+        return false;
+    }
+
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    const Trace_header header = {.magic = TRACE_MAGIC, .version = TRACE_VERSION};
+
+    if (trace_fd < 0 || write(trace_fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+    {
+        if (trace_fd >= 0)
+        {
+            (void)close(trace_fd);
+            trace_fd = -1;
+        }
+
+        (void)pthread_mutex_unlock(&trace_lock);
+        return false;
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &trace_start);
+    trace_buffer_length = 0;
+
+    __atomic_store_n(&is_tracing, true, __ATOMIC_RELAXED);
+
+    (void)pthread_mutex_unlock(&trace_lock);
+
+    return true;
+}
+
+void interposer_trace_stop(void)
+{
+    (void)pthread_mutex_lock(&trace_lock);
+
+    if (trace_fd >= 0)
+    {
+        __trace_flush();
+
+        (void)close(trace_fd);
+        trace_fd = -1;
+    }
+
+    __atomic_store_n(&is_tracing, false, __ATOMIC_RELAXED);
+
+    (void)pthread_mutex_unlock(&trace_lock);
+}
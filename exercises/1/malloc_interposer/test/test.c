@@ -0,0 +1,544 @@
+/* aligned_alloc is not declared in gnu99 without feature macro */
+#define _GNU_SOURCE
+
+#include <malloc_interposer.h>
+#include <trace_replay.h>
+#include <benchmark.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* number of threads and allocations of each thread in stress test */
+#define NR_OF_THREADS 8
+#define NR_OF_THREAD_OPERATIONS 20000
+
+/* number of blocks kept allocated at once by each thread and by benchmark */
+#define NR_OF_LIVE_BLOCKS 128
+
+/* number of forks done while stress threads allocate, child which does not finish in time is killed by alarm */
+#define NR_OF_FORKS 64
+#define CHILD_TIMEOUT 10
+
+/* number of allocations in benchmark workload */
+#define NR_OF_OPERATIONS 100000
+
+/* ---------------------------------------------- TEST DECLARATION ------------------------------------------------- */
+
+/*
+    This function check if block is inside fsa memory.
+
+    PARAMS:
+    @IN addr_p - allocated address.
+
+    RETURN:
+    @true if block is owned by fsa.
+    @false otherwise.
+*/
+static bool __is_slab_block(const void* addr_p);
+
+/*
+    In this test case we want to make sure that small requests are served by fsa slab layer, big ones by ssa and free
+    gives memory back to allocator which owns address.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_routing(void);
+
+/*
+    In this test case we want to make sure that calloc zeroes memory and detects overflow, realloc keeps data when
+    block is moved between allocators.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_calloc_realloc(void);
+
+/*
+    In this test case we want to make sure that posix_memalign, aligned_alloc, memalign and valloc return aligned
+    addresses from both allocators and reject wrong alignments.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_aligned(void);
+
+/*
+    Thread of stress test, it allocates blocks of random sizes, fills them by own pattern and checks pattern before
+    free.
+
+    PARAMS:
+    @IN arg_p - seed of thread.
+
+    RETURN:
+    NULL.
+*/
+static void* __stress_thread(void* arg_p);
+
+/*
+    In this test case we want to make sure that many threads can use both allocators at the same time.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_threads(void);
+
+/*
+    In this test case we want to make sure that child forked while other threads allocate can allocate from each size
+    class, so no lock of allocators is left taken in child.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_fork(void);
+
+/*
+    In this test case we want to make sure that recorded trace keeps each operation with its block, size and type, in
+    order of calls, and nothing is recorded after stop.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_trace(void);
+
+/*
+    Workload of benchmark, mixed sizes from 16 B to 64 kB with NR_OF_LIVE_BLOCKS live blocks.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __mixed_workload(void);
+
+/*
+    Benchmark of malloc and free served by interposer.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_malloc(void);
+
+/* ---------------------------------------------- TEST DEFINITION -------------------------------------------------- */
+
+static bool __is_slab_block(const void* addr_p)
+{
+    const uint8_t* const begin_p = (const uint8_t*)fsa_get_address_from_memory(0);
+
+    return (const uint8_t*)addr_p >= begin_p && (const uint8_t*)addr_p < begin_p + fsa_get_size_of_memory();
+}
+
+static void test_routing(void)
+{
+    Interposer_statistics before;
+    Interposer_statistics after;
+
+    interposer_read_statistics(&before);
+
+    uint8_t* const small_p = (uint8_t*)malloc(100);
+    uint8_t* const big_p = (uint8_t*)malloc(100000);
+    uint8_t* const empty_p = (uint8_t*)malloc(0);
+    assert(small_p != NULL && big_p != NULL && empty_p != NULL && empty_p != small_p);
+
+    assert(__is_slab_block(small_p) && __is_slab_block(empty_p));
+    assert(!__is_slab_block(big_p));
+    assert(((uintptr_t)small_p & (INTERPOSER_MIN_ALIGNMENT - 1)) == 0);
+    assert(((uintptr_t)empty_p & (INTERPOSER_MIN_ALIGNMENT - 1)) == 0);
+    assert(((uintptr_t)big_p & (INTERPOSER_MIN_ALIGNMENT - 1)) == 0);
+
+    assert(malloc_usable_size(small_p) == 128);
+    assert(malloc_usable_size(big_p) >= 100000);
+    assert(malloc_usable_size(NULL) == 0);
+
+    (void)memset(small_p, 0x11, malloc_usable_size(small_p));
+    (void)memset(big_p, 0x22, malloc_usable_size(big_p));
+
+    interposer_read_statistics(&after);
+    assert(after.split.nr_of_allocs == before.split.nr_of_allocs + 1);
+    assert(after.split.nr_of_chunks_in_use == before.split.nr_of_chunks_in_use + 1);
+
+    free(small_p);
+    free(big_p);
+    free(empty_p);
+    free(NULL);
+
+    interposer_read_statistics(&after);
+    assert(after.split.nr_of_chunks_in_use == before.split.nr_of_chunks_in_use);
+    assert(after.split.nr_of_frees == before.split.nr_of_frees + 1);
+}
+
+static void test_calloc_realloc(void)
+{
+    uint8_t* const dirty_p = (uint8_t*)malloc(1000);
+    assert(dirty_p != NULL);
+
+    (void)memset(dirty_p, 0xff, 1000);
+    free(dirty_p);
+
+    /* slot is reused, but it is zeroed */
+    uint8_t* const zeroed_p = (uint8_t*)calloc(10, 100);
+    assert(zeroed_p != NULL);
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        assert(zeroed_p[i] == 0);
+    }
+
+    free(zeroed_p);
+
+    /* chunk of ssa is reused, but it is zeroed too */
+    const size_t big_size = INTERPOSER_SLAB_MAX_SIZE * 4;
+    uint8_t* const dirty_big_p = (uint8_t*)malloc(big_size);
+    assert(dirty_big_p != NULL && !__is_slab_block(dirty_big_p));
+
+    (void)memset(dirty_big_p, 0xff, big_size);
+    free(dirty_big_p);
+
+    uint8_t* const zeroed_big_p = (uint8_t*)calloc(4, INTERPOSER_SLAB_MAX_SIZE);
+    assert(zeroed_big_p != NULL && !__is_slab_block(zeroed_big_p));
+
+    for (size_t i = 0; i < big_size; ++i)
+    {
+        assert(zeroed_big_p[i] == 0);
+    }
+
+    free(zeroed_big_p);
+
+    /* empty array has got unique address */
+    void* const empty_p = calloc(0, 4);
+    assert(empty_p != NULL);
+    free(empty_p);
+
+    /* volatile keeps compiler from checking size of this call */
+    volatile size_t nr_of_members = SIZE_MAX / 2;
+
+    errno = 0;
+    assert(calloc(nr_of_members, 4) == NULL && errno == ENOMEM);
+
+    /* slot keeps new size, so it is not moved */
+    uint8_t* block_p = (uint8_t*)realloc(NULL, 20);
+    assert(block_p != NULL && __is_slab_block(block_p));
+
+    for (size_t i = 0; i < 20; ++i)
+    {
+        block_p[i] = (uint8_t)i;
+    }
+
+    const uintptr_t old_address = (uintptr_t)block_p;
+    block_p = (uint8_t*)realloc(block_p, 30);
+    assert((uintptr_t)block_p == old_address);
+
+    /* block grows from slab to ssa */
+    block_p = (uint8_t*)realloc(block_p, 10000);
+    assert(block_p != NULL && !__is_slab_block(block_p));
+
+    for (size_t i = 0; i < 20; ++i)
+    {
+        assert(block_p[i] == (uint8_t)i);
+    }
+
+    /* block grows in ssa and to own mapping */
+    block_p = (uint8_t*)realloc(block_p, (size_t)SSA_MMAP_THRESHOLD * 4);
+    assert(block_p != NULL && block_p[19] == 19);
+
+    block_p[(size_t)SSA_MMAP_THRESHOLD * 4 - 1] = 1;
+
+    block_p = (uint8_t*)realloc(block_p, 100);
+    assert(block_p != NULL && block_p[19] == 19);
+
+    /* realloc to 0 frees block */
+    assert(realloc(block_p, 0) == NULL);
+}
+
+static void test_aligned(void)
+{
+    const size_t alignments[] = {8, 16, 32, 64, 256, 1024, 4096, 65536};
+    const size_t sizes[] = {1, 100, 3000, 300000};
+
+    for (size_t i = 0; i < ARRAY_SIZE(alignments); ++i)
+    {
+        for (size_t j = 0; j < ARRAY_SIZE(sizes); ++j)
+        {
+            void* addr_p = NULL;
+
+            assert(posix_memalign(&addr_p, alignments[i], sizes[j]) == 0);
+            assert(addr_p != NULL && ((uintptr_t)addr_p & (alignments[i] - 1)) == 0);
+            assert(malloc_usable_size(addr_p) >= sizes[j]);
+
+            (void)memset(addr_p, 0x5a, sizes[j]);
+            free(addr_p);
+
+            addr_p = aligned_alloc(alignments[i], sizes[j]);
+            assert(addr_p != NULL && ((uintptr_t)addr_p & (alignments[i] - 1)) == 0);
+            free(addr_p);
+        }
+    }
+
+    void* addr_p = NULL;
+    assert(posix_memalign(&addr_p, 4, 100) == EINVAL);
+    assert(posix_memalign(&addr_p, 48, 100) == EINVAL);
+
+    errno = 0;
+    assert(aligned_alloc(48, 100) == NULL && errno == EINVAL);
+
+    uint8_t* const page_p = (uint8_t*)memalign(4096, 10);
+    uint8_t* const valloc_p = (uint8_t*)valloc(10);
+    assert(page_p != NULL && ((uintptr_t)page_p & 4095) == 0);
+    assert(valloc_p != NULL && ((uintptr_t)valloc_p & 4095) == 0);
+
+    free(page_p);
+    free(valloc_p);
+}
+
+static void* __stress_thread(void* arg_p)
+{
+    uint32_t seed = (uint32_t)(uintptr_t)arg_p;
+    const uint8_t pattern = (uint8_t)(uintptr_t)arg_p;
+
+    uint8_t* blocks[NR_OF_LIVE_BLOCKS] = {NULL};
+    size_t sizes[NR_OF_LIVE_BLOCKS] = {0};
+
+    for (size_t i = 0; i < NR_OF_THREAD_OPERATIONS; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+
+        const size_t slot = (seed >> 8) % NR_OF_LIVE_BLOCKS;
+
+        if (blocks[slot] != NULL)
+        {
+            assert(blocks[slot][0] == pattern && blocks[slot][sizes[slot] - 1] == pattern);
+            free(blocks[slot]);
+        }
+
+        /* most of blocks are small, each 16th one is served by ssa */
+        sizes[slot] = (seed >> 16) % 16 == 0 ? 4096 + (seed >> 20) % 60000 : 1 + (seed >> 20) % 512;
+        blocks[slot] = (uint8_t*)malloc(sizes[slot]);
+        assert(blocks[slot] != NULL);
+
+        (void)memset(blocks[slot], pattern, sizes[slot]);
+    }
+
+    for (size_t i = 0; i < NR_OF_LIVE_BLOCKS; ++i)
+    {
+        if (blocks[i] != NULL)
+        {
+            assert(blocks[i][0] == pattern && blocks[i][sizes[i] - 1] == pattern);
+            free(blocks[i]);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    Interposer_statistics before;
+    Interposer_statistics after;
+
+    interposer_read_statistics(&before);
+
+    pthread_t threads[NR_OF_THREADS];
+
+    for (size_t i = 0; i < NR_OF_THREADS; ++i)
+    {
+        assert(pthread_create(&threads[i], NULL, __stress_thread, (void*)(i + 1)) == 0);
+    }
+
+    for (size_t i = 0; i < NR_OF_THREADS; ++i)
+    {
+        assert(pthread_join(threads[i], NULL) == 0);
+    }
+
+    /* each block was freed */
+    interposer_read_statistics(&after);
+    assert(after.split.nr_of_chunks_in_use == before.split.nr_of_chunks_in_use);
+}
+
+static void test_fork(void)
+{
+    pthread_t threads[NR_OF_THREADS];
+
+    for (size_t i = 0; i < NR_OF_THREADS; ++i)
+    {
+        assert(pthread_create(&threads[i], NULL, __stress_thread, (void*)(i + 1)) == 0);
+    }
+
+    for (size_t i = 0; i < NR_OF_FORKS; ++i)
+    {
+        const pid_t pid = fork();
+        assert(pid >= 0);
+
+        if (pid == 0)
+        {
+            (void)alarm(CHILD_TIMEOUT);
+
+            /* slab size classes and ssa */
+            for (size_t size = 1; size <= 65536; size <<= 1)
+            {
+                void* const addr_p = malloc(size);
+
+                if (addr_p == NULL)
+                {
+                    _exit(1);
+                }
+
+                free(addr_p);
+            }
+
+            _exit(0);
+        }
+
+        int status = 0;
+        assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    for (size_t i = 0; i < NR_OF_THREADS; ++i)
+    {
+        assert(pthread_join(threads[i], NULL) == 0);
+    }
+}
+
+static void test_trace(void)
+{
+    char path[] = "/tmp/malloc_interposer_XXXXXX";
+    const int fd = mkstemp(path);
+    assert(fd >= 0);
+
+    assert(interposer_trace_start(path));
+
+    /* only one recording at once */
+    assert(!interposer_trace_start(path));
+
+    char* const small_p = malloc(24);
+    char* const big_p = calloc(1, 100000);
+    const uintptr_t small = (uintptr_t)small_p;
+    const uintptr_t big = (uintptr_t)big_p;
+
+    char* const moved_p = realloc(small_p, 1000);
+    const uintptr_t moved = (uintptr_t)moved_p;
+
+    free(big_p);
+    free(NULL);
+    free(moved_p);
+
+    interposer_trace_stop();
+
+    /* not recorded */
+    free(malloc(8));
+
+    struct
+    {
+        Trace_header header;
+        Trace_event events[8];
+    } file;
+
+    const ssize_t bytes = read(fd, &file, sizeof(file));
+    assert(bytes == (ssize_t)(sizeof(Trace_header) + 5 * sizeof(Trace_event)));
+
+    (void)close(fd);
+    (void)unlink(path);
+
+    assert(file.header.magic == TRACE_MAGIC && file.header.version == TRACE_VERSION);
+
+    const Trace_event* const events = &file.events[0];
+
+    assert(events[0].type == TRACE_ALLOC && events[0].id == small && events[0].size == 24);
+    assert(events[1].type == TRACE_ALLOC && events[1].id == big && events[1].size == 100000);
+    assert(events[2].type == TRACE_REALLOC && events[2].id == small && events[2].size == 1000);
+    assert(events[2].new_id == moved);
+    assert(events[3].type == TRACE_FREE && events[3].id == big);
+    assert(events[4].type == TRACE_FREE && events[4].id == moved);
+
+    for (size_t i = 0; i < 5; ++i)
+    {
+        assert(events[i].thread == 0);
+        assert(i == 0 || events[i].timestamp >= events[i - 1].timestamp);
+    }
+}
+
+/* blocks kept allocated by benchmark workload */
+static void* live_blocks[NR_OF_LIVE_BLOCKS];
+
+static void __mixed_workload(void)
+{
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < NR_OF_OPERATIONS; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+
+        const size_t slot = (seed >> 8) % NR_OF_LIVE_BLOCKS;
+        const size_t shift = 4 + (seed >> 16) % 13;
+
+        free(live_blocks[slot]);
+        live_blocks[slot] = malloc(((size_t)1 << shift) - (seed >> 24) % 8);
+        assert(live_blocks[slot] != NULL);
+    }
+
+    for (size_t i = 0; i < NR_OF_LIVE_BLOCKS; ++i)
+    {
+        free(live_blocks[i]);
+        live_blocks[i] = NULL;
+    }
+}
+
+static void benchmark_malloc(void)
+{
+    printf("MALLOC INTERPOSER, %d allocations from 16 B to 64 kB, %d live blocks\n",
+           NR_OF_OPERATIONS, NR_OF_LIVE_BLOCKS);
+
+    MEASURE_FUNCTION(__mixed_workload(), "malloc + free");
+
+    interposer_get_statistics();
+}
+
+int main(void)
+{
+    test_routing();
+    test_calloc_realloc();
+    test_aligned();
+    test_threads();
+    test_fork();
+    test_trace();
+
+    benchmark_malloc();
+
+    return 0;
+}
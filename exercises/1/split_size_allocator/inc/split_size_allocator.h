@@ -4,6 +4,12 @@
 /*
     Implementation of split-size allocator using static memory.
 
+    Functions with ssa_ prefix use one heap and they are not thread safe. Functions with ssa_arenas_ prefix are thread
+    safe: there are N independent heaps (arenas), each of them with own lock, and thread allocates from its arena.
+    Arena owns part of one reserved range, so chunk freed by any thread goes back to its arena found by address.
+    Thread of other arena does not take lock of owner, it pushes chunk on lock-free queue of owner arena and owner
+    frees all queued chunks at once on its next allocation.
+
     author: Kamil Kielbasa
     email: dusergithub@gmail.com
 
@@ -11,16 +17,109 @@
 */
 
 #include <stddef.h>
+#include <stdbool.h>
 
 /* default value, MEMORY_SIZE should be passed in compile time by -D option */
 #ifndef MEMORY_SIZE
 #define MEMORY_SIZE (1 << 20) /* 1 MB */
 #endif
 
+/*
+    Heap starts with static memory and grows by segments mapped on demand up to SSA_MAX_HEAP_SIZE bytes (static memory
+    included). Each segment has got at least SSA_SEGMENT_SIZE bytes. Both could be passed in compile time by -D option,
+    by default heap does not grow.
+*/
+#ifndef SSA_MAX_HEAP_SIZE
+#define SSA_MAX_HEAP_SIZE MEMORY_SIZE
+#endif
+
+#ifndef SSA_SEGMENT_SIZE
+#define SSA_SEGMENT_SIZE (1 << 26) /* 64 MB */
+#endif
+
+/*
+    Requests bigger than SSA_MMAP_THRESHOLD bytes are not taken from heap, each of them gets own anonymous mapping which
+    is unmapped by ssa_dealloc. Could be passed in compile time by -D option or changed by ssa_set_mmap_threshold.
+*/
+#ifndef SSA_MMAP_THRESHOLD
+#define SSA_MMAP_THRESHOLD (1 << 17) /* 128 kB */
+#endif
+
+/*
+    Arenas (see ssa_arenas_init) take SSA_ARENA_SIZE bytes of address range each, power of two not smaller than 1 MB.
+    Number of arenas is limited by SSA_MAX_NR_OF_ARENAS. Both could be passed in compile time by -D option. If
+    SSA_ARENA_BY_CPU is defined, thread uses arena of CPU it runs on, otherwise threads get arenas round-robin.
+*/
+#ifndef SSA_ARENA_SIZE
+#define SSA_ARENA_SIZE (1 << 28) /* 256 MB */
+#endif
+
+#ifndef SSA_MAX_NR_OF_ARENAS
+#define SSA_MAX_NR_OF_ARENAS 64
+#endif
+
+/* alignment of each address returned by ssa_alloc, power of two, could be passed by -D option */
+#ifndef SSA_ALIGNMENT
+#define SSA_ALIGNMENT 16
+#endif
+
 typedef struct Chunk_header Chunk_header;
 
 /*
-    This function is responsible for set proper values for first available memory chunk.
+    Statistics of allocator. Counters are updated by alloc and dealloc, so reading them does not allocate memory and
+    does not print anything. Sizes are in bytes and include chunk headers.
+*/
+struct Ssa_statistics
+{
+    size_t size_of_heap; /* static memory and mapped segments */
+    size_t nr_of_segments;
+    size_t nr_of_mapped_chunks; /* chunks over SSA_MMAP_THRESHOLD, they are counted in chunks in use too */
+
+    size_t nr_of_chunks_in_use;
+    size_t bytes_in_use;
+    size_t peak_bytes_in_use;
+
+    size_t nr_of_free_chunks;
+    size_t size_of_largest_free_chunk;
+
+    size_t nr_of_allocs;
+    size_t nr_of_frees;
+    size_t nr_of_remote_frees; /* frees by thread of other arena, they are counted in frees too */
+    size_t nr_of_failures;
+};
+
+typedef struct Ssa_statistics Ssa_statistics;
+
+/* number of buckets in histogram of free extents, the same as number of bins of free chunks */
+#define SSA_FRAGMENTATION_NR_OF_BUCKETS 64
+
+/*
+    Fragmentation report of allocator. Extent is free chunk (merged with free neighbours), bucket n of histogram counts
+    extents of [2^n, 2^(n + 1)) bytes, so it is number of chunks in bin n. External fragmentation is 1 - largest
+    extent / free bytes: 0 if all free memory is one chunk, close to 1 if it is split into small ones. Heap can still
+    grow by new segment up to SSA_MAX_HEAP_SIZE, so request bigger than the largest extent could be served.
+    Internal waste is part of allocated bytes lost since init by headers, alignment and chunks which were too small
+    to split, chunk with own mapping is counted with whole mapping. Sizes are in bytes and include chunk headers.
+*/
+struct Ssa_fragmentation
+{
+    size_t free_extents[SSA_FRAGMENTATION_NR_OF_BUCKETS];
+    size_t nr_of_free_extents;
+    size_t free_bytes;
+    size_t size_of_largest_free_extent;
+    double external_fragmentation; /* 0 if there is no free memory */
+
+    size_t requested_bytes;
+    size_t allocated_bytes; /* chunks and mappings given for requested bytes */
+    double internal_waste; /* 1 - requested / allocated, 0 if nothing was allocated */
+};
+
+typedef struct Ssa_fragmentation Ssa_fragmentation;
+
+/*
+    This function is responsible for set proper values for first available memory chunk. Mapped chunks and segments
+    are unmapped, only headers of the first chunk and fence are written. Memory is not zeroed, so cost does not depend
+    on MEMORY_SIZE and ssa_init can be called as cheap reset.
 
     PARAMS:
     @IN - void
@@ -32,7 +131,9 @@ void ssa_init(void);
 
 /*
     This function implement simple allocator based on static memory. It is split-size allocator which means memory is 
-    devided by requested size of bytes plus sizeof(header). 
+    devided by requested size of bytes plus sizeof(header). Free chunks are kept on segregated lists (bins by power of
+    two), so suitable chunk is found without walk through all chunks. Chunk sizes are multiple of SSA_ALIGNMENT and
+    header lies just before aligned address, so each returned address is aligned to SSA_ALIGNMENT.
 
     PARAMS:
     @bytes - requested memory size in bytes.
@@ -44,8 +145,37 @@ void ssa_init(void);
 void* ssa_alloc(const size_t bytes);
 
 /*
-    This functon implement freeing memory. Function is responsible for set bit in freeing chunk as not allocated and go 
-    through all available chunks and merge two chunks abreast if they are not allocated.
+    This function allocate chunk for array like ssa_alloc and zero it. Only requested bytes are zeroed and chunk with
+    own mapping is not zeroed at all, kernel gives zeroed pages.
+
+    PARAMS:
+    @nr_of_members - number of members of array.
+    @size - size of member in bytes.
+
+    RETURN:
+    @NULL if failure (also if size of array overflows) or size of array is 0.
+    @address if success.
+*/
+void* ssa_calloc(const size_t nr_of_members, const size_t size);
+
+/*
+    This function allocate chunk like ssa_alloc, but returned address is aligned to @alignment. Free chunk is split
+    in front of aligned address and padding goes back to free lists, so only header is placed before address.
+
+    PARAMS:
+    @bytes - requested memory size in bytes.
+    @alignment - requested alignment, power of two.
+
+    RETURN:
+    @NULL if failure or @alignment is not power of two.
+    @address if success.
+*/
+void* ssa_alloc_aligned(const size_t bytes, const size_t alignment);
+
+/*
+    This functon implement freeing memory. Function is responsible for set bit in freeing chunk as not allocated and
+    merge it with previous and next chunk if they are not allocated. Free chunks keep their size also in footer and
+    each header knows if previous chunk is allocated, so neighbours are found without walk through memory.
 
     PARAMS:
     @addr_p - pointer to memory for freeing.
@@ -56,11 +186,58 @@ void* ssa_alloc(const size_t bytes);
 void ssa_dealloc(void* addr_p);
 
 /*
-    This function is responsible for print the following infromations to stdio:
-    -number of allocated chunks
-    -size of each allocated chunk
-    -number of free chunks
-    -size of each free chunk
+    This function change size of allocated chunk. Chunk is shrunk in place (tail goes back to free lists) or grown in
+    place if the next chunk is free and big enough. Only if it is not possible, new chunk is allocated, data is
+    copied and old chunk is freed.
+
+    PARAMS:
+    @addr_p - pointer to allocated memory, NULL works like ssa_alloc.
+    @bytes - new memory size in bytes, 0 works like ssa_dealloc.
+
+    RETURN:
+    @NULL if failure (old chunk is left untouched) or @bytes is 0.
+    @address if success.
+*/
+void* ssa_realloc(void* addr_p, const size_t bytes);
+
+/*
+    This function set threshold of direct mapping, requests bigger than @threshold bytes get own mapping. Zero disables
+    direct mapping. Chunks mapped before are still unmapped by ssa_dealloc.
+
+    PARAMS:
+    @IN threshold - threshold in bytes.
+
+    RETURN:
+    This is void function.
+*/
+void ssa_set_mmap_threshold(const size_t threshold);
+
+/*
+    This function compute how many bytes can be used under address returned by ssa_alloc, ssa_alloc_aligned or
+    ssa_realloc. It is at least requested size, chunk could be bigger because of alignment and minimal chunk size.
+
+    PARAMS:
+    @IN addr_p - pointer to allocated memory.
+
+    RETURN:
+    @0 if @addr_p is NULL.
+    @size in bytes if success.
+*/
+size_t ssa_get_usable_size(const void* addr_p);
+
+/*
+    This function fill statistics of allocator.
+
+    PARAMS:
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void ssa_read_statistics(Ssa_statistics* stats_p);
+
+/*
+    This function is responsible for print statistics of allocator (see ssa_read_statistics) to stdio.
 
     PARAMS:
     @IN - void
@@ -70,6 +247,138 @@ void ssa_dealloc(void* addr_p);
 */
 void ssa_get_statistics(void);
 
+/*
+    This function fill fragmentation report of allocator. Counters of bins and requests are updated by alloc and
+    dealloc, only bin with the largest free chunk is walked.
+
+    PARAMS:
+    @OUT frag_p - pointer to fragmentation report.
+
+    RETURN:
+    This is void function.
+*/
+void ssa_read_fragmentation(Ssa_fragmentation* frag_p);
+
+/*
+    This function is responsible for print fragmentation report of allocator (see ssa_read_fragmentation) to stdio.
+    Only not empty buckets of histogram are printed.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void ssa_get_fragmentation(void);
+
+/*
+    This function reserve range for @nr arenas and make each of them empty heap of SSA_ARENA_SIZE bytes. Pages are
+    committed by kernel on first touch. Arena does not grow, bigger requests than SSA_MMAP_THRESHOLD get own mapping
+    like in ssa_alloc. Previous arenas are released, so this function is not thread safe and it has to be called before
+    any other ssa_arenas_ function.
+
+    PARAMS:
+    @IN nr - number of arenas, 0 for number of online CPUs (limited by SSA_MAX_NR_OF_ARENAS).
+
+    RETURN:
+    @true if success.
+    @false if @nr is bigger than SSA_MAX_NR_OF_ARENAS or range can not be reserved (previous arenas are left).
+*/
+bool ssa_arenas_init(const size_t nr);
+
+/*
+    This function allocate chunk like ssa_alloc from arena of calling thread. Only lock of this arena is taken.
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* ssa_arenas_alloc(const size_t bytes);
+
+/*
+    This function allocate chunk for array like ssa_calloc from arena of calling thread. Chunk is zeroed after lock is
+    released.
+
+    PARAMS:
+    @IN nr_of_members - number of members of array.
+    @IN size - size of member in bytes.
+
+    RETURN:
+    @NULL if failure (also if size of array overflows) or size of array is 0.
+    @address if success.
+*/
+void* ssa_arenas_calloc(const size_t nr_of_members, const size_t size);
+
+/*
+    This function allocate aligned chunk like ssa_alloc_aligned from arena of calling thread.
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+    @IN alignment - requested alignment, power of two.
+
+    RETURN:
+    @NULL if failure or @alignment is not power of two.
+    @address if success.
+*/
+void* ssa_arenas_alloc_aligned(const size_t bytes, const size_t alignment);
+
+/*
+    This function free chunk allocated by any thread. Chunk goes back to arena which owns it, arena is found by
+    address range (mapped chunk keeps its arena in descriptor). If owner is arena of calling thread, chunk is freed
+    under its lock. Otherwise chunk is pushed on lock-free queue of remote frees of owner without any lock, and it is
+    freed when owner allocates, reallocates or statistics are read. Queued chunk is still counted as chunk in use.
+
+    PARAMS:
+    @IN addr_p - pointer to memory for freeing. It has to come from ssa_arenas_* or from default heap (ssa_*),
+                 chunk of default heap is ignored. Header before any other pointer is read, so it is undefined.
+
+    RETURN:
+    This is void function.
+*/
+void ssa_arenas_dealloc(void* addr_p);
+
+/*
+    This function change size of chunk like ssa_realloc. Chunk is resized in arena which owns it, also if other thread
+    calls this function.
+
+    PARAMS:
+    @IN addr_p - pointer to allocated memory like in ssa_arenas_dealloc, NULL works like ssa_arenas_alloc.
+    @IN bytes - new memory size in bytes, 0 works like ssa_arenas_dealloc.
+
+    RETURN:
+    @NULL if failure (old chunk is left untouched), @bytes is 0 or @addr_p comes from default heap.
+    @address if success.
+*/
+void* ssa_arenas_realloc(void* addr_p, const size_t bytes);
+
+/*
+    This function fill sum of statistics of all arenas. Size of the largest free chunk is maximum over arenas and peak
+    is sum of peaks of arenas, so it could be bigger than real peak.
+
+    PARAMS:
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+void ssa_arenas_read_statistics(Ssa_statistics* stats_p);
+
+/*
+    This function fill fragmentation report of all arenas. Histograms and counters are summed, the largest free
+    extent is maximum over arenas, because one allocation is served by one arena. So free memory split between
+    arenas is counted as external fragmentation too.
+
+    PARAMS:
+    @OUT frag_p - pointer to fragmentation report.
+
+    RETURN:
+    This is void function.
+*/
+void ssa_arenas_read_fragmentation(Ssa_fragmentation* frag_p);
+
 /*
     Getter for size of memory array.
 
@@ -0,0 +1,84 @@
+#ifndef TLSF_H
+#define TLSF_H
+
+/*
+    Implementation of two-level segregated fit (TLSF) allocator using static memory. Alloc and dealloc take constant
+    time: free chunks are kept on lists indexed by first level (power of two) and second level (linear subdivision of
+    power of two) and non empty lists are found by bit scan in two levels of bitmaps.
+
+    author: Kamil Kielbasa
+    email: dusergithub@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <stddef.h>
+
+/* default value, TLSF_MEMORY_SIZE should be passed in compile time by -D option */
+#ifndef TLSF_MEMORY_SIZE
+#define TLSF_MEMORY_SIZE (1 << 20) /* 1 MB */
+#endif
+
+/* number of second level lists in each first level is 2^TLSF_SL_LOG2, could be passed by -D option */
+#ifndef TLSF_SL_LOG2
+#define TLSF_SL_LOG2 4
+#endif
+
+/*
+    This function is responsible for set proper values for first available memory chunk.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+void tlsf_init(void);
+
+/*
+    This function allocate chunk of at least @bytes bytes plus header. Request is rounded up to the next list size, so
+    the first chunk of the first non empty list is always good fit, there is no search through list.
+
+    PARAMS:
+    @bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+void* tlsf_alloc(const size_t bytes);
+
+/*
+    This functon free chunk and merge it immediately with previous and next chunk if they are free.
+
+    PARAMS:
+    @addr_p - pointer to memory for freeing.
+
+    RETURN:
+    This is void function.
+*/
+void tlsf_dealloc(void* addr_p);
+
+/*
+    Getter for size of memory array.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    Size of memory.
+*/
+size_t tlsf_get_size_of_memory(void);
+
+/*
+    Getter for memory address. Returned pointer must be used as read only.
+
+    PARAMS:
+    @IN index - index in memory array.
+
+    RETURN:
+    Address from @(&memory[index]).
+*/
+void* tlsf_get_address_from_memory(const size_t index);
+
+#endif /* TLSF_H */
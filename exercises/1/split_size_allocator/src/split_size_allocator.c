@@ -1,3 +1,6 @@
+/* mremap is GNU extension */
+#define _GNU_SOURCE
+
 #include <split_size_allocator.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -5,265 +8,1738 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* descriptor of mapped chunk lies just before its header */
+#define MAPPED_CHUNK(header_p) ((Mapped_chunk*)(void*)((uint8_t*)(header_p) - sizeof(Mapped_chunk)))
+
+/* chunk which lies just after given chunk */
+#define NEXT_CHUNK(header_p) ((Chunk_header*)(void*)((uint8_t*)(header_p) + (header_p)->size_of))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* bin n keeps free chunks with size_of in range [2^n, 2^(n + 1)) */
+#define NR_OF_BINS 64
+
+/* free chunk keeps links to neighbours on free list after header and its size in footer, so it can not be smaller */
+#define MIN_CHUNK_SIZE (sizeof(Free_chunk_header) + sizeof(uint64_t))
+
+/* size_of has got 61 bits in header */
+#define SIZE_MASK (((uint64_t)1 << 61) - 1)
+
+/* the first chunk of segment starts so that address after its header is aligned, bytes before it are never used */
+#define FIRST_CHUNK_OFFSET (SSA_ALIGNMENT - sizeof(Chunk_header))
+
+/* mapped segment keeps its descriptor at begin, chunks start at the next aligned address */
+#define SEGMENT_HEADER_SIZE ((sizeof(Segment) + SSA_ALIGNMENT - 1) & ~(size_t)(SSA_ALIGNMENT - 1))
+
+/* bytes of segment which can not be used by chunks: bytes before the first chunk and fence after the last one */
+#define SEGMENT_OVERHEAD (SEGMENT_HEADER_SIZE + 2 * SSA_ALIGNMENT)
+
+/* arenas are aligned to cache line, so lock of one arena does not share line with other arena */
+#define CACHE_LINE_SIZE 64
+
+#if SSA_ALIGNMENT < 8 || (SSA_ALIGNMENT & (SSA_ALIGNMENT - 1)) != 0
+#error "SSA_ALIGNMENT has to be power of two not smaller than header"
+#endif
+
+#if SSA_MAX_HEAP_SIZE < MEMORY_SIZE
+#error "SSA_MAX_HEAP_SIZE can not be smaller than MEMORY_SIZE"
+#endif
+
+#if SSA_FRAGMENTATION_NR_OF_BUCKETS != NR_OF_BINS
+#error "histogram of free extents has to have bucket for each bin"
+#endif
+
+#if (SSA_ARENA_SIZE & (SSA_ARENA_SIZE - 1)) != 0 || SSA_ARENA_SIZE < (1 << 20)
+#error "SSA_ARENA_SIZE has to be power of two not smaller than 1 MB"
+#endif
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/*
+    Free chunk has got copy of size_of in the last 8 bytes (footer), so next chunk can find its header. Each segment
+    ends with fence: header of allocated chunk with size_of 0, so the last chunk is never merged with memory after it.
+    Chunk with own mapping (is_mmapped) keeps size of mapping in size_of.
+*/
+struct Chunk_header
+{
+    uint64_t is_allocated : 1;
+    uint64_t is_prev_allocated : 1;
+    uint64_t is_mmapped : 1;
+    uint64_t size_of : 61;
+};
+
+typedef struct Free_chunk_header Free_chunk_header;
+
+struct Free_chunk_header
+{
+    Chunk_header header;
+
+    /* neighbours on free list */
+    Free_chunk_header* next;
+    Free_chunk_header* prev;
+};
+
+/* descriptor of mapped segment */
+typedef struct Segment Segment;
+
+struct Segment
+{
+    Segment* next;
+    size_t size;
+};
+
+typedef struct Ssa_heap Ssa_heap;
+
+/* descriptor of chunk with own mapping, mapped chunks are kept on list of their heap so reset can unmap them */
+typedef struct Mapped_chunk Mapped_chunk;
+
+struct Mapped_chunk
+{
+    Mapped_chunk* next;
+    Mapped_chunk* prev;
+
+    uint8_t* base_p;
+    size_t size;
+
+    /* heap which mapped chunk, so chunk freed by other thread goes back to its arena */
+    Ssa_heap* heap_p;
+};
+
+/*
+    State of one heap. Functions with ssa_ prefix work on default heap over static memory, each of arenas (see
+    ssa_arenas_init) is separate heap with own lock.
+*/
+struct Ssa_heap
+{
+    /* segments mapped when heap grows */
+    Segment* segments;
+
+    /* chunks with own mapping */
+    Mapped_chunk* mapped_chunks;
+
+    /* the first free chunk in each bin */
+    Free_chunk_header* bins[NR_OF_BINS];
+
+    /* bit n is set if bin n is not empty */
+    uint64_t bins_bitmap;
+
+    /* number of free chunks in each bin and their bytes, they are histogram of fragmentation report */
+    size_t nr_of_chunks_in_bins[NR_OF_BINS];
+    size_t free_bytes;
+
+    /* bytes requested since init and bytes of chunks given for them */
+    size_t requested_bytes;
+    size_t allocated_bytes;
+
+    /* heap does not grow over this size */
+    size_t max_size_of_heap;
+
+    /* statistics updated by alloc and dealloc */
+    Ssa_statistics statistics;
+};
+
+/* chunk freed by thread of other arena waits in queue of its arena, link is kept in the first bytes of payload */
+typedef struct Remote_free Remote_free;
+
+struct Remote_free
+{
+    Remote_free* next;
+};
+
+/* arena is heap over its part of reserved address range, so owner of address is found by range */
+typedef struct Ssa_arena Ssa_arena;
+
+struct Ssa_arena
+{
+    pthread_mutex_t lock;
+    Ssa_heap heap;
+
+    /* lock-free stack of chunks freed by other threads, it is pushed by many threads so it has own cache line */
+    Remote_free* remote_frees __attribute__((aligned(CACHE_LINE_SIZE)));
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+
+/* memory for allocations, the first segment of heap */
+static uint8_t memory[MEMORY_SIZE] __attribute__((aligned(SSA_ALIGNMENT)));
+
+/* heap used by ssa_init, ssa_alloc, ssa_dealloc and getters */
+static Ssa_heap default_heap;
+
+/* requests bigger than threshold get own mapping, 0 if direct mapping is disabled */
+static size_t mmap_threshold = SSA_MMAP_THRESHOLD;
+
+/* arenas used by ssa_arenas_ functions, each of them takes SSA_ARENA_SIZE bytes of reserved range */
+static Ssa_arena arenas[SSA_MAX_NR_OF_ARENAS];
+static size_t nr_of_arenas;
+static uint8_t* arenas_memory_p;
+
+#ifndef SSA_ARENA_BY_CPU
+/* next arena given to thread and arena of calling thread plus one, 0 if thread has not got arena yet */
+static size_t next_arena;
+static __thread size_t thread_arena __attribute__((tls_model("initial-exec")));
+#endif
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+    This function compute bin for chunk of given size.
+
+    PARAMS:
+    @IN size_of - size of chunk.
+
+    RETURN:
+    Index of bin.
+*/
+static inline size_t __bin_index(const size_t size_of);
+
+/*
+    This function add free chunk to the head of its bin.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN header_p - pointer to chunk.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_list_push(Ssa_heap* const heap_p, Chunk_header* header_p);
+
+/*
+    This function remove free chunk from its bin.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN header_p - pointer to chunk.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_list_remove(Ssa_heap* const heap_p, Chunk_header* header_p);
+
+/*
+    This function find free chunk with at least @req_memory bytes. Bin of @req_memory is searched first fit, from
+    bigger bins the first chunk is taken, because every chunk there is big enough.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN req_memory - requested size of chunk.
+
+    RETURN:
+    @NULL if there is no such chunk.
+    @Pointer to chunk if success.
+*/
+static Chunk_header* __free_list_find(Ssa_heap* const heap_p, const size_t req_memory);
+
+/*
+    This function write header and footer of free chunk and tell next chunk that previous one is free.
+
+    PARAMS:
+    @IN header_p - pointer to chunk.
+    @IN size_of - size of chunk.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_chunk_set(Chunk_header* header_p, const size_t size_of);
+
+/*
+    This function mark chunk taken from free list as allocated and split off its rest if it can be free chunk.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN header_p - pointer to chunk.
+    @IN size_of - size of chunk.
+    @IN req_memory - requested size of chunk, multiple of SSA_ALIGNMENT.
+
+    RETURN:
+    Address after header of chunk.
+*/
+static void* __chunk_allocate(Ssa_heap* const heap_p,
+                              Chunk_header* header_p,
+                              const size_t size_of,
+                              const size_t req_memory);
+
+/*
+    This function make one free chunk from segment and put fence after it.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN begin_p - begin of segment, aligned to SSA_ALIGNMENT.
+    @IN size - size of segment.
+
+    RETURN:
+    This is void function.
+*/
+static void __segment_init(Ssa_heap* const heap_p, uint8_t* begin_p, const size_t size);
+
+/*
+    This function map new segment with free chunk of at least @req_memory bytes, if heap does not exceed its maximal
+    size.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN req_memory - requested size of chunk.
+
+    RETURN:
+    @true if heap grows.
+    @false if failure.
+*/
+static bool __heap_grow(Ssa_heap* const heap_p, const size_t req_memory);
+
+/*
+    This function find free chunk like __free_list_find and grow heap if there is no such chunk.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN req_memory - requested size of chunk.
+
+    RETURN:
+    @NULL if there is no such chunk.
+    @Pointer to chunk if success.
+*/
+static Chunk_header* __free_chunk_get(Ssa_heap* const heap_p, const size_t req_memory);
+
+/*
+    This function map chunk for @bytes and put it on list of mapped chunks.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN bytes - requested memory size in bytes.
+    @IN alignment - alignment of returned address, power of two not bigger than page.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __mapped_alloc(Ssa_heap* const heap_p, const size_t bytes, const size_t alignment);
+
+/*
+    This function remove chunk from list of mapped chunks and unmap it.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN header_p - pointer to mapped chunk.
+
+    RETURN:
+    This is void function.
+*/
+static void __mapped_dealloc(Ssa_heap* const heap_p, Chunk_header* header_p);
+
+/*
+    This function change size of mapped chunk by mremap, kernel moves pages if mapping can not grow in place.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN header_p - pointer to mapped chunk.
+    @IN bytes - new memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __mapped_realloc(Ssa_heap* const heap_p, Chunk_header* header_p, const size_t bytes);
+
+/*
+    This function unmap mapped chunks and segments of heap.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+
+    RETURN:
+    This is void function.
+*/
+static void __heap_release(Ssa_heap* const heap_p);
+
+/*
+    This function release heap and make one free chunk from @begin_p memory, see ssa_init.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN begin_p - begin of the first segment, aligned to SSA_ALIGNMENT.
+    @IN size - size of the first segment.
+    @IN max_size_of_heap - heap grows by mapped segments up to this size, @size if heap should not grow.
+
+    RETURN:
+    This is void function.
+*/
+static void __heap_init(Ssa_heap* const heap_p,
+                        uint8_t* const begin_p,
+                        const size_t size,
+                        const size_t max_size_of_heap);
+
+/*
+    This function allocate chunk from heap, see ssa_alloc.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __heap_alloc(Ssa_heap* const heap_p, const size_t bytes);
+
+/*
+    This function allocate aligned chunk from heap, see ssa_alloc_aligned.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN bytes - requested memory size in bytes.
+    @IN alignment - requested alignment, power of two.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __heap_alloc_aligned(Ssa_heap* const heap_p, const size_t bytes, const size_t alignment);
+
+/*
+    This function free chunk of heap, see ssa_dealloc.
+
+    PARAMS:
+    @IN heap_p - pointer to heap which owns chunk.
+    @IN addr_p - pointer to memory for freeing.
+
+    RETURN:
+    This is void function.
+*/
+static void __heap_dealloc(Ssa_heap* const heap_p, void* addr_p);
+
+/*
+    This function change size of chunk of heap, see ssa_realloc.
+
+    PARAMS:
+    @IN heap_p - pointer to heap which owns chunk.
+    @IN addr_p - pointer to allocated memory.
+    @IN bytes - new memory size in bytes.
+
+    RETURN:
+    @NULL if failure or @bytes is 0.
+    @address if success.
+*/
+static void* __heap_realloc(Ssa_heap* const heap_p, void* addr_p, const size_t bytes);
+
+/*
+    This function fill statistics of heap.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @OUT stats_p - pointer to statistics.
+
+    RETURN:
+    This is void function.
+*/
+static void __heap_read_statistics(const Ssa_heap* const heap_p, Ssa_statistics* stats_p);
+
+/*
+    This function find size of the largest free chunk of heap, only the highest not empty bin is walked.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+
+    RETURN:
+    Size of the largest free chunk, 0 if there is no free chunk.
+*/
+static size_t __heap_get_largest_free_chunk(const Ssa_heap* const heap_p);
+
+/*
+    This function add served request to counters of internal waste.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @IN addr_p - address returned for request, NULL is not counted.
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @addr_p, so result of allocation can be returned through this function.
+*/
+static void* __heap_count_request(Ssa_heap* const heap_p, void* addr_p, const size_t bytes);
+
+/*
+    This function fill fragmentation report of heap.
+
+    PARAMS:
+    @IN heap_p - pointer to heap.
+    @OUT frag_p - pointer to fragmentation report.
+
+    RETURN:
+    This is void function.
+*/
+static void __heap_read_fragmentation(const Ssa_heap* const heap_p, Ssa_fragmentation* frag_p);
+
+/*
+    This function compute external fragmentation and internal waste of report from its counters.
+
+    PARAMS:
+    @IN frag_p - pointer to fragmentation report.
+
+    RETURN:
+    This is void function.
+*/
+static void __fragmentation_set_ratios(Ssa_fragmentation* frag_p);
+
+/*
+    This function zero @bytes of allocated chunk, chunk with own mapping is skipped.
+
+    PARAMS:
+    @IN addr_p - pointer to allocated memory.
+    @IN bytes - number of bytes to zero.
+
+    RETURN:
+    This is void function.
+*/
+static void __chunk_zero(void* addr_p, const size_t bytes);
+
+/*
+    This function give arena of calling thread, see SSA_ARENA_BY_CPU.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    Pointer to arena.
+*/
+static Ssa_arena* __arena_get(void);
+
+/*
+    This function find arena which owns allocated chunk. Chunk of heap is found by range of arena, chunk outside of
+    arenas is mapped one if it keeps heap of one of arenas in descriptor. Otherwise it is chunk of default heap.
+
+    PARAMS:
+    @IN addr_p - pointer to chunk allocated by arenas or by default heap, its header is read.
+
+    RETURN:
+    @NULL if chunk was not allocated by arenas.
+    @Pointer to arena if success.
+*/
+static Ssa_arena* __arena_find(void* addr_p);
+
+/*
+    This function push chunk on queue of remote frees of arena. It does not take any lock, chunk is freed when owner
+    drains the queue.
+
+    PARAMS:
+    @IN arena_p - pointer to arena which owns chunk.
+    @IN addr_p - pointer to allocated memory.
+
+    RETURN:
+    This is void function.
+*/
+static void __remote_free_push(Ssa_arena* const arena_p, void* addr_p);
+
+/*
+    This function take all chunks from queue of remote frees at once and free them in heap of arena. Lock of arena
+    has to be taken.
+
+    PARAMS:
+    @IN arena_p - pointer to arena.
+
+    RETURN:
+    This is void function.
+*/
+static void __remote_free_drain(Ssa_arena* const arena_p);
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline size_t __bin_index(const size_t size_of)
+{
+    return (size_t)(NR_OF_BINS - 1 - __builtin_clzll((unsigned long long)size_of));
+}
+
+static void __free_list_push(Ssa_heap* const heap_p, Chunk_header* header_p)
+{
+    Free_chunk_header* const chunk_p = (Free_chunk_header*)header_p;
+    const size_t bin = __bin_index(chunk_p->header.size_of);
+
+    chunk_p->prev = NULL;
+    chunk_p->next = heap_p->bins[bin];
+
+    if (heap_p->bins[bin] != NULL)
+    {
+        heap_p->bins[bin]->prev = chunk_p;
+    }
+
+    heap_p->bins[bin] = chunk_p;
+    heap_p->bins_bitmap |= (uint64_t)1 << bin;
+
+    ++heap_p->nr_of_chunks_in_bins[bin];
+    heap_p->free_bytes += chunk_p->header.size_of;
+    ++heap_p->statistics.nr_of_free_chunks;
+}
+
+static void __free_list_remove(Ssa_heap* const heap_p, Chunk_header* header_p)
+{
+    Free_chunk_header* const chunk_p = (Free_chunk_header*)header_p;
+    const size_t bin = __bin_index(chunk_p->header.size_of);
+
+    if (chunk_p->prev != NULL)
+    {
+        chunk_p->prev->next = chunk_p->next;
+    }
+    else
+    {
+        heap_p->bins[bin] = chunk_p->next;
+    }
+
+    if (chunk_p->next != NULL)
+    {
+        chunk_p->next->prev = chunk_p->prev;
+    }
+
+    if (heap_p->bins[bin] == NULL)
+    {
+        heap_p->bins_bitmap &= ~((uint64_t)1 << bin);
+    }
+
+    --heap_p->nr_of_chunks_in_bins[bin];
+    heap_p->free_bytes -= chunk_p->header.size_of;
+    --heap_p->statistics.nr_of_free_chunks;
+}
+
+static Chunk_header* __free_list_find(Ssa_heap* const heap_p, const size_t req_memory)
+{
+    const size_t bin = __bin_index(req_memory);
+
+    /* chunks in the same bin could be smaller than request */
+    for (Free_chunk_header* chunk_p = heap_p->bins[bin]; chunk_p != NULL; chunk_p = chunk_p->next)
+    {
+        if (chunk_p->header.size_of >= req_memory)
+        {
+            return (Chunk_header*)chunk_p;
+        }
+    }
+
+    const uint64_t bigger_bins = bin + 1 < NR_OF_BINS ? heap_p->bins_bitmap & (UINT64_MAX << (bin + 1)) : 0;
+
+    if (bigger_bins == 0)
+    {
+        return NULL;
+    }
+
+    return (Chunk_header*)heap_p->bins[__builtin_ctzll(bigger_bins)];
+}
+
+static void __free_chunk_set(Chunk_header* header_p, const size_t size_of)
+{
+    const uint64_t footer = (uint64_t)size_of & SIZE_MASK;
+
+    header_p->is_allocated = false;
+    header_p->is_mmapped = false;
+    header_p->size_of = (uint64_t)size_of & SIZE_MASK;
+
+    (void)memcpy((uint8_t*)header_p + size_of - sizeof(footer), &footer, sizeof(footer));
+
+    /* the last chunk is followed by fence, so next chunk always exists */
+    NEXT_CHUNK(header_p)->is_prev_allocated = false;
+}
+
+static void* __chunk_allocate(Ssa_heap* const heap_p,
+                              Chunk_header* header_p,
+                              const size_t size_of,
+                              const size_t req_memory)
+{
+    header_p->is_allocated = true;
+    header_p->is_mmapped = false;
+    header_p->size_of = (uint64_t)size_of & SIZE_MASK;
+
+    /* rest of chunk is split off only if it can be free chunk */
+    if (size_of - req_memory >= MIN_CHUNK_SIZE)
+    {
+        header_p->size_of = (uint64_t)req_memory & SIZE_MASK;
+
+        Chunk_header* const rest_p = NEXT_CHUNK(header_p);
+        rest_p->is_prev_allocated = true;
+
+        __free_chunk_set(rest_p, size_of - req_memory);
+        __free_list_push(heap_p, rest_p);
+    }
+    else
+    {
+        NEXT_CHUNK(header_p)->is_prev_allocated = true;
+    }
+
+    ++heap_p->statistics.nr_of_allocs;
+    ++heap_p->statistics.nr_of_chunks_in_use;
+    heap_p->statistics.bytes_in_use += header_p->size_of;
+
+    if (heap_p->statistics.bytes_in_use > heap_p->statistics.peak_bytes_in_use)
+    {
+        heap_p->statistics.peak_bytes_in_use = heap_p->statistics.bytes_in_use;
+    }
+
+    return (uint8_t*)header_p + sizeof(Chunk_header);
+}
+
+static void __segment_init(Ssa_heap* const heap_p, uint8_t* begin_p, const size_t size)
+{
+    Chunk_header* const header_p = (Chunk_header*)(void*)(begin_p + FIRST_CHUNK_OFFSET);
+    const size_t size_of = (size - FIRST_CHUNK_OFFSET - sizeof(Chunk_header)) & ~(size_t)(SSA_ALIGNMENT - 1);
+
+    /* fence is never free, so the last chunk is not merged with it */
+    Chunk_header* const fence_p = (Chunk_header*)(void*)((uint8_t*)header_p + size_of);
+    fence_p->is_allocated = true;
+    fence_p->is_mmapped = false;
+    fence_p->size_of = 0;
+
+    /* there is no chunk before the first one, so it can not be merged with anything */
+    header_p->is_prev_allocated = true;
+
+    __free_chunk_set(header_p, size_of);
+    __free_list_push(heap_p, header_p);
+}
+
+static bool __heap_grow(Ssa_heap* const heap_p, const size_t req_memory)
+{
+    const size_t size_left = heap_p->max_size_of_heap - heap_p->statistics.size_of_heap;
+
+    if (req_memory > size_left || size_left - req_memory < SEGMENT_OVERHEAD)
+    {
+        return false;
+    }
+
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = req_memory + SEGMENT_OVERHEAD < SSA_SEGMENT_SIZE ? SSA_SEGMENT_SIZE : req_memory + SEGMENT_OVERHEAD;
+    size = (size + page_size - 1) & ~(page_size - 1);
+
+    /* the last segment takes what is left */
+    if (size > size_left)
+    {
+        size = size_left;
+    }
+
+    /* pages are committed by kernel on first touch */
+    void* const region_p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (region_p == MAP_FAILED)
+    {
+        return false;
+    }
+
+    Segment* const segment_p = (Segment*)region_p;
+    segment_p->size = size;
+    segment_p->next = heap_p->segments;
+    heap_p->segments = segment_p;
+
+    heap_p->statistics.size_of_heap += size;
+    ++heap_p->statistics.nr_of_segments;
+
+    __segment_init(heap_p, (uint8_t*)region_p + SEGMENT_HEADER_SIZE, size - SEGMENT_HEADER_SIZE);
+
+    return true;
+}
+
+static Chunk_header* __free_chunk_get(Ssa_heap* const heap_p, const size_t req_memory)
+{
+    Chunk_header* const header_p = __free_list_find(heap_p, req_memory);
+
+    if (header_p != NULL || __heap_grow(heap_p, req_memory) == false)
+    {
+        return header_p;
+    }
+
+    return __free_list_find(heap_p, req_memory);
+}
+
+static void* __mapped_alloc(Ssa_heap* const heap_p, const size_t bytes, const size_t alignment)
+{
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t offset = (sizeof(Mapped_chunk) + sizeof(Chunk_header) + alignment - 1) & ~(alignment - 1);
+
+    if (bytes > SIZE_MASK - offset - page_size)
+    {
+        return NULL;
+    }
+
+    const size_t size = (offset + bytes + page_size - 1) & ~(page_size - 1);
+    uint8_t* const base_p = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if ((void*)base_p == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    Chunk_header* const header_p = (Chunk_header*)(void*)(base_p + offset - sizeof(Chunk_header));
+    header_p->is_allocated = true;
+    header_p->is_prev_allocated = true;
+    header_p->is_mmapped = true;
+    header_p->size_of = (uint64_t)size & SIZE_MASK;
+
+    Mapped_chunk* const mapped_p = MAPPED_CHUNK(header_p);
+    mapped_p->base_p = base_p;
+    mapped_p->size = size;
+    mapped_p->heap_p = heap_p;
+    mapped_p->prev = NULL;
+    mapped_p->next = heap_p->mapped_chunks;
+
+    if (heap_p->mapped_chunks != NULL)
+    {
+        heap_p->mapped_chunks->prev = mapped_p;
+    }
+
+    heap_p->mapped_chunks = mapped_p;
+
+    ++heap_p->statistics.nr_of_allocs;
+    ++heap_p->statistics.nr_of_chunks_in_use;
+    ++heap_p->statistics.nr_of_mapped_chunks;
+    heap_p->statistics.bytes_in_use += size;
+
+    if (heap_p->statistics.bytes_in_use > heap_p->statistics.peak_bytes_in_use)
+    {
+        heap_p->statistics.peak_bytes_in_use = heap_p->statistics.bytes_in_use;
+    }
+
+    return base_p + offset;
+}
+
+static void __mapped_dealloc(Ssa_heap* const heap_p, Chunk_header* header_p)
+{
+    Mapped_chunk* const mapped_p = MAPPED_CHUNK(header_p);
+
+    if (mapped_p->prev != NULL)
+    {
+        mapped_p->prev->next = mapped_p->next;
+    }
+    else
+    {
+        heap_p->mapped_chunks = mapped_p->next;
+    }
+
+    if (mapped_p->next != NULL)
+    {
+        mapped_p->next->prev = mapped_p->prev;
+    }
+
+    ++heap_p->statistics.nr_of_frees;
+    --heap_p->statistics.nr_of_chunks_in_use;
+    --heap_p->statistics.nr_of_mapped_chunks;
+    heap_p->statistics.bytes_in_use -= mapped_p->size;
+
+    (void)munmap(mapped_p->base_p, mapped_p->size);
+}
+
+static void* __mapped_realloc(Ssa_heap* const heap_p, Chunk_header* header_p, const size_t bytes)
+{
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    Mapped_chunk* const mapped_p = MAPPED_CHUNK(header_p);
+    const size_t offset = (size_t)((uint8_t*)header_p + sizeof(Chunk_header) - mapped_p->base_p);
+
+    if (bytes > SIZE_MASK - offset - page_size)
+    {
+        return NULL;
+    }
+
+    const size_t old_size = mapped_p->size;
+    const size_t size = (offset + bytes + page_size - 1) & ~(page_size - 1);
+
+    if (size == old_size)
+    {
+        return (uint8_t*)header_p + sizeof(Chunk_header);
+    }
+
+    uint8_t* const base_p = (uint8_t*)mremap(mapped_p->base_p, old_size, size, MREMAP_MAYMOVE);
+
+    if ((void*)base_p == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    /* descriptor could be moved with pages, so neighbours on list have to point to its new place */
+    Chunk_header* const new_header_p = (Chunk_header*)(void*)(base_p + offset - sizeof(Chunk_header));
+    Mapped_chunk* const new_mapped_p = MAPPED_CHUNK(new_header_p);
+
+    new_mapped_p->base_p = base_p;
+    new_mapped_p->size = size;
+    new_header_p->size_of = (uint64_t)size & SIZE_MASK;
+
+    if (new_mapped_p->prev != NULL)
+    {
+        new_mapped_p->prev->next = new_mapped_p;
+    }
+    else
+    {
+        heap_p->mapped_chunks = new_mapped_p;
+    }
+
+    if (new_mapped_p->next != NULL)
+    {
+        new_mapped_p->next->prev = new_mapped_p;
+    }
+
+    heap_p->statistics.bytes_in_use = heap_p->statistics.bytes_in_use - old_size + size;
+
+    if (heap_p->statistics.bytes_in_use > heap_p->statistics.peak_bytes_in_use)
+    {
+        heap_p->statistics.peak_bytes_in_use = heap_p->statistics.bytes_in_use;
+    }
+
+    return base_p + offset;
+}
+
+static void __heap_release(Ssa_heap* const heap_p)
+{
+    while (heap_p->mapped_chunks != NULL)
+    {
+        Mapped_chunk* const mapped_p = heap_p->mapped_chunks;
+        heap_p->mapped_chunks = mapped_p->next;
+
+        (void)munmap(mapped_p->base_p, mapped_p->size);
+    }
+
+    while (heap_p->segments != NULL)
+    {
+        Segment* const segment_p = heap_p->segments;
+        heap_p->segments = segment_p->next;
+
+        (void)munmap(segment_p, segment_p->size);
+    }
+}
+
+static void __heap_init(Ssa_heap* const heap_p,
+                        uint8_t* const begin_p,
+                        const size_t size,
+                        const size_t max_size_of_heap)
+{
+    __heap_release(heap_p);
+
+    /* only headers of the first chunk and fence are written, memory is not zeroed (see ssa_calloc) */
+    (void)memset(&heap_p->statistics, 0, sizeof(heap_p->statistics));
+
+    for (size_t i = 0; i < NR_OF_BINS; ++i)
+    {
+        heap_p->bins[i] = NULL;
+        heap_p->nr_of_chunks_in_bins[i] = 0;
+    }
+
+    heap_p->bins_bitmap = 0;
+    heap_p->free_bytes = 0;
+    heap_p->requested_bytes = 0;
+    heap_p->allocated_bytes = 0;
+    heap_p->max_size_of_heap = max_size_of_heap;
+    heap_p->statistics.size_of_heap = size;
+    heap_p->statistics.nr_of_segments = 1;
+
+    __segment_init(heap_p, begin_p, size);
+}
+
+static void* __heap_alloc(Ssa_heap* const heap_p, const size_t bytes)
+{
+    if (bytes == 0)
+    {
+        return NULL;
+    }
+
+    /* big chunk does not split heap, it gets own mapping */
+    if (mmap_threshold != 0 && bytes > mmap_threshold)
+    {
+        void* const addr_p = __mapped_alloc(heap_p, bytes, SSA_ALIGNMENT);
+
+        if (addr_p == NULL)
+        {
+            ++heap_p->statistics.nr_of_failures;
+        }
+
+        return __heap_count_request(heap_p, addr_p, bytes);
+    }
+
+    if (bytes > (heap_p->max_size_of_heap - sizeof(Chunk_header)))
+    {
+        ++heap_p->statistics.nr_of_failures;
+        return NULL;
+    }
+
+    const size_t aligned = (bytes + sizeof(Chunk_header) + SSA_ALIGNMENT - 1) & ~(size_t)(SSA_ALIGNMENT - 1);
+    const size_t req_memory = aligned < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : aligned;
+    Chunk_header* const header_p = __free_chunk_get(heap_p, req_memory);
+
+    if (header_p == NULL)
+    {
+        ++heap_p->statistics.nr_of_failures;
+        return NULL;
+    }
+
+    __free_list_remove(heap_p, header_p);
+
+    return __heap_count_request(heap_p, __chunk_allocate(heap_p, header_p, header_p->size_of, req_memory), bytes);
+}
+
+static void* __heap_alloc_aligned(Ssa_heap* const heap_p, const size_t bytes, const size_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return NULL;
+    }
+
+    if (alignment <= SSA_ALIGNMENT)
+    {
+        return __heap_alloc(heap_p, bytes);
+    }
+
+    if (bytes == 0)
+    {
+        return NULL;
+    }
+
+    if (mmap_threshold != 0 && bytes > mmap_threshold && alignment <= (size_t)sysconf(_SC_PAGESIZE))
+    {
+        void* const addr_p = __mapped_alloc(heap_p, bytes, alignment);
+
+        if (addr_p == NULL)
+        {
+            ++heap_p->statistics.nr_of_failures;
+        }
+
+        return __heap_count_request(heap_p, addr_p, bytes);
+    }
+
+    if (bytes > (heap_p->max_size_of_heap - sizeof(Chunk_header)) || alignment > heap_p->max_size_of_heap)
+    {
+        ++heap_p->statistics.nr_of_failures;
+        return NULL;
+    }
+
+    const size_t aligned = (bytes + sizeof(Chunk_header) + SSA_ALIGNMENT - 1) & ~(size_t)(SSA_ALIGNMENT - 1);
+    const size_t req_memory = aligned < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : aligned;
+
+    /* padding is smaller than alignment plus the smallest free chunk, so such chunk always fits */
+    Chunk_header* const header_p = __free_chunk_get(heap_p, req_memory + alignment + MIN_CHUNK_SIZE);
+
+    if (header_p == NULL)
+    {
+        ++heap_p->statistics.nr_of_failures;
+        return NULL;
+    }
+
+    __free_list_remove(heap_p, header_p);
+
+    const size_t size_of = header_p->size_of;
+    const uintptr_t addr = (uintptr_t)header_p + sizeof(Chunk_header);
+    size_t padding = (size_t)(((addr + alignment - 1) & ~(uintptr_t)(alignment - 1)) - addr);
+
+    /* padding in front of chunk has to be free chunk */
+    if (padding != 0 && padding < MIN_CHUNK_SIZE)
+    {
+        padding += alignment;
+    }
+
+    if (padding != 0)
+    {
+        __free_chunk_set(header_p, padding);
+        __free_list_push(heap_p, header_p);
+    }
+
+    Chunk_header* const aligned_header_p = (Chunk_header*)(void*)((uint8_t*)header_p + padding);
+
+    return __heap_count_request(heap_p, __chunk_allocate(heap_p, aligned_header_p, size_of - padding, req_memory),
+                                bytes);
+}
+
+static void __heap_dealloc(Ssa_heap* const heap_p, void* addr_p)
+{
+    if (addr_p == NULL)
+    {
+        return;
+    }
+
+    Chunk_header* header_p = (Chunk_header*)(void*)((uint8_t*)addr_p - sizeof(Chunk_header));
+
+    if (header_p->is_mmapped == true)
+    {
+        __mapped_dealloc(heap_p, header_p);
+        return;
+    }
+
+    size_t size_of = header_p->size_of;
+
+    ++heap_p->statistics.nr_of_frees;
+    --heap_p->statistics.nr_of_chunks_in_use;
+    heap_p->statistics.bytes_in_use -= size_of;
+
+    /* merge with next chunk */
+    Chunk_header* const next_header_p = NEXT_CHUNK(header_p);
+
+    if (next_header_p->is_allocated == false)
+    {
+        __free_list_remove(heap_p, next_header_p);
+        size_of += next_header_p->size_of;
+    }
+
+    /* merge with previous chunk, its size is kept in footer */
+    if (header_p->is_prev_allocated == false)
+    {
+        uint64_t prev_size_of;
+        (void)memcpy(&prev_size_of, (uint8_t*)header_p - sizeof(prev_size_of), sizeof(prev_size_of));
+
+        header_p = (Chunk_header*)(void*)((uint8_t*)header_p - prev_size_of);
+        size_of += prev_size_of;
+
+        __free_list_remove(heap_p, header_p);
+    }
+
+    __free_chunk_set(header_p, size_of);
+    __free_list_push(heap_p, header_p);
+}
+
+static void* __heap_realloc(Ssa_heap* const heap_p, void* addr_p, const size_t bytes)
+{
+    if (addr_p == NULL)
+    {
+        return __heap_alloc(heap_p, bytes);
+    }
+
+    if (bytes == 0)
+    {
+        __heap_dealloc(heap_p, addr_p);
+        return NULL;
+    }
+
+    Chunk_header* const header_p = (Chunk_header*)(void*)((uint8_t*)addr_p - sizeof(Chunk_header));
+    const bool is_big = mmap_threshold != 0 && bytes > mmap_threshold;
+
+    if (header_p->is_mmapped == true)
+    {
+        if (is_big == true)
+        {
+            void* const new_addr_p = __mapped_realloc(heap_p, header_p, bytes);
+
+            if (new_addr_p == NULL)
+            {
+                ++heap_p->statistics.nr_of_failures;
+            }
+
+            return __heap_count_request(heap_p, new_addr_p, bytes);
+        }
+
+        /* chunk is small now, so it goes back to heap, new size is smaller than payload of mapped chunk */
+        void* const new_addr_p = __heap_alloc(heap_p, bytes);
 
-/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+        if (new_addr_p == NULL)
+        {
+            return NULL;
+        }
 
-/* macro for calculating size of arrays allocated on stack */
-#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+        (void)memcpy(new_addr_p, addr_p, bytes);
+        __heap_dealloc(heap_p, addr_p);
 
-/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+        return new_addr_p;
+    }
 
-/* memory for allocations */
-static uint8_t memory[MEMORY_SIZE];
+    if (bytes > (heap_p->max_size_of_heap - sizeof(Chunk_header)) && is_big == false)
+    {
+        ++heap_p->statistics.nr_of_failures;
+        return NULL;
+    }
 
-/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+    const size_t aligned = (bytes + sizeof(Chunk_header) + SSA_ALIGNMENT - 1) & ~(size_t)(SSA_ALIGNMENT - 1);
+    const size_t req_memory = aligned < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : aligned;
 
-struct Chunk_header
-{
-    uint32_t is_allocated : 1;
-    uint32_t size_of : 31;
-};
+    const size_t old_size_of = header_p->size_of;
+    size_t size_of = old_size_of;
 
-struct Memory_statistic
-{
-    size_t nr_of_allocated_chunks;
-    size_t* size_of_allocated_chunks_p;
+    if (size_of < req_memory)
+    {
+        Chunk_header* const next_header_p = NEXT_CHUNK(header_p);
 
-    size_t nr_of_free_chunks;
-    size_t* size_of_free_chunks_p;
-};
+        /* there is no place after chunk or chunk is big now, so it has to be moved */
+        if (is_big == true || next_header_p->is_allocated == true || size_of + next_header_p->size_of < req_memory)
+        {
+            void* const new_addr_p = __heap_alloc(heap_p, bytes);
 
-typedef struct Memory_statistic Memory_statistic;
+            if (new_addr_p == NULL)
+            {
+                return NULL;
+            }
 
-/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+            (void)memcpy(new_addr_p, addr_p, size_of - sizeof(Chunk_header));
+            __heap_dealloc(heap_p, addr_p);
 
-/*
-	This function is responsible for collect informations about allocated/free memory chunks.
+            return new_addr_p;
+        }
 
-	PARAMS:
-	@IN - void
+        /* grow into the next chunk */
+        __free_list_remove(heap_p, next_header_p);
+        size_of += next_header_p->size_of;
 
-	RETURN:
-	@Pointer to Memory_statistic
-*/
-static Memory_statistic* __memory_get_statistic(void);
+        header_p->size_of = (uint64_t)size_of & SIZE_MASK;
+        NEXT_CHUNK(header_p)->is_prev_allocated = true;
+    }
 
-/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+    /* shrink, tail is merged with the next chunk if it is free */
+    if (size_of - req_memory >= MIN_CHUNK_SIZE)
+    {
+        Chunk_header* const next_header_p = NEXT_CHUNK(header_p);
+        size_t tail_size_of = size_of - req_memory;
+
+        header_p->size_of = (uint64_t)req_memory & SIZE_MASK;
+
+        Chunk_header* const tail_p = NEXT_CHUNK(header_p);
+        tail_p->is_prev_allocated = true;
+
+        if (next_header_p->is_allocated == false)
+        {
+            __free_list_remove(heap_p, next_header_p);
+            tail_size_of += next_header_p->size_of;
+        }
 
-static Memory_statistic* __memory_get_statistic(void)
+        __free_chunk_set(tail_p, tail_size_of);
+        __free_list_push(heap_p, tail_p);
+    }
+
+    heap_p->statistics.bytes_in_use = heap_p->statistics.bytes_in_use - old_size_of + header_p->size_of;
+
+    if (heap_p->statistics.bytes_in_use > heap_p->statistics.peak_bytes_in_use)
+    {
+        heap_p->statistics.peak_bytes_in_use = heap_p->statistics.bytes_in_use;
+    }
+
+    return __heap_count_request(heap_p, addr_p, bytes);
+}
+
+static void __heap_read_statistics(const Ssa_heap* const heap_p, Ssa_statistics* stats_p)
 {
-    Memory_statistic* ms_p = (Memory_statistic*)calloc(1, sizeof(*ms_p));
-    assert(ms_p != NULL);
+    *stats_p = heap_p->statistics;
+    stats_p->size_of_largest_free_chunk = __heap_get_largest_free_chunk(heap_p);
+}
 
-    Chunk_header* header_p;
+static size_t __heap_get_largest_free_chunk(const Ssa_heap* const heap_p)
+{
+    size_t largest = 0;
 
-    for (size_t offset = 0; offset < MEMORY_SIZE; offset += header_p->size_of)
+    /* the largest free chunk is in the highest not empty bin */
+    if (heap_p->bins_bitmap != 0)
     {
-        header_p = (Chunk_header*)&memory[offset];
+        const size_t bin = __bin_index((size_t)heap_p->bins_bitmap);
 
-        if (header_p->is_allocated == true)
-        {
-            ++ms_p->nr_of_allocated_chunks;
-        }
-        else
+        for (const Free_chunk_header* chunk_p = heap_p->bins[bin]; chunk_p != NULL; chunk_p = chunk_p->next)
         {
-            ++ms_p->nr_of_free_chunks;
+            if (chunk_p->header.size_of > largest)
+            {
+                largest = chunk_p->header.size_of;
+            }
         }
     }
 
-    if (ms_p->nr_of_allocated_chunks > 0)
+    return largest;
+}
+
+static void* __heap_count_request(Ssa_heap* const heap_p, void* addr_p, const size_t bytes)
+{
+    if (addr_p != NULL)
     {
-        ms_p->size_of_allocated_chunks_p = (size_t*)calloc(ms_p->nr_of_allocated_chunks, 
-                                                           sizeof(*ms_p->size_of_allocated_chunks_p));
-        assert(ms_p->size_of_allocated_chunks_p != NULL);
+        const Chunk_header* const header_p =
+            (const Chunk_header*)(const void*)((const uint8_t*)addr_p - sizeof(Chunk_header));
+
+        /* mapped chunk keeps size of mapping in size_of */
+        heap_p->requested_bytes += bytes;
+        heap_p->allocated_bytes += header_p->size_of;
     }
 
-    if (ms_p->nr_of_free_chunks > 0)
+    return addr_p;
+}
+
+static void __heap_read_fragmentation(const Ssa_heap* const heap_p, Ssa_fragmentation* frag_p)
+{
+    *frag_p = (Ssa_fragmentation){0};
+
+    for (size_t i = 0; i < NR_OF_BINS; ++i)
     {
-        ms_p->size_of_free_chunks_p = (size_t*)calloc(ms_p->nr_of_free_chunks, 
-                                                      sizeof(*ms_p->size_of_free_chunks_p));
-        assert(ms_p->size_of_free_chunks_p != NULL);
+        frag_p->free_extents[i] = heap_p->nr_of_chunks_in_bins[i];
     }
 
-    size_t nr_of_allocated_chunks = 0;
-    size_t nr_of_free_chunks = 0;
+    frag_p->nr_of_free_extents = heap_p->statistics.nr_of_free_chunks;
+    frag_p->free_bytes = heap_p->free_bytes;
+    frag_p->size_of_largest_free_extent = __heap_get_largest_free_chunk(heap_p);
+    frag_p->requested_bytes = heap_p->requested_bytes;
+    frag_p->allocated_bytes = heap_p->allocated_bytes;
 
-    for (size_t offset = 0; offset < MEMORY_SIZE; offset += header_p->size_of)
-    {
-        header_p = (Chunk_header*)&memory[offset];
+    __fragmentation_set_ratios(frag_p);
+}
 
-        if (header_p->is_allocated == true)
-        {
-            ms_p->size_of_allocated_chunks_p[nr_of_allocated_chunks] = (size_t)header_p->size_of;
-            ++nr_of_allocated_chunks;
-        }
-        else
-        {
-            ms_p->size_of_free_chunks_p[nr_of_free_chunks] = (size_t)header_p->size_of;
-            ++nr_of_free_chunks;
-        }
+static void __fragmentation_set_ratios(Ssa_fragmentation* frag_p)
+{
+    frag_p->external_fragmentation = 0.0;
+    frag_p->internal_waste = 0.0;
+
+    if (frag_p->free_bytes > 0)
+    {
+        frag_p->external_fragmentation =
+            1.0 - (double)frag_p->size_of_largest_free_extent / (double)frag_p->free_bytes;
     }
 
-    return ms_p;
+    if (frag_p->allocated_bytes > 0)
+    {
+        frag_p->internal_waste = 1.0 - (double)frag_p->requested_bytes / (double)frag_p->allocated_bytes;
+    }
 }
 
-/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+static void __chunk_zero(void* addr_p, const size_t bytes)
+{
+    const Chunk_header* const header_p =
+        (const Chunk_header*)(const void*)((const uint8_t*)addr_p - sizeof(Chunk_header));
 
-void ssa_init(void)
+    /* fresh mapping is zeroed by kernel */
+    if (header_p->is_mmapped == false)
+    {
+        (void)memset(addr_p, 0, bytes);
+    }
+}
+
+static Ssa_arena* __arena_get(void)
 {
-    (void)memset(&memory[0], 0, sizeof(memory));
+#ifdef SSA_ARENA_BY_CPU
+    const int cpu = sched_getcpu();
 
-    Chunk_header* const header_p = (Chunk_header*)&memory[0];
+    return &arenas[cpu < 0 ? 0 : (size_t)cpu % nr_of_arenas];
+#else
+    /* threads get arenas round-robin when they allocate for the first time */
+    if (thread_arena == 0)
+    {
+        thread_arena = __atomic_fetch_add(&next_arena, 1, __ATOMIC_RELAXED) + 1;
+    }
 
-    header_p->is_allocated = false;
-    header_p->size_of = sizeof(memory);
+    return &arenas[(thread_arena - 1) % nr_of_arenas];
+#endif
 }
 
-void* ssa_alloc(const size_t bytes)
+static Ssa_arena* __arena_find(void* addr_p)
 {
-    if (bytes == 0 || bytes > (MEMORY_SIZE - sizeof(Chunk_header)))
+    const uintptr_t addr = (uintptr_t)addr_p;
+    const uintptr_t begin = (uintptr_t)arenas_memory_p;
+
+    /* header of chunk in arena is not read, neighbour could change its is_prev_allocated under lock of arena */
+    if (addr >= begin && addr - begin < nr_of_arenas * (size_t)SSA_ARENA_SIZE)
+    {
+        return &arenas[(addr - begin) / SSA_ARENA_SIZE];
+    }
+
+    const Chunk_header* const header_p =
+        (const Chunk_header*)(const void*)((const uint8_t*)addr_p - sizeof(Chunk_header));
+
+    if (header_p->is_mmapped == false)
     {
         return NULL;
     }
 
-    Chunk_header* header_p = NULL;
-    const size_t req_memory = bytes + sizeof(*header_p);
-    
-    /* first fit allocation */
-    for (size_t offset = 0; offset < MEMORY_SIZE; offset += header_p->size_of)
+    /* heap of default mapped chunk is not heap of arena, lower one wraps around */
+    const size_t offset = (size_t)((uintptr_t)MAPPED_CHUNK(header_p)->heap_p - (uintptr_t)&arenas[0].heap);
+
+    if (offset >= nr_of_arenas * sizeof(Ssa_arena) || offset % sizeof(Ssa_arena) != 0)
     {
-        header_p = (Chunk_header*)&memory[offset];
+        return NULL;
+    }
 
-        if (header_p->is_allocated == false && header_p->size_of > req_memory)
-        {
-            const size_t old_size_of = header_p->size_of;
+    return &arenas[offset / sizeof(Ssa_arena)];
+}
+
+static void __remote_free_push(Ssa_arena* const arena_p, void* addr_p)
+{
+    Remote_free* const node_p = (Remote_free*)addr_p;
+    Remote_free* head_p = __atomic_load_n(&arena_p->remote_frees, __ATOMIC_RELAXED);
 
-            header_p->is_allocated = true;
-            header_p->size_of = req_memory;
+    /* only push is done by many threads, drain takes whole stack, so there is no ABA problem */
+    do
+    {
+        node_p->next = head_p;
+    } while (!__atomic_compare_exchange_n(&arena_p->remote_frees,
+                                          &head_p,
+                                          node_p,
+                                          true,
+                                          __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+}
 
-            header_p = (Chunk_header*)&memory[offset + req_memory];
+static void __remote_free_drain(Ssa_arena* const arena_p)
+{
+    /* plain load first, so empty queue does not take cache line from producers */
+    if (__atomic_load_n(&arena_p->remote_frees, __ATOMIC_RELAXED) == NULL)
+    {
+        return;
+    }
 
-            header_p->is_allocated = false;
-            header_p->size_of = old_size_of - req_memory;
+    Remote_free* node_p = __atomic_exchange_n(&arena_p->remote_frees, NULL, __ATOMIC_ACQUIRE);
 
-            return (void*)&memory[offset + sizeof(*header_p)];
-        }
+    while (node_p != NULL)
+    {
+        Remote_free* const next_p = node_p->next;
+
+        __heap_dealloc(&arena_p->heap, node_p);
+        ++arena_p->heap.statistics.nr_of_remote_frees;
+
+        node_p = next_p;
+    }
+}
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+void ssa_init(void)
+{
+    __heap_init(&default_heap, &memory[0], sizeof(memory), SSA_MAX_HEAP_SIZE);
+}
+
+void* ssa_alloc(const size_t bytes)
+{
+    return __heap_alloc(&default_heap, bytes);
+}
+
+void* ssa_calloc(const size_t nr_of_members, const size_t size)
+{
+    size_t bytes;
+
+    if (__builtin_mul_overflow(nr_of_members, size, &bytes))
+    {
+        ++default_heap.statistics.nr_of_failures;
+        return NULL;
+    }
+
+    void* const addr_p = __heap_alloc(&default_heap, bytes);
+
+    if (addr_p != NULL)
+    {
+        __chunk_zero(addr_p, bytes);
     }
 
-    return NULL;
+    return addr_p;
+}
+
+void* ssa_alloc_aligned(const size_t bytes, const size_t alignment)
+{
+    return __heap_alloc_aligned(&default_heap, bytes, alignment);
 }
 
 void ssa_dealloc(void* addr_p)
+{
+    __heap_dealloc(&default_heap, addr_p);
+}
+
+void* ssa_realloc(void* addr_p, const size_t bytes)
+{
+    return __heap_realloc(&default_heap, addr_p, bytes);
+}
+
+void ssa_set_mmap_threshold(const size_t threshold)
+{
+    mmap_threshold = threshold;
+}
+
+size_t ssa_get_usable_size(const void* addr_p)
 {
     if (addr_p == NULL)
     {
-        return;
+        return 0;
     }
 
-    /* mark header under @addr_p as free */
-    ((Chunk_header*)((uint8_t*)addr_p - sizeof(Chunk_header)))->is_allocated = false;
+    const Chunk_header* const header_p =
+        (const Chunk_header*)(const void*)((const uint8_t*)addr_p - sizeof(Chunk_header));
 
-    size_t number_of_chunks = 0;
+    if (header_p->is_mmapped == true)
+    {
+        const Mapped_chunk* const mapped_p = MAPPED_CHUNK(header_p);
+
+        return (size_t)(mapped_p->base_p + mapped_p->size - (const uint8_t*)addr_p);
+    }
 
-    Chunk_header* curr_header_p;
-    Chunk_header* next_header_p;
+    return (size_t)header_p->size_of - sizeof(Chunk_header);
+}
 
-    /* go through memory chunks and merge them if possible */
-    for (size_t offset = 0; offset < MEMORY_SIZE; offset += curr_header_p->size_of, ++number_of_chunks)
+void ssa_read_statistics(Ssa_statistics* stats_p)
+{
+    if (stats_p == NULL)
     {
-        curr_header_p = (Chunk_header*)&memory[offset];
+        return;
+    }
 
-        if (offset + (size_t)curr_header_p->size_of > MEMORY_SIZE)
-        {
-            break;
-        }
-        else
-        {
-            next_header_p = (Chunk_header*)&memory[offset + curr_header_p->size_of];
+    __heap_read_statistics(&default_heap, stats_p);
+}
 
-            if (curr_header_p->is_allocated == false && next_header_p->is_allocated == false)
-            {
-                curr_header_p->size_of += next_header_p->size_of;
-            }
-        }
-    }
+void ssa_get_statistics(void)
+{
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+
+    printf("size of heap = %zu (segments = %zu)\n", stats.size_of_heap, stats.nr_of_segments);
+    printf("number of mapped chunks = %zu\n", stats.nr_of_mapped_chunks);
+    printf("number of allocated chunks = %zu\n", stats.nr_of_chunks_in_use);
+    printf("bytes in use = %zu (peak = %zu)\n", stats.bytes_in_use, stats.peak_bytes_in_use);
+    printf("number of frees chunks = %zu\n", stats.nr_of_free_chunks);
+    printf("size of largest free chunk = %zu\n", stats.size_of_largest_free_chunk);
+    printf("allocs = %zu, frees = %zu, failures = %zu\n", stats.nr_of_allocs, stats.nr_of_frees, stats.nr_of_failures);
+}
 
-    /* This logic in necessary for merge two last free blocks into one */
-    if (number_of_chunks == 2)
+void ssa_read_fragmentation(Ssa_fragmentation* frag_p)
+{
+    if (frag_p == NULL)
     {
-        curr_header_p = (Chunk_header*)&memory[0];
-        next_header_p = (Chunk_header*)&memory[0 + curr_header_p->size_of];
+        return;
+    }
+
+    __heap_read_fragmentation(&default_heap, frag_p);
+}
+
+void ssa_get_fragmentation(void)
+{
+    Ssa_fragmentation frag;
+    ssa_read_fragmentation(&frag);
+
+    printf("free bytes = %zu in %zu extents\n", frag.free_bytes, frag.nr_of_free_extents);
+    printf("size of largest free extent = %zu\n", frag.size_of_largest_free_extent);
+    printf("external fragmentation = %.3f\n", frag.external_fragmentation);
 
-        if (curr_header_p->is_allocated == false && next_header_p->is_allocated == false)
+    for (size_t i = 0; i < SSA_FRAGMENTATION_NR_OF_BUCKETS; ++i)
+    {
+        if (frag.free_extents[i] > 0)
         {
-            curr_header_p->size_of += next_header_p->size_of; 
+            printf("extents of %zu+ bytes = %zu\n", (size_t)1 << i, frag.free_extents[i]);
         }
     }
+
+    printf("requested bytes = %zu, allocated bytes = %zu, internal waste = %.3f\n", frag.requested_bytes,
+           frag.allocated_bytes, frag.internal_waste);
 }
 
-void ssa_get_statistics(void)
+size_t ssa_get_size_of_memory(void)
+{
+    return ARRAY_SIZE(memory);
+}
+
+void* ssa_get_address_from_memory(const size_t index)
 {
-    const Memory_statistic* const ms_p = __memory_get_statistic();
+    return (void*)&memory[index];
+}
 
-    printf("number of allocated chunks = %zu\n", ms_p->nr_of_allocated_chunks);
+bool ssa_arenas_init(const size_t nr)
+{
+    const long nr_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t new_nr_of_arenas = nr != 0 ? nr : (nr_of_cpus > 0 ? (size_t)nr_of_cpus : 1);
 
-    if (ms_p->nr_of_allocated_chunks > 0)
+    if (new_nr_of_arenas > SSA_MAX_NR_OF_ARENAS)
     {
-        double size_of_med = 0;
+        if (nr != 0)
+        {
+            return false;
+        }
 
-        printf("sizes: ");
+        new_nr_of_arenas = SSA_MAX_NR_OF_ARENAS;
+    }
 
-        for (size_t i = 0; i < ms_p->nr_of_allocated_chunks; ++i)
-        {
-            size_of_med += (double)ms_p->size_of_allocated_chunks_p[i];
+    /* one range for all arenas, so owner of chunk is found by subtraction and division */
+    void* const region_p = mmap(NULL,
+                                new_nr_of_arenas * (size_t)SSA_ARENA_SIZE,
+                                PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                                -1,
+                                0);
 
-            printf("%zu ", ms_p->size_of_allocated_chunks_p[i]);
-        }
+    if (region_p == MAP_FAILED)
+    {
+        return false;
+    }
 
-        size_of_med /= (double)ms_p->nr_of_allocated_chunks;
+    for (size_t i = 0; i < nr_of_arenas; ++i)
+    {
+        __heap_release(&arenas[i].heap);
+        (void)pthread_mutex_destroy(&arenas[i].lock);
+    }
 
-        printf("\nsize_of medium = %lf\n", size_of_med);
+    if (arenas_memory_p != NULL)
+    {
+        (void)munmap(arenas_memory_p, nr_of_arenas * (size_t)SSA_ARENA_SIZE);
     }
 
-    printf("number of frees chunks = %zu\n", ms_p->nr_of_free_chunks);
+    arenas_memory_p = (uint8_t*)region_p;
+    nr_of_arenas = new_nr_of_arenas;
 
-    if (ms_p->nr_of_free_chunks > 0)
+    for (size_t i = 0; i < nr_of_arenas; ++i)
     {
-        double size_of_med = 0;
+        (void)pthread_mutex_init(&arenas[i].lock, NULL);
+        arenas[i].remote_frees = NULL;
 
-        printf("sizes: ");
+        /* arena does not grow, pages of its range are committed by kernel on first touch */
+        __heap_init(&arenas[i].heap, arenas_memory_p + i * SSA_ARENA_SIZE, SSA_ARENA_SIZE, SSA_ARENA_SIZE);
+    }
 
-        for (size_t i = 0; i < ms_p->nr_of_free_chunks; ++i)
-        {
-            size_of_med += (double)ms_p->size_of_free_chunks_p[i];
+    return true;
+}
 
-            printf("%zu ", ms_p->size_of_free_chunks_p[i]);
-        }
+void* ssa_arenas_alloc(const size_t bytes)
+{
+    Ssa_arena* const arena_p = __arena_get();
+
+    (void)pthread_mutex_lock(&arena_p->lock);
+    __remote_free_drain(arena_p);
+    void* const addr_p = __heap_alloc(&arena_p->heap, bytes);
+    (void)pthread_mutex_unlock(&arena_p->lock);
+
+    return addr_p;
+}
+
+void* ssa_arenas_calloc(const size_t nr_of_members, const size_t size)
+{
+    size_t bytes;
+
+    if (__builtin_mul_overflow(nr_of_members, size, &bytes))
+    {
+        Ssa_arena* const arena_p = __arena_get();
 
-        size_of_med /= (double)ms_p->nr_of_free_chunks;
-        
-        printf("\nsize_of medium = %lf\n", size_of_med);
+        (void)pthread_mutex_lock(&arena_p->lock);
+        ++arena_p->heap.statistics.nr_of_failures;
+        (void)pthread_mutex_unlock(&arena_p->lock);
+
+        return NULL;
+    }
+
+    void* const addr_p = ssa_arenas_alloc(bytes);
+
+    /* chunk belongs to caller now, so it is zeroed without lock */
+    if (addr_p != NULL)
+    {
+        __chunk_zero(addr_p, bytes);
+    }
+
+    return addr_p;
+}
+
+void* ssa_arenas_alloc_aligned(const size_t bytes, const size_t alignment)
+{
+    Ssa_arena* const arena_p = __arena_get();
+
+    (void)pthread_mutex_lock(&arena_p->lock);
+    __remote_free_drain(arena_p);
+    void* const addr_p = __heap_alloc_aligned(&arena_p->heap, bytes, alignment);
+    (void)pthread_mutex_unlock(&arena_p->lock);
+
+    return addr_p;
+}
+
+void ssa_arenas_dealloc(void* addr_p)
+{
+    if (addr_p == NULL)
+    {
+        return;
     }
 
-    if (ms_p->nr_of_allocated_chunks > 0)
+    Ssa_arena* const arena_p = __arena_find(addr_p);
+
+    if (arena_p == NULL)
     {
-        free(ms_p->size_of_allocated_chunks_p);
+        return;
     }
 
-    if (ms_p->nr_of_free_chunks > 0)
+    /* chunk of other arena is not freed here, so thread does not wait for lock of owner nor touch its free lists */
+    if (arena_p != __arena_get())
     {
-        free(ms_p->size_of_free_chunks_p);
+        __remote_free_push(arena_p, addr_p);
+        return;
     }
 
-    free((void*)ms_p);
+    (void)pthread_mutex_lock(&arena_p->lock);
+    __heap_dealloc(&arena_p->heap, addr_p);
+    (void)pthread_mutex_unlock(&arena_p->lock);
 }
 
-size_t ssa_get_size_of_memory(void)
+void* ssa_arenas_realloc(void* addr_p, const size_t bytes)
 {
-    return ARRAY_SIZE(memory);
+    if (addr_p == NULL)
+    {
+        return ssa_arenas_alloc(bytes);
+    }
+
+    Ssa_arena* const arena_p = __arena_find(addr_p);
+
+    if (arena_p == NULL)
+    {
+        return NULL;
+    }
+
+    /* chunk is resized in arena which owns it, so it can grow in place */
+    (void)pthread_mutex_lock(&arena_p->lock);
+    __remote_free_drain(arena_p);
+    void* const new_addr_p = __heap_realloc(&arena_p->heap, addr_p, bytes);
+    (void)pthread_mutex_unlock(&arena_p->lock);
+
+    return new_addr_p;
 }
 
-void* ssa_get_address_from_memory(const size_t index)
+void ssa_arenas_read_statistics(Ssa_statistics* stats_p)
 {
-    return (void*)&memory[index];
+    if (stats_p == NULL)
+    {
+        return;
+    }
+
+    (void)memset(stats_p, 0, sizeof(*stats_p));
+
+    for (size_t i = 0; i < nr_of_arenas; ++i)
+    {
+        Ssa_statistics stats;
+
+        (void)pthread_mutex_lock(&arenas[i].lock);
+        __remote_free_drain(&arenas[i]);
+        __heap_read_statistics(&arenas[i].heap, &stats);
+        (void)pthread_mutex_unlock(&arenas[i].lock);
+
+        stats_p->size_of_heap += stats.size_of_heap;
+        stats_p->nr_of_segments += stats.nr_of_segments;
+        stats_p->nr_of_mapped_chunks += stats.nr_of_mapped_chunks;
+        stats_p->nr_of_chunks_in_use += stats.nr_of_chunks_in_use;
+        stats_p->bytes_in_use += stats.bytes_in_use;
+        stats_p->peak_bytes_in_use += stats.peak_bytes_in_use;
+        stats_p->nr_of_free_chunks += stats.nr_of_free_chunks;
+        stats_p->nr_of_allocs += stats.nr_of_allocs;
+        stats_p->nr_of_frees += stats.nr_of_frees;
+        stats_p->nr_of_remote_frees += stats.nr_of_remote_frees;
+        stats_p->nr_of_failures += stats.nr_of_failures;
+
+        if (stats.size_of_largest_free_chunk > stats_p->size_of_largest_free_chunk)
+        {
+            stats_p->size_of_largest_free_chunk = stats.size_of_largest_free_chunk;
+        }
+    }
+}
+
+void ssa_arenas_read_fragmentation(Ssa_fragmentation* frag_p)
+{
+    if (frag_p == NULL)
+    {
+        return;
+    }
+
+    (void)memset(frag_p, 0, sizeof(*frag_p));
+
+    for (size_t i = 0; i < nr_of_arenas; ++i)
+    {
+        Ssa_fragmentation frag;
+
+        (void)pthread_mutex_lock(&arenas[i].lock);
+        __remote_free_drain(&arenas[i]);
+        __heap_read_fragmentation(&arenas[i].heap, &frag);
+        (void)pthread_mutex_unlock(&arenas[i].lock);
+
+        for (size_t j = 0; j < SSA_FRAGMENTATION_NR_OF_BUCKETS; ++j)
+        {
+            frag_p->free_extents[j] += frag.free_extents[j];
+        }
+
+        frag_p->nr_of_free_extents += frag.nr_of_free_extents;
+        frag_p->free_bytes += frag.free_bytes;
+        frag_p->requested_bytes += frag.requested_bytes;
+        frag_p->allocated_bytes += frag.allocated_bytes;
+
+        if (frag.size_of_largest_free_extent > frag_p->size_of_largest_free_extent)
+        {
+            frag_p->size_of_largest_free_extent = frag.size_of_largest_free_extent;
+        }
+    }
+
+    __fragmentation_set_ratios(frag_p);
 }
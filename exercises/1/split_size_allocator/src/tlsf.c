@@ -0,0 +1,384 @@
+#include <tlsf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* sizes of chunks are multiple of 4, so headers are always aligned */
+#define ALIGN_LOG2 2
+#define ALIGN_SIZE (1 << ALIGN_LOG2)
+
+/* tail of memory which is not multiple of ALIGN_SIZE is never used, the last chunk ends at USABLE_SIZE */
+#define USABLE_SIZE ((size_t)TLSF_MEMORY_SIZE & ~(size_t)(ALIGN_SIZE - 1))
+
+/* number of second level lists in each first level */
+#define SL_COUNT (1 << TLSF_SL_LOG2)
+
+/* chunks smaller than SMALL_CHUNK_SIZE are in first level 0, split linearly by ALIGN_SIZE */
+#define FL_SHIFT (TLSF_SL_LOG2 + ALIGN_LOG2)
+#define SMALL_CHUNK_SIZE (1 << FL_SHIFT)
+
+/* size_of has got 30 bits in header, so the biggest first level keeps chunks from 2^29 */
+#define FL_COUNT (30 - FL_SHIFT + 1)
+
+/* end of free list */
+#define NO_CHUNK UINT32_MAX
+
+/* free chunk keeps links to neighbours on free list after header and its size in footer, so it can not be smaller */
+#define MIN_CHUNK_SIZE (sizeof(Free_chunk_header) + sizeof(uint32_t))
+
+/* size_of has got 30 bits in header */
+#define SIZE_MASK (((uint32_t)1 << 30) - 1)
+
+#if TLSF_MEMORY_SIZE > ((1 << 30) - 1)
+#error "TLSF_MEMORY_SIZE does not fit in size_of of chunk header"
+#endif
+
+#if TLSF_SL_LOG2 > 5
+#error "TLSF_SL_LOG2 bigger than 5 does not fit in 32-bit second level bitmap"
+#endif
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/* free chunk has got copy of size_of in the last 4 bytes (footer), so next chunk can find its header */
+struct Chunk_header
+{
+    uint32_t is_allocated : 1;
+    uint32_t is_prev_allocated : 1;
+    uint32_t size_of : 30;
+};
+
+typedef struct Chunk_header Chunk_header;
+
+struct Free_chunk_header
+{
+    Chunk_header header;
+
+    /* offsets of neighbours on free list */
+    uint32_t next;
+    uint32_t prev;
+};
+
+typedef struct Free_chunk_header Free_chunk_header;
+
+/* --------------------------------------------- STATIC VARIABLES -------------------------------------------------- */
+
+/* memory for allocations */
+static uint8_t memory[TLSF_MEMORY_SIZE] __attribute__((aligned(ALIGN_SIZE)));
+
+/* offsets of the first free chunk in each list */
+static uint32_t lists[FL_COUNT][SL_COUNT];
+
+/* bit n is set if first level n has got not empty list */
+static uint32_t fl_bitmap;
+
+/* bit n of word m is set if list [m][n] is not empty */
+static uint32_t sl_bitmaps[FL_COUNT];
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+    This function compute first and second level of list for chunk of given size.
+
+    PARAMS:
+    @IN size_of - size of chunk.
+    @OUT fl_p - first level.
+    @OUT sl_p - second level.
+
+    RETURN:
+    This is void function.
+*/
+static inline void __mapping(const size_t size_of, size_t* const fl_p, size_t* const sl_p);
+
+/*
+    This function add free chunk to the head of its list.
+
+    PARAMS:
+    @IN offset - offset of chunk in memory.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_list_push(const size_t offset);
+
+/*
+    This function remove free chunk from its list.
+
+    PARAMS:
+    @IN offset - offset of chunk in memory.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_list_remove(const size_t offset);
+
+/*
+    This function find free chunk with at least @req_memory bytes by two bit scans.
+
+    PARAMS:
+    @IN req_memory - requested size of chunk.
+
+    RETURN:
+    @NO_CHUNK if there is no such chunk.
+    @offset of chunk if success.
+*/
+static size_t __free_list_find(const size_t req_memory);
+
+/*
+    This function write header and footer of free chunk and tell next chunk that previous one is free.
+
+    PARAMS:
+    @IN offset - offset of chunk in memory.
+    @IN size_of - size of chunk.
+
+    RETURN:
+    This is void function.
+*/
+static void __free_chunk_set(const size_t offset, const size_t size_of);
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline void __mapping(const size_t size_of, size_t* const fl_p, size_t* const sl_p)
+{
+    if (size_of < SMALL_CHUNK_SIZE)
+    {
+        *fl_p = 0;
+        *sl_p = size_of >> ALIGN_LOG2;
+    }
+    else
+    {
+        const size_t fls = (size_t)(31 - __builtin_clz((uint32_t)size_of));
+
+        *fl_p = fls - FL_SHIFT + 1;
+        *sl_p = (size_of >> (fls - TLSF_SL_LOG2)) ^ SL_COUNT;
+    }
+}
+
+static void __free_list_push(const size_t offset)
+{
+    Free_chunk_header* const chunk_p = (Free_chunk_header*)&memory[offset];
+    size_t fl;
+    size_t sl;
+
+    __mapping(chunk_p->header.size_of, &fl, &sl);
+
+    chunk_p->prev = NO_CHUNK;
+    chunk_p->next = lists[fl][sl];
+
+    if (lists[fl][sl] != NO_CHUNK)
+    {
+        ((Free_chunk_header*)&memory[lists[fl][sl]])->prev = (uint32_t)offset;
+    }
+
+    lists[fl][sl] = (uint32_t)offset;
+    fl_bitmap |= (uint32_t)1 << fl;
+    sl_bitmaps[fl] |= (uint32_t)1 << sl;
+}
+
+static void __free_list_remove(const size_t offset)
+{
+    Free_chunk_header* const chunk_p = (Free_chunk_header*)&memory[offset];
+    size_t fl;
+    size_t sl;
+
+    __mapping(chunk_p->header.size_of, &fl, &sl);
+
+    if (chunk_p->prev != NO_CHUNK)
+    {
+        ((Free_chunk_header*)&memory[chunk_p->prev])->next = chunk_p->next;
+    }
+    else
+    {
+        lists[fl][sl] = chunk_p->next;
+    }
+
+    if (chunk_p->next != NO_CHUNK)
+    {
+        ((Free_chunk_header*)&memory[chunk_p->next])->prev = chunk_p->prev;
+    }
+
+    if (lists[fl][sl] == NO_CHUNK)
+    {
+        sl_bitmaps[fl] &= ~((uint32_t)1 << sl);
+
+        if (sl_bitmaps[fl] == 0)
+        {
+            fl_bitmap &= ~((uint32_t)1 << fl);
+        }
+    }
+}
+
+static size_t __free_list_find(const size_t req_memory)
+{
+    size_t search_size = req_memory;
+
+    /* round up to the next list, then every chunk in found list is big enough */
+    if (search_size >= SMALL_CHUNK_SIZE)
+    {
+        search_size += ((size_t)1 << (31 - __builtin_clz((uint32_t)search_size) - TLSF_SL_LOG2)) - 1;
+    }
+
+    size_t fl;
+    size_t sl;
+
+    __mapping(search_size, &fl, &sl);
+
+    if (fl >= FL_COUNT)
+    {
+        return NO_CHUNK;
+    }
+
+    uint32_t sl_map = sl_bitmaps[fl] & (UINT32_MAX << sl);
+
+    if (sl_map == 0)
+    {
+        const uint32_t fl_map = fl + 1 < FL_COUNT ? fl_bitmap & (UINT32_MAX << (fl + 1)) : 0;
+
+        if (fl_map == 0)
+        {
+            return NO_CHUNK;
+        }
+
+        fl = (size_t)__builtin_ctz(fl_map);
+        sl_map = sl_bitmaps[fl];
+    }
+
+    return lists[fl][__builtin_ctz(sl_map)];
+}
+
+static void __free_chunk_set(const size_t offset, const size_t size_of)
+{
+    Chunk_header* const header_p = (Chunk_header*)&memory[offset];
+    const uint32_t footer = (uint32_t)size_of & SIZE_MASK;
+
+    header_p->is_allocated = false;
+    header_p->size_of = (uint32_t)size_of & SIZE_MASK;
+
+    (void)memcpy(&memory[offset + size_of - sizeof(footer)], &footer, sizeof(footer));
+
+    if (offset + size_of < USABLE_SIZE)
+    {
+        ((Chunk_header*)&memory[offset + size_of])->is_prev_allocated = false;
+    }
+}
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+void tlsf_init(void)
+{
+    /* only header of the first chunk is written, memory is not zeroed */
+    for (size_t i = 0; i < FL_COUNT; ++i)
+    {
+        for (size_t j = 0; j < SL_COUNT; ++j)
+        {
+            lists[i][j] = NO_CHUNK;
+        }
+
+        sl_bitmaps[i] = 0;
+    }
+
+    fl_bitmap = 0;
+
+    /* there is no chunk before the first one, so it can not be merged with anything */
+    ((Chunk_header*)&memory[0])->is_prev_allocated = true;
+
+    __free_chunk_set(0, USABLE_SIZE);
+    __free_list_push(0);
+}
+
+void* tlsf_alloc(const size_t bytes)
+{
+    if (bytes == 0 || bytes > (USABLE_SIZE - sizeof(Chunk_header)))
+    {
+        return NULL;
+    }
+
+    const size_t aligned = (bytes + sizeof(Chunk_header) + ALIGN_SIZE - 1) & ~(size_t)(ALIGN_SIZE - 1);
+    const size_t req_memory = aligned < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : aligned;
+    const size_t offset = __free_list_find(req_memory);
+
+    if (offset == NO_CHUNK)
+    {
+        return NULL;
+    }
+
+    __free_list_remove(offset);
+
+    Chunk_header* const header_p = (Chunk_header*)&memory[offset];
+    const size_t old_size_of = header_p->size_of;
+
+    header_p->is_allocated = true;
+
+    /* rest of chunk is split off only if it can be free chunk */
+    if (old_size_of - req_memory >= MIN_CHUNK_SIZE)
+    {
+        header_p->size_of = (uint32_t)req_memory & SIZE_MASK;
+
+        ((Chunk_header*)&memory[offset + req_memory])->is_prev_allocated = true;
+
+        __free_chunk_set(offset + req_memory, old_size_of - req_memory);
+        __free_list_push(offset + req_memory);
+    }
+    else if (offset + old_size_of < USABLE_SIZE)
+    {
+        ((Chunk_header*)&memory[offset + old_size_of])->is_prev_allocated = true;
+    }
+
+    return (void*)&memory[offset + sizeof(Chunk_header)];
+}
+
+void tlsf_dealloc(void* addr_p)
+{
+    if (addr_p == NULL)
+    {
+        return;
+    }
+
+    const Chunk_header* const freed_header_p = (const Chunk_header*)((uint8_t*)addr_p - sizeof(Chunk_header));
+
+    size_t offset = (size_t)((const uint8_t*)freed_header_p - &memory[0]);
+    size_t size_of = freed_header_p->size_of;
+
+    /* merge with next chunk */
+    if (offset + size_of < USABLE_SIZE)
+    {
+        const Chunk_header* const next_header_p = (const Chunk_header*)&memory[offset + size_of];
+
+        if (next_header_p->is_allocated == false)
+        {
+            __free_list_remove(offset + size_of);
+            size_of += next_header_p->size_of;
+        }
+    }
+
+    /* merge with previous chunk, its size is kept in footer */
+    if (freed_header_p->is_prev_allocated == false)
+    {
+        uint32_t prev_size_of;
+        (void)memcpy(&prev_size_of, &memory[offset - sizeof(prev_size_of)], sizeof(prev_size_of));
+
+        offset -= prev_size_of;
+        size_of += prev_size_of;
+
+        __free_list_remove(offset);
+    }
+
+    __free_chunk_set(offset, size_of);
+    __free_list_push(offset);
+}
+
+size_t tlsf_get_size_of_memory(void)
+{
+    return ARRAY_SIZE(memory);
+}
+
+void* tlsf_get_address_from_memory(const size_t index)
+{
+    return (void*)&memory[index];
+}
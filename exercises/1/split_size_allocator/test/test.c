@@ -1,8 +1,12 @@
 #include <split_size_allocator.h>
+#include <tlsf.h>
+#include <benchmark.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
 
 /* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
 
@@ -12,125 +16,1651 @@
 /* ------------------------------------------------- STRUCTURES ---------------------------------------------------- */
 
 struct Test_chunk_header
+{
+    uint64_t is_allocated : 1;
+    uint64_t is_prev_allocated : 1;
+    uint64_t is_mmapped : 1;
+    uint64_t size_of : 61;
+};
+
+typedef struct Test_chunk_header Test_chunk_header;
+
+struct Test_free_chunk_header
+{
+    Test_chunk_header header;
+
+    void* next;
+    void* prev;
+};
+
+typedef struct Test_free_chunk_header Test_free_chunk_header;
+
+/* 4-byte header of tlsf and of first fit used as reference in benchmarks */
+struct Test_small_chunk_header
 {
     uint32_t is_allocated : 1;
-    uint32_t size_of : 31;
+    uint32_t is_prev_allocated : 1;
+    uint32_t size_of : 30;
+};
+
+typedef struct Test_small_chunk_header Test_small_chunk_header;
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* the smallest chunk has to keep free list links and footer */
+#define TEST_MIN_CHUNK_SIZE (sizeof(Test_free_chunk_header) + sizeof(uint64_t))
+
+/* the smallest tlsf chunk keeps 4-byte header, free list links and footer */
+#define TEST_SMALL_MIN_CHUNK_SIZE 16
+
+/* size_of has got 30 bits in 4-byte header */
+#define TEST_SIZE_MASK (((uint32_t)1 << 30) - 1)
+
+/* the first chunk starts so that address after its header is aligned to SSA_ALIGNMENT */
+#define TEST_FIRST_CHUNK_OFFSET (SSA_ALIGNMENT - sizeof(Test_chunk_header))
+
+/* size of chunk which keeps all memory after init, fence lies after it */
+#define TEST_HEAP_SIZE \
+    ((MEMORY_SIZE - TEST_FIRST_CHUNK_OFFSET - sizeof(Test_chunk_header)) & ~(size_t)(SSA_ALIGNMENT - 1))
+
+/* size of chunk given by ssa_alloc for @bytes */
+#define TEST_CHUNK_SIZE(bytes) \
+    ((((bytes) + sizeof(Test_chunk_header) + SSA_ALIGNMENT - 1) & ~(size_t)(SSA_ALIGNMENT - 1)) < TEST_MIN_CHUNK_SIZE \
+         ? TEST_MIN_CHUNK_SIZE \
+         : (((bytes) + sizeof(Test_chunk_header) + SSA_ALIGNMENT - 1) & ~(size_t)(SSA_ALIGNMENT - 1)))
+
+/* number of chunks which fragment heap in benchmark */
+#define NR_OF_FRAGMENTS 4096
+
+/* number of allocations measured in benchmark */
+#define NR_OF_MEASURED_ALLOCATIONS 1000
+
+/* number of appends to buffer in realloc benchmark, each adds APPEND_SIZE bytes */
+#define NR_OF_APPENDS 2048
+#define APPEND_SIZE 64
+
+/* number of chunks kept allocated at once in latency benchmark */
+#define NR_OF_LIVE_CHUNKS 256
+
+/* number of allocations timed one by one in latency benchmark */
+#define NR_OF_LATENCY_SAMPLES 20000
+
+/* number of threads in arenas tests and benchmark */
+#define NR_OF_THREADS 8
+
+/* number of chunks allocated by each thread in arenas stress test */
+#define NR_OF_THREAD_CHUNKS 2000
+
+/* number of alloc and free pairs done by each thread in arenas benchmark */
+#define NR_OF_THREAD_ITERATIONS 200000
+
+/* number of buffers passed from producer to consumer in pipeline benchmark and size of ring between them */
+#define NR_OF_PIPELINE_BUFFERS 200000
+#define PIPELINE_RING_SIZE 256
+
+/* ---------------------------------------------- STATIC VARIABLES ------------------------------------------------- */
+
+/* memory for first fit allocator used as reference in benchmark */
+static uint8_t reference_memory[MEMORY_SIZE];
+
+/* chunks allocated by each thread in arenas stress test, they are freed by next thread */
+static uint8_t* thread_chunks[NR_OF_THREADS][NR_OF_THREAD_CHUNKS];
+
+/*
+    Single producer single consumer ring between two threads of pipeline benchmark, producer of pair n is thread 2n
+    and consumer is thread 2n + 1.
+*/
+struct Pipeline_ring
+{
+    uint8_t* buffers[PIPELINE_RING_SIZE];
+    size_t head __attribute__((aligned(64))); /* written by producer */
+    size_t tail __attribute__((aligned(64))); /* written by consumer */
 };
 
-typedef struct Test_chunk_header Test_chunk_header;
+typedef struct Pipeline_ring Pipeline_ring;
+
+static Pipeline_ring pipeline_rings[NR_OF_THREADS / 2];
+
+/* ------------------------------------------- FUNCTION DECLARATION ------------------------------------------------ */
+
+/*
+    In this test case we want to allocate lot of memory chunks. After allocations we will go through available memory
+    chunk to ensure they are properly allocated in memory.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_allocations(void);
+
+/*
+    In this test case we want to allocate lot of memory chunks and then deallocates all memory chunks. We expect that
+    one memory chunk left as a not allocated, as after init memory.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_deallocations(void);
+
+/*
+    In this test case we want to check that statistics follow allocations and deallocations.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_statistics(void);
+
+/*
+    In this test case we want to make sure that fragmentation report keeps histogram of free chunks by bins, finds
+    the largest one and counts internal waste of headers and alignment.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_fragmentation(void);
+
+/*
+    In this test case we want to make sure that free chunks are found in bins and chunks too small to be split are
+    given whole.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_segregated_fit(void);
+
+/*
+    In this test case we want to make sure that freed chunk is merged with free neighbours on both sides at once.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_coalescing(void);
+
+/*
+    In this test case we want to make sure that ssa_alloc_aligned returns aligned addresses and padding in front of
+    chunk goes back to free lists.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_aligned_allocations(void);
+
+/*
+    In this test case we want to make sure that ssa_realloc shrinks and grows chunk in place if it is possible and
+    moves data only if the next chunk is not free.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_realloc(void);
+
+/*
+    In this test case we want to make sure that ssa_init does not zero memory and ssa_calloc zeroes only what it
+    returns.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_calloc_and_reset(void);
+
+/*
+    In this test case we want to make sure that chunks bigger than SSA_MMAP_THRESHOLD get own mappings, they do not take
+    heap, and mapped chunk is grown by mremap or moved back to heap when it is small.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_mmap_threshold(void);
+
+#if SSA_MAX_HEAP_SIZE > MEMORY_SIZE
+
+/*
+    In this test case we want to make sure that heap grows by mapped segments when static memory is full and chunks
+    bigger than static memory (and bigger than 4 GB if heap can be so big) can be allocated.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_heap_growth(void);
+
+#endif
+
+/*
+    Grow buffer by ssa_realloc.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __append_by_realloc(void);
+
+/*
+    Grow buffer by ssa_alloc, copy and ssa_dealloc, how it was done without realloc.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __append_by_copy(void);
+
+/*
+    Benchmark of growing buffer, ssa_realloc against alloc + copy + free.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_realloc(void);
+
+/*
+    First fit allocation by walk through all chunks, it is how ssa_alloc worked before segregated free lists.
+
+    PARAMS:
+    @IN bytes - requested memory size in bytes.
+
+    RETURN:
+    @NULL if failure.
+    @address if success.
+*/
+static void* __reference_alloc(const size_t bytes);
+
+/*
+    Fill heap with NR_OF_FRAGMENTS small chunks and free every second one, so heap is fragmented.
+
+    PARAMS:
+    @IN alloc - allocation function.
+    @IN dealloc - deallocation function, NULL for reference allocator.
+
+    RETURN:
+    This is void function.
+*/
+static void __fragment_heap(void* (*alloc)(const size_t), void (*dealloc)(void*));
+
+/*
+    Allocate NR_OF_MEASURED_ALLOCATIONS chunks which do not fit in holes of fragmented heap.
+
+    PARAMS:
+    @IN alloc - allocation function.
+
+    RETURN:
+    This is void function.
+*/
+static void __allocate_after_fragments(void* (*alloc)(const size_t));
+
+/*
+    Deallocate chunks left allocated by __fragment_heap, each of them is merged with both neighbours.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void __deallocate_fragments(void);
+
+/*
+    Benchmark of allocations from fragmented heap, segregated free lists against linear first fit walk.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_fragmented_heap(void);
+
+/*
+    In this test case we want to make sure that tlsf gives chunks of rounded size and takes them back.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_tlsf_allocations(void);
+
+/*
+    In this test case we want to make sure that tlsf finds freed chunk in its list and merges neighbours at once.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_tlsf_coalescing(void);
+
+/*
+    Walk through all chunks and merge free neighbours, it is how ssa_dealloc worked before boundary tags.
+
+    PARAMS:
+    @IN addr_p - pointer to memory for freeing.
+
+    RETURN:
+    This is void function.
+*/
+static void __reference_dealloc(void* addr_p);
+
+/*
+    Compare function for qsort of latency samples.
+
+    PARAMS:
+    @IN a_p - pointer to the first sample.
+    @IN b_p - pointer to the second sample.
+
+    RETURN:
+    Negative, zero or positive like in strcmp.
+*/
+static int __compare_samples(const void* a_p, const void* b_p);
+
+/*
+    Run random workload of allocs and deallocs with NR_OF_LIVE_CHUNKS chunks alive, time each alloc and print
+    percentiles of latency. The same seed is used for each allocator, so they get the same requests.
+
+    PARAMS:
+    @IN alloc - allocation function.
+    @IN dealloc - deallocation function.
+    @IN label - name of allocator.
+
+    RETURN:
+    This is void function.
+*/
+static void __measure_latency(void* (*alloc)(const size_t), void (*dealloc)(void*), const char* label);
+
+/*
+    Benchmark of worst case alloc latency, tlsf against segregated free lists and linear first fit.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_latency(void);
+
+/*
+    This function run @routine in NR_OF_THREADS threads, each of them gets its index as argument.
+
+    PARAMS:
+    @IN routine - thread routine.
+
+    RETURN:
+    This is void function.
+*/
+static void __run_threads(void* (*routine)(void*));
+
+/*
+    In this test case we want to check that chunk freed or resized by other thread goes back to arena which allocated
+    it, also chunk with own mapping.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_arenas_routing(void);
+
+/*
+    In this test case threads allocate chunks of random sizes in their arenas and each of them frees chunks of other
+    thread. In the end every arena has to be one free chunk again.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_arenas_threads_stress(void);
+
+/*
+    Benchmark of alloc and free in NR_OF_THREADS threads, arena per thread against one arena (one global lock).
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_arenas(void);
+
+/*
+    Benchmark of producer and consumer pairs: buffers allocated by producer are freed by consumer. With arena per
+    thread consumer pushes them on remote free queue of producer arena, with one arena both of them take its lock.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_pipeline(void);
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+static void test_allocations(void)
+{
+    ssa_init();
+
+    const size_t size_of_data[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+    void* address[ARRAY_SIZE(size_of_data)] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        address[i] = ssa_alloc(size_of_data[i]);
+        assert(address[i] != NULL);
+    }
+
+    size_t offset = TEST_FIRST_CHUNK_OFFSET;
+    Test_chunk_header* header_p = (Test_chunk_header*)ssa_get_address_from_memory(offset);
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        assert(header_p->is_allocated == true);
+        assert(header_p->size_of == TEST_CHUNK_SIZE(size_of_data[i]));
+        assert(((uintptr_t)address[i] & (SSA_ALIGNMENT - 1)) == 0);
+
+        offset += header_p->size_of;
+        header_p = (Test_chunk_header*)ssa_get_address_from_memory(offset);
+    }
+}
+
+static void test_deallocations(void)
+{
+    ssa_init();
+
+    /* after lots of alloc -> dealloce we expect that we've got one chunk with size_of equals TEST_HEAP_SIZE */
+    const size_t offset = TEST_FIRST_CHUNK_OFFSET;
+    const Test_chunk_header* const header_p = (Test_chunk_header*)ssa_get_address_from_memory(offset);
+
+    /* allocate memory chunks in increasing order and then deallocate memory chunk in increasing order */
+    const size_t size_of_data[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+    void* address[ARRAY_SIZE(size_of_data)] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        address[i] = ssa_alloc(size_of_data[i]);
+        assert(address[i] != NULL);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        ssa_dealloc(address[i]);
+    }
+
+    assert(header_p->is_allocated == false);
+    assert(header_p->size_of == TEST_HEAP_SIZE);
+
+    /* allocate memory chunks in increasing order and then deallocate memory chunk in decreasing order */
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        address[i] = ssa_alloc(size_of_data[i]);
+        assert(address[i] != NULL);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        ssa_dealloc(address[ARRAY_SIZE(size_of_data) - i - 1]);
+    }
+
+    assert(header_p->is_allocated == false);
+    assert(header_p->size_of == TEST_HEAP_SIZE);
+
+    /* allocate memory chunks in increasing order and then deallocate memory chunk in given order */
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        address[i] = ssa_alloc(size_of_data[i]);
+        assert(address[i] != NULL);
+    }
+
+    const size_t index_to_dealloc[] = {0, 2, 4, 6, 8, 10, 9, 7, 5, 3, 1};
+    assert(sizeof(index_to_dealloc) == sizeof(size_of_data));
+
+    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    {
+        ssa_dealloc(address[index_to_dealloc[i]]);
+    }
+
+    assert(header_p->is_allocated == false);
+    assert(header_p->size_of == TEST_HEAP_SIZE);
+}
+
+static void test_statistics(void)
+{
+    ssa_init();
+
+    Ssa_statistics stats;
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.bytes_in_use == 0);
+    assert(stats.nr_of_free_chunks == 1 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE);
+
+    void* const first_p = ssa_alloc(100);
+    void* const second_p = ssa_alloc(200);
+    void* const third_p = ssa_alloc(300);
+    assert(first_p != NULL && second_p != NULL && third_p != NULL);
+
+    const size_t size_of_used = TEST_CHUNK_SIZE(100) + TEST_CHUNK_SIZE(200) + TEST_CHUNK_SIZE(300);
+
+    /* the largest free chunk was split, it has to be found again */
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 3 && stats.bytes_in_use == size_of_used);
+    assert(stats.peak_bytes_in_use == size_of_used);
+    assert(stats.nr_of_free_chunks == 1 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE - size_of_used);
+
+    ssa_dealloc(second_p);
+    assert(ssa_alloc((size_t)1 << 61) == NULL);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 2 && stats.bytes_in_use == TEST_CHUNK_SIZE(100) + TEST_CHUNK_SIZE(300));
+    assert(stats.peak_bytes_in_use == size_of_used);
+    assert(stats.nr_of_free_chunks == 2 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE - size_of_used);
+    assert(stats.nr_of_allocs == 3 && stats.nr_of_frees == 1 && stats.nr_of_failures == 1);
+
+    ssa_dealloc(first_p);
+    ssa_dealloc(third_p);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.bytes_in_use == 0 && stats.nr_of_frees == 3);
+    assert(stats.nr_of_free_chunks == 1 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE);
+}
+
+static void test_fragmentation(void)
+{
+    ssa_init();
+
+    const size_t heap_bucket = (size_t)(63 - __builtin_clzll(TEST_HEAP_SIZE));
+    Ssa_fragmentation frag;
+
+    ssa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 1 && frag.free_extents[heap_bucket] == 1);
+    assert(frag.free_bytes == TEST_HEAP_SIZE && frag.size_of_largest_free_extent == TEST_HEAP_SIZE);
+    assert(frag.external_fragmentation == 0.0);
+    assert(frag.requested_bytes == 0 && frag.allocated_bytes == 0 && frag.internal_waste == 0.0);
+
+    void* address[5] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = ssa_alloc(100);
+        assert(address[i] != NULL);
+    }
+
+    /* freed chunks have allocated neighbours, so they are not merged */
+    ssa_dealloc(address[1]);
+    ssa_dealloc(address[3]);
+
+    const size_t chunk_bucket = (size_t)(63 - __builtin_clzll(TEST_CHUNK_SIZE(100)));
+    const size_t largest = TEST_HEAP_SIZE - ARRAY_SIZE(address) * TEST_CHUNK_SIZE(100);
+    const size_t free_bytes = largest + 2 * TEST_CHUNK_SIZE(100);
+
+    ssa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 3 && frag.free_extents[chunk_bucket] == 2);
+    assert(frag.free_bytes == free_bytes && frag.size_of_largest_free_extent == largest);
+    assert(frag.external_fragmentation == 1.0 - (double)largest / (double)free_bytes);
+
+    /* waste is counted since init, frees do not change it */
+    const size_t allocated_bytes = ARRAY_SIZE(address) * TEST_CHUNK_SIZE(100);
+
+    assert(frag.requested_bytes == 500 && frag.allocated_bytes == allocated_bytes);
+    assert(frag.internal_waste == 1.0 - 500.0 / (double)allocated_bytes);
+
+    /* the last freed chunk is the first one in its bin, 90 and 100 bytes are rounded to the same chunk */
+    void* const small_p = ssa_alloc(90);
+    assert(small_p == address[3]);
+
+    ssa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 2 && frag.free_extents[chunk_bucket] == 1);
+    assert(frag.requested_bytes == 590 && frag.allocated_bytes == allocated_bytes + TEST_CHUNK_SIZE(100));
+
+    ssa_dealloc(small_p);
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        if (i != 1 && i != 3)
+        {
+            ssa_dealloc(address[i]);
+        }
+    }
+
+    ssa_read_fragmentation(&frag);
+    assert(frag.nr_of_free_extents == 1 && frag.free_bytes == TEST_HEAP_SIZE && frag.external_fragmentation == 0.0);
+
+    /* reset clears counters */
+    ssa_init();
+
+    ssa_read_fragmentation(&frag);
+    assert(frag.requested_bytes == 0 && frag.allocated_bytes == 0 && frag.free_extents[heap_bucket] == 1);
+}
+
+static void test_segregated_fit(void)
+{
+    ssa_init();
+
+    uint8_t* const first_p = (uint8_t*)ssa_alloc(100);
+    uint8_t* const spacer_p = (uint8_t*)ssa_alloc(100);
+    uint8_t* const second_p = (uint8_t*)ssa_alloc(1000);
+    uint8_t* const third_p = (uint8_t*)ssa_alloc(100);
+    assert(first_p != NULL && spacer_p != NULL && second_p != NULL && third_p != NULL);
+
+    ssa_dealloc(first_p);
+    ssa_dealloc(second_p);
+
+    /* the smallest bin which is big enough wins, not the first chunk in memory */
+    assert(ssa_alloc(500) == second_p);
+
+    /* rest of second chunk is a free chunk now */
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 3);
+
+    /* request rounded up to SSA_ALIGNMENT takes the whole chunk, nothing is split off */
+    assert(ssa_alloc(TEST_CHUNK_SIZE(100) - sizeof(Test_chunk_header) - SSA_ALIGNMENT + 1) == first_p);
+
+    const Test_chunk_header* const header_p = (const Test_chunk_header*)(first_p - sizeof(Test_chunk_header));
+    assert(header_p->size_of == TEST_CHUNK_SIZE(100));
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 2);
+
+    ssa_dealloc(first_p);
+    ssa_dealloc(second_p);
+    ssa_dealloc(third_p);
+    ssa_dealloc(spacer_p);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 1 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE);
+}
+
+static void* __reference_alloc(const size_t bytes)
+{
+    Test_small_chunk_header* header_p = NULL;
+    const size_t req_memory = bytes + sizeof(*header_p);
+
+    for (size_t offset = 0; offset < MEMORY_SIZE; offset += header_p->size_of)
+    {
+        header_p = (Test_small_chunk_header*)&reference_memory[offset];
+
+        if (header_p->is_allocated == false && header_p->size_of > req_memory)
+        {
+            const size_t old_size_of = header_p->size_of;
+
+            header_p->is_allocated = true;
+            header_p->size_of = (uint32_t)req_memory & TEST_SIZE_MASK;
+
+            header_p = (Test_small_chunk_header*)&reference_memory[offset + req_memory];
+
+            header_p->is_allocated = false;
+            header_p->size_of = (uint32_t)(old_size_of - req_memory) & TEST_SIZE_MASK;
+
+            return (void*)&reference_memory[offset + sizeof(*header_p)];
+        }
+    }
+
+    return NULL;
+}
+
+/* chunks allocated by __fragment_heap */
+static void* fragments[NR_OF_FRAGMENTS];
+
+static void __fragment_heap(void* (*alloc)(const size_t), void (*dealloc)(void*))
+{
+    void** const address = &fragments[0];
+
+    for (size_t i = 0; i < NR_OF_FRAGMENTS; ++i)
+    {
+        address[i] = alloc(60);
+        assert(address[i] != NULL);
+    }
+
+    /* freed chunks do not touch each other, so they are not merged */
+    for (size_t i = 0; i < NR_OF_FRAGMENTS; i += 2)
+    {
+        if (dealloc != NULL)
+        {
+            dealloc(address[i]);
+        }
+        else
+        {
+            Test_small_chunk_header* const header_p =
+                (Test_small_chunk_header*)((uint8_t*)address[i] - sizeof(Test_small_chunk_header));
+            header_p->is_allocated = false;
+        }
+    }
+}
+
+static void __allocate_after_fragments(void* (*alloc)(const size_t))
+{
+    for (size_t i = 0; i < NR_OF_MEASURED_ALLOCATIONS; ++i)
+    {
+        void* const ptr_p = alloc(256);
+        assert(ptr_p != NULL);
+        (void)ptr_p;
+    }
+}
+
+static void __deallocate_fragments(void)
+{
+    for (size_t i = 1; i < NR_OF_FRAGMENTS; i += 2)
+    {
+        ssa_dealloc(fragments[i]);
+    }
+}
+
+static void benchmark_fragmented_heap(void)
+{
+    printf("SSA FRAGMENTED HEAP, %d holes, %d allocations\n", NR_OF_FRAGMENTS / 2, NR_OF_MEASURED_ALLOCATIONS);
+
+    ssa_init();
+    __fragment_heap(ssa_alloc, ssa_dealloc);
+    MEASURE_FUNCTION(__allocate_after_fragments(ssa_alloc), "segregated free lists");
+    MEASURE_FUNCTION(__deallocate_fragments(), "boundary tags dealloc");
+
+    (void)memset(&reference_memory[0], 0, sizeof(reference_memory));
+    ((Test_small_chunk_header*)&reference_memory[0])->size_of = MEMORY_SIZE & TEST_SIZE_MASK;
+    __fragment_heap(__reference_alloc, NULL);
+    MEASURE_FUNCTION(__allocate_after_fragments(__reference_alloc), "linear first fit");
+}
+
+static void test_coalescing(void)
+{
+    ssa_init();
+
+    uint8_t* address[5] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
+    {
+        address[i] = (uint8_t*)ssa_alloc(100);
+        assert(address[i] != NULL);
+    }
+
+    const Test_chunk_header* const first_header_p = (const Test_chunk_header*)(address[1] - sizeof(Test_chunk_header));
+    const Test_chunk_header* const last_header_p = (const Test_chunk_header*)(address[4] - sizeof(Test_chunk_header));
+
+    ssa_dealloc(address[1]);
+    ssa_dealloc(address[3]);
+    assert(last_header_p->is_prev_allocated == false);
+
+    /* chunk between two free chunks joins them */
+    ssa_dealloc(address[2]);
+    assert(first_header_p->is_allocated == false);
+    assert(first_header_p->size_of == 3 * TEST_CHUNK_SIZE(100));
+    assert(last_header_p->is_prev_allocated == false);
+
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 2);
+
+    /* merged chunk is found in its new bin */
+    assert(ssa_alloc(250) == address[1]);
+    assert(last_header_p->is_prev_allocated == false);
+
+    ssa_dealloc(address[1]);
+    ssa_dealloc(address[0]);
+    ssa_dealloc(address[4]);
+
+    const Test_chunk_header* const header_p =
+        (const Test_chunk_header*)ssa_get_address_from_memory(TEST_FIRST_CHUNK_OFFSET);
+    assert(header_p->is_allocated == false && header_p->size_of == TEST_HEAP_SIZE);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 1);
+}
+
+static void test_aligned_allocations(void)
+{
+    ssa_init();
+
+    const size_t alignments[] = {1, 8, 16, 32, 64, 4096};
+    void* address[ARRAY_SIZE(alignments)] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(alignments); ++i)
+    {
+        address[i] = ssa_alloc_aligned(100, alignments[i]);
+        assert(address[i] != NULL);
+        assert(((uintptr_t)address[i] & (alignments[i] - 1)) == 0);
+        assert(((uintptr_t)address[i] & (SSA_ALIGNMENT - 1)) == 0);
+
+        /* padding is not counted in chunk */
+        const Test_chunk_header* const header_p =
+            (const Test_chunk_header*)((uint8_t*)address[i] - sizeof(Test_chunk_header));
+        assert(header_p->size_of == TEST_CHUNK_SIZE(100));
+    }
+
+    assert(ssa_alloc_aligned(100, 0) == NULL);
+    assert(ssa_alloc_aligned(100, 48) == NULL);
+
+    /* padding in front of 4096 B aligned chunk is free, small chunk fits there */
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+    assert(stats.bytes_in_use == ARRAY_SIZE(alignments) * TEST_CHUNK_SIZE(100));
+
+    const uint8_t* const padding_begin_p = (uint8_t*)address[ARRAY_SIZE(alignments) - 2] + TEST_CHUNK_SIZE(100);
+    const uint8_t* const padding_end_p = (uint8_t*)address[ARRAY_SIZE(alignments) - 1];
+    uint8_t* const small_p = (uint8_t*)ssa_alloc(100);
+
+    /* padding depends on address of memory */
+    if ((size_t)(padding_end_p - padding_begin_p) >= TEST_CHUNK_SIZE(100))
+    {
+        assert(small_p >= padding_begin_p && small_p < padding_end_p);
+    }
+
+    ssa_dealloc(small_p);
+
+    for (size_t i = 0; i < ARRAY_SIZE(alignments); ++i)
+    {
+        ssa_dealloc(address[i]);
+    }
+
+    const Test_chunk_header* const header_p =
+        (const Test_chunk_header*)ssa_get_address_from_memory(TEST_FIRST_CHUNK_OFFSET);
+    assert(header_p->is_allocated == false && header_p->size_of == TEST_HEAP_SIZE);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 1 && stats.bytes_in_use == 0);
+}
+
+static void test_realloc(void)
+{
+    ssa_init();
+
+    uint8_t* const first_p = (uint8_t*)ssa_alloc(100);
+    uint8_t* const second_p = (uint8_t*)ssa_alloc(100);
+    uint8_t* const third_p = (uint8_t*)ssa_alloc(100);
+    assert(first_p != NULL && second_p != NULL && third_p != NULL);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        first_p[i] = (uint8_t)i;
+    }
+
+    const Test_chunk_header* const header_p = (const Test_chunk_header*)(first_p - sizeof(Test_chunk_header));
+
+    /* tail is split off in place */
+    assert(ssa_realloc(first_p, 40) == first_p);
+    assert(header_p->size_of == TEST_CHUNK_SIZE(40));
+    assert(ssa_get_usable_size(first_p) == TEST_CHUNK_SIZE(40) - sizeof(Test_chunk_header));
+
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 2);
+    assert(stats.bytes_in_use == TEST_CHUNK_SIZE(40) + 2 * TEST_CHUNK_SIZE(100));
+
+    /* grow back into the tail */
+    assert(ssa_realloc(first_p, 100) == first_p);
+    assert(header_p->size_of == TEST_CHUNK_SIZE(100));
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 1);
+
+    /* the last chunk grows into the rest of memory */
+    assert(ssa_realloc(third_p, 5000) == third_p);
+
+    /* shrink merges tail with the next free chunk */
+    assert(ssa_realloc(third_p, 100) == third_p);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 1 && stats.bytes_in_use == 3 * TEST_CHUNK_SIZE(100));
+
+    /* the next chunk is allocated, so data has to be moved */
+    uint8_t* const moved_p = (uint8_t*)ssa_realloc(first_p, 200);
+    assert(moved_p != NULL && moved_p != first_p);
+
+    for (size_t i = 0; i < 40; ++i)
+    {
+        assert(moved_p[i] == (uint8_t)i);
+    }
+
+    /* failed realloc keeps chunk */
+    assert(ssa_realloc(moved_p, (size_t)1 << 61) == NULL);
+    assert(moved_p[39] == 39);
+
+    uint8_t* const new_p = (uint8_t*)ssa_realloc(NULL, 10);
+    assert(new_p != NULL);
+    assert(ssa_realloc(new_p, 0) == NULL);
+
+    ssa_dealloc(moved_p);
+    ssa_dealloc(second_p);
+    ssa_dealloc(third_p);
+
+    const Test_chunk_header* const first_header_p =
+        (const Test_chunk_header*)ssa_get_address_from_memory(TEST_FIRST_CHUNK_OFFSET);
+    assert(first_header_p->is_allocated == false && first_header_p->size_of == TEST_HEAP_SIZE);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_free_chunks == 1 && stats.bytes_in_use == 0);
+}
+
+static void test_calloc_and_reset(void)
+{
+    ssa_init();
+
+    uint8_t* const addr_p = (uint8_t*)ssa_alloc(1000);
+    assert(addr_p != NULL);
+    (void)memset(addr_p, 0xee, 1000);
+
+    /* reset writes only headers (and free list links), so data of the first chunk is still there */
+    ssa_init();
+
+    uint8_t* const again_p = (uint8_t*)ssa_alloc(1000);
+    assert(again_p == addr_p && again_p[500] == 0xee && again_p[999] == 0xee);
+
+    ssa_dealloc(again_p);
+
+    uint32_t* const array_p = (uint32_t*)ssa_calloc(250, sizeof(uint32_t));
+    assert((uint8_t*)array_p == addr_p);
+
+    for (size_t i = 0; i < 250; ++i)
+    {
+        assert(array_p[i] == 0);
+    }
+
+    assert(ssa_calloc(SIZE_MAX / 2, 3) == NULL);
+    assert(ssa_calloc(0, 8) == NULL);
+
+    /* chunk with own mapping is zeroed by kernel */
+    ssa_set_mmap_threshold(1 << 17);
+
+    uint8_t* const big_p = (uint8_t*)ssa_calloc(1, (1 << 17) + 1);
+    assert(big_p != NULL && big_p[0] == 0 && big_p[1 << 17] == 0);
+
+    ssa_dealloc(big_p);
+    ssa_dealloc(array_p);
+    ssa_set_mmap_threshold(SSA_MMAP_THRESHOLD);
+
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.nr_of_failures == 1);
+}
+
+static void test_mmap_threshold(void)
+{
+    ssa_init();
+
+    /* threshold is set here, because default one could be 0 */
+    const size_t threshold = 1 << 17;
+    ssa_set_mmap_threshold(threshold);
+
+    Ssa_statistics stats;
+    const size_t big_size = threshold + 1;
+
+    uint8_t* const small_p = (uint8_t*)ssa_alloc(100);
+    uint8_t* const big_p = (uint8_t*)ssa_alloc(big_size);
+    assert(small_p != NULL && big_p != NULL);
+    assert(((uintptr_t)big_p & (SSA_ALIGNMENT - 1)) == 0);
 
-/* ------------------------------------------- FUNCTION DECLARATION ------------------------------------------------ */
+    big_p[0] = 1;
+    big_p[big_size - 1] = 2;
 
-/*
-    In this test case we want to allocate lot of memory chunks. After allocations we will go through available memory
-    chunk to ensure they are properly allocated in memory.
+    const Test_chunk_header* const header_p = (const Test_chunk_header*)(big_p - sizeof(Test_chunk_header));
+    assert(header_p->is_allocated == true && header_p->is_mmapped == true);
+    assert(header_p->size_of >= big_size + sizeof(Test_chunk_header));
+    assert(ssa_get_usable_size(big_p) >= big_size && ssa_get_usable_size(big_p) < big_size + 4096);
 
-    PARAMS:
-    @IN - void
+    /* heap is untouched by mapped chunk */
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 1 && stats.nr_of_chunks_in_use == 2);
+    assert(stats.bytes_in_use == TEST_CHUNK_SIZE(100) + header_p->size_of);
+    assert(stats.nr_of_free_chunks == 1 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE - TEST_CHUNK_SIZE(100));
 
-    RETURN:
-    This is void function.
-*/
-static void test_allocations(void);
+    /* page alignment is given by mapping */
+    uint8_t* const aligned_p = (uint8_t*)ssa_alloc_aligned(big_size, 4096);
+    assert(aligned_p != NULL && ((uintptr_t)aligned_p & 4095) == 0);
+    ssa_dealloc(aligned_p);
 
-/*
-    In this test case we want to allocate lot of memory chunks and then deallocates all memory chunks. We expect that
-    one memory chunk left as a not allocated, as after init memory.
+    /* mapped chunk grows by mremap and keeps data */
+    uint8_t* const grown_p = (uint8_t*)ssa_realloc(big_p, 8 * big_size);
+    assert(grown_p != NULL);
+    assert(grown_p[0] == 1 && grown_p[big_size - 1] == 2);
 
-    PARAMS:
-    @IN - void
+    grown_p[8 * big_size - 1] = 3;
 
-    RETURN:
-    This is void function.
-*/
-static void test_deallocations(void);
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 1 && stats.bytes_in_use > TEST_CHUNK_SIZE(100) + 8 * big_size);
 
-/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+    /* small chunk goes back to heap */
+    uint8_t* const shrunk_p = (uint8_t*)ssa_realloc(grown_p, 100);
+    assert(shrunk_p != NULL && shrunk_p[0] == 1);
+    assert(shrunk_p > small_p && shrunk_p < small_p + MEMORY_SIZE);
 
-static void test_allocations(void)
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 0 && stats.bytes_in_use == 2 * TEST_CHUNK_SIZE(100));
+
+    /* heap chunk which is big now is moved to mapping */
+    uint8_t* const moved_p = (uint8_t*)ssa_realloc(shrunk_p, big_size);
+    assert(moved_p != NULL && moved_p[0] == 1);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 1 && stats.nr_of_chunks_in_use == 2);
+
+    ssa_dealloc(moved_p);
+    ssa_dealloc(small_p);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 0 && stats.nr_of_chunks_in_use == 0 && stats.bytes_in_use == 0);
+    assert(stats.nr_of_free_chunks == 1 && stats.size_of_largest_free_chunk == TEST_HEAP_SIZE);
+
+    /* without threshold big chunk is taken from heap */
+    ssa_set_mmap_threshold(0);
+
+    uint8_t* const heap_p = (uint8_t*)ssa_alloc(big_size);
+    assert(heap_p != NULL);
+    assert(((const Test_chunk_header*)(heap_p - sizeof(Test_chunk_header)))->is_mmapped == false);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 0 && stats.bytes_in_use == TEST_CHUNK_SIZE(big_size));
+
+    ssa_dealloc(heap_p);
+    ssa_set_mmap_threshold(threshold);
+
+    /* init unmaps chunks which were not freed */
+    assert(ssa_alloc(big_size) != NULL);
+    ssa_init();
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_mapped_chunks == 0 && stats.bytes_in_use == 0);
+
+    ssa_set_mmap_threshold(SSA_MMAP_THRESHOLD);
+}
+
+#if SSA_MAX_HEAP_SIZE > MEMORY_SIZE
+
+/* chunks allocated by test_heap_growth */
+static void* growth_chunks[3 * (MEMORY_SIZE >> 12)];
+
+static void test_heap_growth(void)
 {
     ssa_init();
 
-    const size_t size_of_data[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
-    void* address[ARRAY_SIZE(size_of_data)] = {0};
+    /* big chunks have to be taken from heap, not mapped directly */
+    ssa_set_mmap_threshold(0);
 
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    Ssa_statistics stats;
+
+    /* request bigger than static memory gets chunk from new segment */
+    uint8_t* const big_p = (uint8_t*)ssa_alloc(2 * (size_t)MEMORY_SIZE);
+    assert(big_p != NULL);
+
+    big_p[0] = 1;
+    big_p[2 * (size_t)MEMORY_SIZE - 1] = 1;
+
+    const Test_chunk_header* const header_p = (const Test_chunk_header*)(big_p - sizeof(Test_chunk_header));
+    assert(header_p->size_of == TEST_CHUNK_SIZE(2 * (size_t)MEMORY_SIZE));
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_segments == 2 && stats.size_of_heap > 3 * (size_t)MEMORY_SIZE);
+
+    /* small chunks take static memory and rest of segments */
+    for (size_t i = 0; i < ARRAY_SIZE(growth_chunks); ++i)
     {
-        address[i] = ssa_alloc(size_of_data[i]);
-        assert(address[i] != NULL);
+        growth_chunks[i] = ssa_alloc(4000);
+        assert(growth_chunks[i] != NULL);
+        (void)memset(growth_chunks[i], (int)i, 4000);
     }
 
-    size_t offset = 0;
-    Test_chunk_header* header_p = (Test_chunk_header*)ssa_get_address_from_memory(offset);
+    for (size_t i = 0; i < ARRAY_SIZE(growth_chunks); ++i)
+    {
+        ssa_dealloc(growth_chunks[i]);
+    }
 
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    ssa_dealloc(big_p);
+
+    /* chunks are never merged between segments */
+    ssa_read_statistics(&stats);
+    assert(stats.bytes_in_use == 0 && stats.nr_of_free_chunks == stats.nr_of_segments);
+
+#if SSA_MAX_HEAP_SIZE > (1ULL << 33)
+    /* size does not fit in 32 bits */
+    const size_t huge_size = (size_t)5 << 30;
+    uint8_t* const huge_p = (uint8_t*)ssa_alloc(huge_size);
+    assert(huge_p != NULL);
+
+    huge_p[huge_size - 1] = 1;
+
+    const Test_chunk_header* const huge_header_p = (const Test_chunk_header*)(huge_p - sizeof(Test_chunk_header));
+    assert(huge_header_p->size_of == TEST_CHUNK_SIZE(huge_size));
+
+    ssa_dealloc(huge_p);
+#endif
+
+    /* init gives mapped segments back */
+    ssa_init();
+    ssa_set_mmap_threshold(SSA_MMAP_THRESHOLD);
+
+    ssa_read_statistics(&stats);
+    assert(stats.nr_of_segments == 1 && stats.size_of_heap == MEMORY_SIZE);
+}
+
+#endif
+
+/* buffer grown in realloc benchmark */
+static uint8_t* buffer_p;
+
+static void __append_by_realloc(void)
+{
+    for (size_t i = 1; i <= NR_OF_APPENDS; ++i)
     {
-        assert(header_p->is_allocated == true);
-        assert(header_p->size_of == size_of_data[i] + sizeof(*header_p));
+        buffer_p = (uint8_t*)ssa_realloc(buffer_p, i * APPEND_SIZE);
+        assert(buffer_p != NULL);
 
-        offset += header_p->size_of;
-        header_p = (Test_chunk_header*)ssa_get_address_from_memory(offset);
+        (void)memset(&buffer_p[(i - 1) * APPEND_SIZE], (int)i, APPEND_SIZE);
     }
 }
 
-static void test_deallocations(void)
+static void __append_by_copy(void)
+{
+    for (size_t i = 1; i <= NR_OF_APPENDS; ++i)
+    {
+        uint8_t* const new_buffer_p = (uint8_t*)ssa_alloc(i * APPEND_SIZE);
+        assert(new_buffer_p != NULL);
+
+        if (buffer_p != NULL)
+        {
+            (void)memcpy(new_buffer_p, buffer_p, (i - 1) * APPEND_SIZE);
+            ssa_dealloc(buffer_p);
+        }
+
+        buffer_p = new_buffer_p;
+        (void)memset(&buffer_p[(i - 1) * APPEND_SIZE], (int)i, APPEND_SIZE);
+    }
+}
+
+static void benchmark_realloc(void)
 {
+    printf("SSA GROWING BUFFER, %d appends of %d B\n", NR_OF_APPENDS, APPEND_SIZE);
+
     ssa_init();
+    buffer_p = NULL;
+    MEASURE_FUNCTION(__append_by_realloc(), "ssa_realloc");
+    ssa_dealloc(buffer_p);
 
-    /* after lots of alloc -> dealloce we expect that we've got one chunk with size_of equals MEMORY_SIZE */
-    const size_t offset = 0;
-    const Test_chunk_header* const header_p = (Test_chunk_header*)ssa_get_address_from_memory(offset);
+    buffer_p = NULL;
+    MEASURE_FUNCTION(__append_by_copy(), "alloc + copy + free");
+    ssa_dealloc(buffer_p);
+}
 
-    /* allocate memory chunks in increasing order and then deallocate memory chunk in increasing order */
-    const size_t size_of_data[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
-    void* address[ARRAY_SIZE(size_of_data)] = {0};
+static void test_tlsf_allocations(void)
+{
+    tlsf_init();
 
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    uint8_t* address[64] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
     {
-        address[i] = ssa_alloc(size_of_data[i]);
+        address[i] = (uint8_t*)tlsf_alloc(i + 1);
         assert(address[i] != NULL);
+
+        const Test_small_chunk_header* const header_p =
+            (const Test_small_chunk_header*)(address[i] - sizeof(Test_small_chunk_header));
+        const size_t expected = (i + 1 + sizeof(Test_small_chunk_header) + 3) & ~(size_t)3;
+
+        assert(header_p->is_allocated == true);
+        assert(header_p->size_of == (expected < TEST_SMALL_MIN_CHUNK_SIZE ? TEST_SMALL_MIN_CHUNK_SIZE : expected));
+        assert(((uintptr_t)address[i] & 3) == 0);
+
+        if (i > 0)
+        {
+            const Test_small_chunk_header* const prev_header_p =
+                (const Test_small_chunk_header*)(address[i - 1] - sizeof(Test_small_chunk_header));
+
+            assert(address[i] == address[i - 1] + prev_header_p->size_of);
+        }
     }
 
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    assert(tlsf_alloc(0) == NULL);
+    assert(tlsf_alloc(TLSF_MEMORY_SIZE) == NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
     {
-        ssa_dealloc(address[i]);
+        tlsf_dealloc(address[i]);
     }
 
-    assert(header_p->is_allocated == false);
-    assert(header_p->size_of == MEMORY_SIZE);
+    const Test_small_chunk_header* const header_p =
+        (const Test_small_chunk_header*)tlsf_get_address_from_memory(0);
+    assert(header_p->is_allocated == false && header_p->size_of == (TLSF_MEMORY_SIZE & ~3));
 
-    /* allocate memory chunks in increasing order and then deallocate memory chunk in decreasing order */
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    /* the whole memory can be taken at once */
+    void* const all_p = tlsf_alloc((TLSF_MEMORY_SIZE & ~3) - sizeof(Test_small_chunk_header));
+    assert(all_p == tlsf_get_address_from_memory(sizeof(Test_small_chunk_header)));
+    assert(tlsf_alloc(1) == NULL);
+
+    tlsf_dealloc(all_p);
+}
+
+static void test_tlsf_coalescing(void)
+{
+    tlsf_init();
+
+    uint8_t* address[5] = {0};
+
+    for (size_t i = 0; i < ARRAY_SIZE(address); ++i)
     {
-        address[i] = ssa_alloc(size_of_data[i]);
+        address[i] = (uint8_t*)tlsf_alloc(1000);
         assert(address[i] != NULL);
     }
 
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    /* smaller request from the same first level takes freed chunk, not the rest of memory */
+    tlsf_dealloc(address[1]);
+    assert(tlsf_alloc(900) == address[1]);
+    tlsf_dealloc(address[1]);
+
+    const Test_small_chunk_header* const first_header_p =
+        (const Test_small_chunk_header*)(address[1] - sizeof(Test_small_chunk_header));
+    const Test_small_chunk_header* const last_header_p =
+        (const Test_small_chunk_header*)(address[4] - sizeof(Test_small_chunk_header));
+
+    tlsf_dealloc(address[3]);
+    assert(last_header_p->is_prev_allocated == false);
+
+    /* chunk between two free chunks joins them */
+    tlsf_dealloc(address[2]);
+    assert(first_header_p->is_allocated == false);
+    assert(first_header_p->size_of == 3 * (1000 + sizeof(Test_small_chunk_header)));
+
+    assert(tlsf_alloc(2500) == address[1]);
+
+    tlsf_dealloc(address[1]);
+    tlsf_dealloc(address[0]);
+    tlsf_dealloc(address[4]);
+
+    const Test_small_chunk_header* const header_p =
+        (const Test_small_chunk_header*)tlsf_get_address_from_memory(0);
+    assert(header_p->is_allocated == false && header_p->size_of == (TLSF_MEMORY_SIZE & ~3));
+}
+
+static void __reference_dealloc(void* addr_p)
+{
+    ((Test_small_chunk_header*)((uint8_t*)addr_p - sizeof(Test_small_chunk_header)))->is_allocated = false;
+
+    Test_small_chunk_header* curr_header_p = NULL;
+
+    for (size_t offset = 0; offset < MEMORY_SIZE; offset += curr_header_p->size_of)
     {
-        ssa_dealloc(address[ARRAY_SIZE(size_of_data) - i - 1]);
+        curr_header_p = (Test_small_chunk_header*)&reference_memory[offset];
+
+        while (curr_header_p->is_allocated == false && offset + curr_header_p->size_of < MEMORY_SIZE)
+        {
+            const Test_small_chunk_header* const next_header_p =
+                (const Test_small_chunk_header*)&reference_memory[offset + curr_header_p->size_of];
+
+            if (next_header_p->is_allocated == true)
+            {
+                break;
+            }
+
+            curr_header_p->size_of = (curr_header_p->size_of + next_header_p->size_of) & TEST_SIZE_MASK;
+        }
     }
+}
 
-    assert(header_p->is_allocated == false);
-    assert(header_p->size_of == MEMORY_SIZE);
+static int __compare_samples(const void* a_p, const void* b_p)
+{
+    const uint64_t a = *(const uint64_t*)a_p;
+    const uint64_t b = *(const uint64_t*)b_p;
 
-    /* allocate memory chunks in increasing order and then deallocate memory chunk in given order */
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    return (a > b) - (a < b);
+}
+
+/* latency of each alloc in ns */
+static uint64_t latency_samples[NR_OF_LATENCY_SAMPLES];
+
+static void __measure_latency(void* (*alloc)(const size_t), void (*dealloc)(void*), const char* label)
+{
+    void* live[NR_OF_LIVE_CHUNKS] = {0};
+
+    srand(1);
+
+    for (size_t i = 0; i < NR_OF_LATENCY_SAMPLES; ++i)
     {
-        address[i] = ssa_alloc(size_of_data[i]);
-        assert(address[i] != NULL);
+        const size_t slot = (size_t)rand() % NR_OF_LIVE_CHUNKS;
+        const size_t bytes = 16 + 4 * ((size_t)rand() % 500);
+
+        if (live[slot] != NULL)
+        {
+            dealloc(live[slot]);
+        }
+
+        struct timespec start;
+        struct timespec end;
+
+        clock_gettime(CLOCK_TYPE, &start);
+        live[slot] = alloc(bytes);
+        clock_gettime(CLOCK_TYPE, &end);
+
+        assert(live[slot] != NULL);
+
+        latency_samples[i] = (uint64_t)((end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec));
     }
 
-    const size_t index_to_dealloc[] = {0, 2, 4, 6, 8, 10, 9, 7, 5, 3, 1};
-    assert(sizeof(index_to_dealloc) == sizeof(size_of_data));
+    for (size_t i = 0; i < ARRAY_SIZE(live); ++i)
+    {
+        dealloc(live[i]);
+    }
 
-    for (size_t i = 0; i < ARRAY_SIZE(size_of_data); ++i)
+    qsort(&latency_samples[0], ARRAY_SIZE(latency_samples), sizeof(latency_samples[0]), __compare_samples);
+
+    printf("%s alloc latency [ns]: p50 = %lu, p99 = %lu, p99.9 = %lu, max = %lu\n",
+           label,
+           (unsigned long)latency_samples[NR_OF_LATENCY_SAMPLES / 2],
+           (unsigned long)latency_samples[NR_OF_LATENCY_SAMPLES * 99 / 100],
+           (unsigned long)latency_samples[NR_OF_LATENCY_SAMPLES * 999 / 1000],
+           (unsigned long)latency_samples[NR_OF_LATENCY_SAMPLES - 1]);
+}
+
+static void benchmark_latency(void)
+{
+    printf("ALLOC LATENCY, %d live chunks, %d allocations\n", NR_OF_LIVE_CHUNKS, NR_OF_LATENCY_SAMPLES);
+
+    tlsf_init();
+    __measure_latency(tlsf_alloc, tlsf_dealloc, "tlsf");
+
+    ssa_init();
+    __measure_latency(ssa_alloc, ssa_dealloc, "segregated free lists");
+
+    (void)memset(&reference_memory[0], 0, sizeof(reference_memory));
+    ((Test_small_chunk_header*)&reference_memory[0])->size_of = MEMORY_SIZE & TEST_SIZE_MASK;
+    __measure_latency(__reference_alloc, __reference_dealloc, "linear first fit");
+}
+
+static void __run_threads(void* (*routine)(void*))
+{
+    pthread_t threads[NR_OF_THREADS];
+
+    for (size_t i = 0; i < NR_OF_THREADS; ++i)
     {
-        ssa_dealloc(address[index_to_dealloc[i]]);
+        const int ret = pthread_create(&threads[i], NULL, routine, (void*)(uintptr_t)i);
+        assert(ret == 0);
+        (void)ret;
     }
 
-    assert(header_p->is_allocated == false);
-    assert(header_p->size_of == MEMORY_SIZE);
+    for (size_t i = 0; i < NR_OF_THREADS; ++i)
+    {
+        (void)pthread_join(threads[i], NULL);
+    }
+}
+
+static void* __alloc_thread(void* arg_p)
+{
+    uint8_t** const chunks_p = (uint8_t**)arg_p;
+
+    chunks_p[0] = ssa_arenas_alloc(100);
+    chunks_p[1] = ssa_arenas_alloc(SSA_MMAP_THRESHOLD + 1);
+    chunks_p[2] = ssa_arenas_alloc(200);
+
+    return NULL;
+}
+
+static void test_arenas_routing(void)
+{
+    assert(ssa_arenas_init(SSA_MAX_NR_OF_ARENAS + 1) == false);
+    assert(ssa_arenas_init(4) == true);
+
+    Ssa_statistics stats;
+    ssa_arenas_read_statistics(&stats);
+
+    assert(stats.size_of_heap == 4 * (size_t)SSA_ARENA_SIZE && stats.nr_of_free_chunks == 4);
+
+    /* chunks of other thread are freed and resized here */
+    uint8_t* chunks[3];
+    pthread_t thread;
+
+    assert(pthread_create(&thread, NULL, __alloc_thread, &chunks[0]) == 0);
+    (void)pthread_join(thread, NULL);
+
+    assert(chunks[0] != NULL && chunks[1] != NULL && chunks[2] != NULL);
+
+    (void)memset(chunks[2], 0xab, 200);
+    chunks[2] = ssa_arenas_realloc(chunks[2], 1000);
+    assert(chunks[2] != NULL && chunks[2][199] == 0xab);
+
+    uint8_t* const own_p = ssa_arenas_calloc(10, 10);
+    assert(own_p != NULL && own_p[99] == 0);
+
+    ssa_arenas_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 4 && stats.nr_of_mapped_chunks == (SSA_MMAP_THRESHOLD != 0 ? 1 : 0));
+
+    /* chunks of default heap are ignored, mapped one keeps heap in its descriptor too, but it is not heap of arena */
+    Ssa_statistics default_stats;
+    ssa_init();
+
+    uint8_t* const small_p = ssa_alloc(10);
+    uint8_t* const big_p = ssa_alloc(SSA_MMAP_THRESHOLD + 1);
+    assert(small_p != NULL && big_p != NULL);
+
+    ssa_arenas_dealloc(small_p);
+    assert(ssa_arenas_realloc(small_p, 100) == NULL);
+
+    ssa_arenas_dealloc(big_p);
+    assert(ssa_arenas_realloc(big_p, 10) == NULL);
+
+    ssa_read_statistics(&default_stats);
+    assert(default_stats.nr_of_chunks_in_use == 2 && default_stats.nr_of_frees == 0);
+
+    ssa_dealloc(small_p);
+    ssa_dealloc(big_p);
+
+    ssa_read_statistics(&default_stats);
+    assert(default_stats.nr_of_chunks_in_use == 0 && default_stats.nr_of_mapped_chunks == 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(chunks); ++i)
+    {
+        ssa_arenas_dealloc(chunks[i]);
+    }
+
+    ssa_arenas_dealloc(own_p);
+
+    ssa_arenas_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.nr_of_mapped_chunks == 0 && stats.bytes_in_use == 0);
+    assert(stats.nr_of_free_chunks == 4 && stats.nr_of_allocs == stats.nr_of_frees);
+
+    /* each arena is one free extent, request can not take memory of two arenas */
+    Ssa_fragmentation frag;
+    ssa_arenas_read_fragmentation(&frag);
+
+    assert(frag.nr_of_free_extents == 4 && frag.free_bytes == 4 * frag.size_of_largest_free_extent);
+    assert(frag.external_fragmentation == 0.75 && frag.allocated_bytes > frag.requested_bytes);
+
+#ifndef SSA_ARENA_BY_CPU
+    /* chunks of other thread arena waited in its queue until statistics were read */
+    assert(stats.nr_of_remote_frees == ARRAY_SIZE(chunks));
+#endif
+}
+
+static void* __stress_alloc_thread(void* arg_p)
+{
+    const size_t index = (size_t)(uintptr_t)arg_p;
+    unsigned int seed = (unsigned int)index;
+
+    for (size_t i = 0; i < NR_OF_THREAD_CHUNKS; ++i)
+    {
+        const size_t bytes = 1 + (size_t)rand_r(&seed) % 2000;
+
+        thread_chunks[index][i] = i % 3 == 0 ? ssa_arenas_alloc_aligned(bytes, 256) : ssa_arenas_alloc(bytes);
+        assert(thread_chunks[index][i] != NULL);
+
+        (void)memset(thread_chunks[index][i], (int)index, bytes);
+
+        /* some chunks are freed by owner at once */
+        if (i % 4 == 0)
+        {
+            ssa_arenas_dealloc(thread_chunks[index][i]);
+            thread_chunks[index][i] = NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static void* __stress_dealloc_thread(void* arg_p)
+{
+    const size_t index = ((size_t)(uintptr_t)arg_p + 1) % NR_OF_THREADS;
+
+    for (size_t i = 0; i < NR_OF_THREAD_CHUNKS; ++i)
+    {
+        if (thread_chunks[index][i] != NULL)
+        {
+            assert(thread_chunks[index][i][0] == (uint8_t)index);
+            ssa_arenas_dealloc(thread_chunks[index][i]);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_arenas_threads_stress(void)
+{
+    assert(ssa_arenas_init(NR_OF_THREADS / 2) == true);
+
+    /* two threads share each arena, so lock of arena is tested too */
+    __run_threads(__stress_alloc_thread);
+    __run_threads(__stress_dealloc_thread);
+
+    Ssa_statistics stats;
+    ssa_arenas_read_statistics(&stats);
+
+    assert(stats.nr_of_chunks_in_use == 0 && stats.bytes_in_use == 0);
+    assert(stats.nr_of_free_chunks == NR_OF_THREADS / 2 && stats.nr_of_failures == 0);
+}
+
+static void* __benchmark_thread(void* arg_p)
+{
+    unsigned int seed = (unsigned int)(uintptr_t)arg_p;
+    void* live[16] = {0};
+
+    for (size_t i = 0; i < NR_OF_THREAD_ITERATIONS; ++i)
+    {
+        const size_t slot = i % ARRAY_SIZE(live);
+
+        ssa_arenas_dealloc(live[slot]);
+        live[slot] = ssa_arenas_alloc(16 + (size_t)rand_r(&seed) % 1000);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(live); ++i)
+    {
+        ssa_arenas_dealloc(live[i]);
+    }
+
+    return NULL;
+}
+
+static void benchmark_arenas(void)
+{
+    printf("ARENAS, %d threads, %d allocations per thread\n", NR_OF_THREADS, NR_OF_THREAD_ITERATIONS);
+
+    assert(ssa_arenas_init(1) == true);
+    MEASURE_FUNCTION(__run_threads(__benchmark_thread), "one arena (global lock)");
+
+    assert(ssa_arenas_init(NR_OF_THREADS) == true);
+    MEASURE_FUNCTION(__run_threads(__benchmark_thread), "arena per thread");
+}
+
+static void* __pipeline_thread(void* arg_p)
+{
+    const size_t index = (size_t)(uintptr_t)arg_p;
+    Pipeline_ring* const ring_p = &pipeline_rings[index / 2];
+
+    if (index % 2 == 0)
+    {
+        unsigned int seed = (unsigned int)index;
+
+        for (size_t i = 0; i < NR_OF_PIPELINE_BUFFERS; ++i)
+        {
+            const size_t bytes = 16 + (size_t)rand_r(&seed) % 1000;
+            uint8_t* const chunk_p = ssa_arenas_alloc(bytes);
+            assert(chunk_p != NULL);
+
+            chunk_p[bytes - 1] = (uint8_t)i;
+
+            const size_t head = ring_p->head;
+
+            while (head - __atomic_load_n(&ring_p->tail, __ATOMIC_ACQUIRE) == PIPELINE_RING_SIZE)
+            {
+                (void)sched_yield();
+            }
+
+            ring_p->buffers[head % PIPELINE_RING_SIZE] = chunk_p;
+            __atomic_store_n(&ring_p->head, head + 1, __ATOMIC_RELEASE);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < NR_OF_PIPELINE_BUFFERS; ++i)
+        {
+            const size_t tail = ring_p->tail;
+
+            while (__atomic_load_n(&ring_p->head, __ATOMIC_ACQUIRE) == tail)
+            {
+                (void)sched_yield();
+            }
+
+            ssa_arenas_dealloc(ring_p->buffers[tail % PIPELINE_RING_SIZE]);
+            __atomic_store_n(&ring_p->tail, tail + 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    return NULL;
+}
+
+static void benchmark_pipeline(void)
+{
+    printf("PIPELINE, %d producer and consumer pairs, %d buffers per pair\n",
+           NR_OF_THREADS / 2,
+           NR_OF_PIPELINE_BUFFERS);
+
+    Ssa_statistics stats;
+
+    assert(ssa_arenas_init(1) == true);
+    (void)memset(&pipeline_rings[0], 0, sizeof(pipeline_rings));
+    MEASURE_FUNCTION(__run_threads(__pipeline_thread), "one arena (global lock)");
+
+    ssa_arenas_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 0 && stats.nr_of_remote_frees == 0);
+
+    assert(ssa_arenas_init(NR_OF_THREADS) == true);
+    (void)memset(&pipeline_rings[0], 0, sizeof(pipeline_rings));
+    MEASURE_FUNCTION(__run_threads(__pipeline_thread), "arena per thread (remote free queues)");
+
+    ssa_arenas_read_statistics(&stats);
+    assert(stats.nr_of_chunks_in_use == 0);
 }
 
 /* ----------------------------------------------- MAIN FUNCTION --------------------------------------------------- */
@@ -139,6 +1669,28 @@ int main(void)
 {
     test_allocations();
     test_deallocations();
+    test_statistics();
+    test_fragmentation();
+    test_segregated_fit();
+    test_coalescing();
+    test_aligned_allocations();
+    test_realloc();
+    test_calloc_and_reset();
+    test_mmap_threshold();
+
+#if SSA_MAX_HEAP_SIZE > MEMORY_SIZE
+    test_heap_growth();
+#endif
+    test_tlsf_allocations();
+    test_tlsf_coalescing();
+    test_arenas_routing();
+    test_arenas_threads_stress();
+
+    benchmark_fragmented_heap();
+    benchmark_realloc();
+    benchmark_latency();
+    benchmark_arenas();
+    benchmark_pipeline();
 
     return 0;
 }
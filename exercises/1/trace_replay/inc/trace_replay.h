@@ -0,0 +1,192 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+/*
+    Binary trace of allocations and deterministic replay of it. Trace is recorded by malloc interposer
+    (INTERPOSER_TRACE=path, see malloc_interposer.h) or generated, then the same sequence of operations is replayed on
+    any allocator described by Trace_allocator, so allocators can be compared on production allocation patterns.
+
+    File format: Trace_header followed by Trace_event records in order of operations, both in byte order of machine
+    which recorded them. Block is identified by its address in traced program, address is unique among live blocks.
+    Replay is single threaded, thread of event is kept only for analysis.
+
+    author: Kamil Kielbasa
+    email: dusergithub@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* "ATRC" read as little endian 32-bit word */
+#define TRACE_MAGIC 0x43525441
+#define TRACE_VERSION 1
+
+/* types of events */
+#define TRACE_ALLOC 0 /* malloc, calloc and aligned allocations, new block is @id */
+#define TRACE_FREE 1 /* block @id is freed */
+#define TRACE_REALLOC 2 /* block @id is resized to @size and it is @new_id now */
+
+struct Trace_header
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+typedef struct Trace_header Trace_header;
+
+/* one operation, 32 bytes */
+struct Trace_event
+{
+    uint64_t id;
+    uint64_t new_id;
+
+    uint64_t size : 48; /* requested bytes, 0 for free */
+    uint64_t thread : 12; /* threads are numbered in order of their first event */
+    uint64_t type : 4;
+
+    uint64_t timestamp; /* ns from start of recording */
+};
+
+typedef struct Trace_event Trace_event;
+
+typedef struct Trace Trace;
+
+/* allocator driven by replay, all functions have to be set */
+struct Trace_allocator
+{
+    const char* name;
+
+    void (*init)(void);
+    void* (*alloc)(size_t bytes);
+    void (*dealloc)(void* addr_p);
+    void* (*realloc)(void* addr_p, size_t bytes);
+
+    /* bytes taken by allocator for live blocks, with headers and rounding */
+    size_t (*get_footprint)(void);
+};
+
+typedef struct Trace_allocator Trace_allocator;
+
+/*
+    Result of replay. Footprint is read when requested bytes of live blocks are at peak, fragmentation is part of
+    footprint which is not requested memory: 1 - peak_requested_bytes / peak_footprint.
+*/
+struct Trace_replay_result
+{
+    size_t nr_of_operations;
+    size_t nr_of_failures;
+
+    double ns_per_operation;
+
+    size_t peak_requested_bytes;
+    size_t peak_footprint;
+    double fragmentation;
+};
+
+typedef struct Trace_replay_result Trace_replay_result;
+
+/*
+    This function create trace from events. Addresses of blocks are mapped to dense slots, events which refer to
+    blocks not allocated in trace (allocated before recording started) are skipped.
+
+    PARAMS:
+    @IN events_p - array of events.
+    @IN nr_of_events - number of events.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Trace if success.
+*/
+Trace* trace_create(const Trace_event* events_p, const size_t nr_of_events);
+
+/*
+    This function load trace from file, see trace_create.
+
+    PARAMS:
+    @IN path - path of trace file.
+
+    RETURN:
+    @NULL if file can not be read or it is not trace.
+    @Pointer to Trace if success.
+*/
+Trace* trace_load(const char* path);
+
+/*
+    This function generate synthetic trace: mostly small blocks, some of them are resized, up to @max_live_blocks
+    blocks are live at once.
+
+    PARAMS:
+    @IN nr_of_events - number of events.
+    @IN max_live_blocks - max number of live blocks.
+    @IN seed - seed of pseudo random generator, the same seed gives the same trace.
+
+    RETURN:
+    @NULL if failure.
+    @Pointer to Trace if success.
+*/
+Trace* trace_generate(const size_t nr_of_events, const size_t max_live_blocks, const uint32_t seed);
+
+/*
+    This function save events of trace to file.
+
+    PARAMS:
+    @IN trace_p - pointer to trace.
+    @IN path - path of trace file.
+
+    RETURN:
+    @true if success.
+    @false otherwise.
+*/
+bool trace_save(const Trace* trace_p, const char* path);
+
+/*
+    This function destroy trace.
+
+    PARAMS:
+    @IN trace_p - pointer to trace.
+
+    RETURN:
+    This is void function.
+*/
+void trace_destroy(Trace* trace_p);
+
+/*
+    Getter for number of operations which are replayed (skipped events are not counted).
+
+    PARAMS:
+    @IN trace_p - pointer to trace.
+
+    RETURN:
+    Number of operations.
+*/
+size_t trace_get_nr_of_operations(const Trace* trace_p);
+
+/*
+    Getter for max number of blocks live at once.
+
+    PARAMS:
+    @IN trace_p - pointer to trace.
+
+    RETURN:
+    Number of slots.
+*/
+size_t trace_get_nr_of_slots(const Trace* trace_p);
+
+/*
+    This function replay trace on allocator. Allocator is initialized first, blocks live at the end of trace are freed
+    after time is measured. The first byte of each block is written, so each block is touched once.
+
+    PARAMS:
+    @IN trace_p - pointer to trace.
+    @IN allocator_p - pointer to allocator.
+    @OUT result_p - pointer to result.
+
+    RETURN:
+    This is void function.
+*/
+void trace_replay(const Trace* trace_p, const Trace_allocator* allocator_p, Trace_replay_result* result_p);
+
+#endif /* TRACE_REPLAY_H */
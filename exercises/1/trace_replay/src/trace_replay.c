@@ -0,0 +1,551 @@
+#include <trace_replay.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* empty entry of id table, addresses of blocks are never 0 */
+#define NO_ID 0
+
+/* slot is not used */
+#define NO_SLOT UINT32_MAX
+
+/* size has got 48 bits in event */
+#define SIZE_MASK (((uint64_t)1 << 48) - 1)
+
+/* ------------------------------------------------ STRUCTURES ----------------------------------------------------- */
+
+/* event with address of block replaced by slot */
+struct Trace_operation
+{
+    uint64_t size : 48;
+    uint64_t type : 16;
+
+    uint32_t slot;
+};
+
+typedef struct Trace_operation Trace_operation;
+
+struct Trace
+{
+    Trace_event* events_p;
+    size_t nr_of_events;
+
+    Trace_operation* operations_p;
+    size_t nr_of_operations;
+    size_t nr_of_slots;
+
+    /* requested bytes of live blocks are the biggest after this operation */
+    size_t peak_operation;
+    size_t peak_requested_bytes;
+};
+
+/* open addressing table which maps address of live block to its slot */
+struct Id_table
+{
+    uint64_t* ids_p;
+    uint32_t* slots_p;
+    size_t mask;
+};
+
+typedef struct Id_table Id_table;
+
+/* --------------------------------------- STATIC FUNCTION DECLARATION --------------------------------------------- */
+
+/*
+    This function compute first entry of @id in table.
+
+    PARAMS:
+    @IN table_p - pointer to table.
+    @IN id - address of block.
+
+    RETURN:
+    Index of entry.
+*/
+static inline size_t __id_hash(const Id_table* table_p, const uint64_t id);
+
+/*
+    This function find slot of block.
+
+    PARAMS:
+    @IN table_p - pointer to table.
+    @IN id - address of block.
+
+    RETURN:
+    @NO_SLOT if block is not live.
+    @slot if success.
+*/
+static uint32_t __id_find(const Id_table* table_p, const uint64_t id);
+
+/*
+    This function insert block to table, table has to have free entry.
+
+    PARAMS:
+    @IN table_p - pointer to table.
+    @IN id - address of block.
+    @IN slot - slot of block.
+
+    RETURN:
+    This is void function.
+*/
+static void __id_insert(Id_table* table_p, const uint64_t id, const uint32_t slot);
+
+/*
+    This function remove block from table. Entries after it are moved back, so table does not need tombstones.
+
+    PARAMS:
+    @IN table_p - pointer to table.
+    @IN id - address of block.
+
+    RETURN:
+    This is void function.
+*/
+static void __id_remove(Id_table* table_p, const uint64_t id);
+
+/*
+    This function compute time between two points in ns.
+
+    PARAMS:
+    @IN start_p - pointer to start time.
+    @IN end_p - pointer to end time.
+
+    RETURN:
+    Time in ns.
+*/
+static inline double __elapsed_ns(const struct timespec* start_p, const struct timespec* end_p);
+
+/* --------------------------------------- STATIC FUNCTION DEFINITION ---------------------------------------------- */
+
+static inline size_t __id_hash(const Id_table* table_p, const uint64_t id)
+{
+    /* addresses are aligned, so low bits are mixed with high ones */
+    return (size_t)((id * 0x9e3779b97f4a7c15ULL) >> 17) & table_p->mask;
+}
+
+static uint32_t __id_find(const Id_table* table_p, const uint64_t id)
+{
+    for (size_t i = __id_hash(table_p, id); table_p->ids_p[i] != NO_ID; i = (i + 1) & table_p->mask)
+    {
+        if (table_p->ids_p[i] == id)
+        {
+            return table_p->slots_p[i];
+        }
+    }
+
+    return NO_SLOT;
+}
+
+static void __id_insert(Id_table* table_p, const uint64_t id, const uint32_t slot)
+{
+    size_t i = __id_hash(table_p, id);
+
+    while (table_p->ids_p[i] != NO_ID && table_p->ids_p[i] != id)
+    {
+        i = (i + 1) & table_p->mask;
+    }
+
+    table_p->ids_p[i] = id;
+    table_p->slots_p[i] = slot;
+}
+
+static void __id_remove(Id_table* table_p, const uint64_t id)
+{
+    size_t i = __id_hash(table_p, id);
+
+    while (table_p->ids_p[i] != id)
+    {
+        if (table_p->ids_p[i] == NO_ID)
+        {
+            return;
+        }
+
+        i = (i + 1) & table_p->mask;
+    }
+
+    /* entry after hole is moved to it if hole lies between its first entry and its place */
+    size_t hole = i;
+
+    for (size_t j = (hole + 1) & table_p->mask; table_p->ids_p[j] != NO_ID; j = (j + 1) & table_p->mask)
+    {
+        const size_t first = __id_hash(table_p, table_p->ids_p[j]);
+
+        if (((j - first) & table_p->mask) >= ((j - hole) & table_p->mask))
+        {
+            table_p->ids_p[hole] = table_p->ids_p[j];
+            table_p->slots_p[hole] = table_p->slots_p[j];
+            hole = j;
+        }
+    }
+
+    table_p->ids_p[hole] = NO_ID;
+}
+
+static inline double __elapsed_ns(const struct timespec* start_p, const struct timespec* end_p)
+{
+    return (double)(end_p->tv_sec - start_p->tv_sec) * 1e9 + (double)(end_p->tv_nsec - start_p->tv_nsec);
+}
+
+/* -------------------------------------------- FUNCTION DEFINITION ------------------------------------------------ */
+
+Trace* trace_create(const Trace_event* events_p, const size_t nr_of_events)
+{
+    if (events_p == NULL && nr_of_events != 0)
+    {
+        return NULL;
+    }
+
+    size_t capacity = 16;
+
+    while (capacity < 2 * nr_of_events)
+    {
+        capacity <<= 1;
+    }
+
+    Trace* const trace_p = (Trace*)calloc(1, sizeof(*trace_p));
+    Id_table table = {.ids_p = (uint64_t*)calloc(capacity, sizeof(uint64_t)),
+                      .slots_p = (uint32_t*)calloc(capacity, sizeof(uint32_t)),
+                      .mask = capacity - 1};
+
+    /* slots of freed blocks are reused, so number of slots is max number of live blocks */
+    uint32_t* const free_slots_p = (uint32_t*)calloc(nr_of_events + 1, sizeof(uint32_t));
+    size_t* const sizes_p = (size_t*)calloc(nr_of_events + 1, sizeof(size_t));
+
+    if (trace_p != NULL)
+    {
+        trace_p->events_p = (Trace_event*)calloc(nr_of_events + 1, sizeof(Trace_event));
+        trace_p->operations_p = (Trace_operation*)calloc(nr_of_events + 1, sizeof(Trace_operation));
+    }
+
+    if (trace_p == NULL || trace_p->events_p == NULL || trace_p->operations_p == NULL || table.ids_p == NULL ||
+        table.slots_p == NULL || free_slots_p == NULL || sizes_p == NULL)
+    {
+        free(table.ids_p);
+        free(table.slots_p);
+        free(free_slots_p);
+        free(sizes_p);
+        trace_destroy(trace_p);
+
+        return NULL;
+    }
+
+    if (nr_of_events > 0)
+    {
+        (void)memcpy(trace_p->events_p, events_p, nr_of_events * sizeof(Trace_event));
+    }
+
+    trace_p->nr_of_events = nr_of_events;
+
+    size_t nr_of_free_slots = 0;
+    size_t requested_bytes = 0;
+
+    for (size_t i = 0; i < nr_of_events; ++i)
+    {
+        const Trace_event* const event_p = &events_p[i];
+        Trace_operation* const operation_p = &trace_p->operations_p[trace_p->nr_of_operations];
+        uint32_t slot = event_p->id == NO_ID ? NO_SLOT : __id_find(&table, event_p->id);
+
+        if (event_p->type == TRACE_ALLOC)
+        {
+            if (event_p->id == NO_ID || slot != NO_SLOT)
+            {
+                continue;
+            }
+
+            slot = nr_of_free_slots > 0 ? free_slots_p[--nr_of_free_slots] : (uint32_t)trace_p->nr_of_slots++;
+            __id_insert(&table, event_p->id, slot);
+
+            sizes_p[slot] = event_p->size;
+            requested_bytes += event_p->size;
+        }
+        else if (event_p->type == TRACE_FREE)
+        {
+            if (slot == NO_SLOT)
+            {
+                continue;
+            }
+
+            __id_remove(&table, event_p->id);
+            free_slots_p[nr_of_free_slots++] = slot;
+
+            requested_bytes -= sizes_p[slot];
+        }
+        else if (event_p->type == TRACE_REALLOC)
+        {
+            if (slot == NO_SLOT || event_p->new_id == NO_ID)
+            {
+                continue;
+            }
+
+            /* resized block keeps its slot */
+            __id_remove(&table, event_p->id);
+            __id_insert(&table, event_p->new_id, slot);
+
+            requested_bytes = requested_bytes - sizes_p[slot] + event_p->size;
+            sizes_p[slot] = event_p->size;
+        }
+        else
+        {
+            continue;
+        }
+
+        operation_p->type = event_p->type;
+        operation_p->size = event_p->size;
+        operation_p->slot = slot;
+
+        if (requested_bytes > trace_p->peak_requested_bytes)
+        {
+            trace_p->peak_requested_bytes = requested_bytes;
+            trace_p->peak_operation = trace_p->nr_of_operations;
+        }
+
+        ++trace_p->nr_of_operations;
+    }
+
+    free(table.ids_p);
+    free(table.slots_p);
+    free(free_slots_p);
+    free(sizes_p);
+
+    return trace_p;
+}
+
+Trace* trace_load(const char* path)
+{
+    if (path == NULL)
+    {
+        return NULL;
+    }
+
+    FILE* const file_p = fopen(path, "rb");
+
+    if (file_p == NULL)
+    {
+        return NULL;
+    }
+
+    Trace_header header;
+
+    if (fread(&header, sizeof(header), 1, file_p) != 1 || header.magic != TRACE_MAGIC ||
+        header.version != TRACE_VERSION || fseek(file_p, 0, SEEK_END) != 0)
+    {
+        (void)fclose(file_p);
+        return NULL;
+    }
+
+    /* file could be cut when program was killed, so only whole events are read */
+    const long size_of_file = ftell(file_p);
+    const size_t nr_of_events =
+        size_of_file < (long)sizeof(header) ? 0 : ((size_t)size_of_file - sizeof(header)) / sizeof(Trace_event);
+
+    Trace_event* const events_p = (Trace_event*)malloc((nr_of_events + 1) * sizeof(Trace_event));
+
+    if (events_p == NULL || fseek(file_p, (long)sizeof(header), SEEK_SET) != 0 ||
+        fread(events_p, sizeof(Trace_event), nr_of_events, file_p) != nr_of_events)
+    {
+        free(events_p);
+        (void)fclose(file_p);
+
+        return NULL;
+    }
+
+    (void)fclose(file_p);
+
+    Trace* const trace_p = trace_create(events_p, nr_of_events);
+    free(events_p);
+
+    return trace_p;
+}
+
+Trace* trace_generate(const size_t nr_of_events, const size_t max_live_blocks, const uint32_t seed)
+{
+    if (max_live_blocks == 0)
+    {
+        return NULL;
+    }
+
+    Trace_event* const events_p = (Trace_event*)calloc(nr_of_events + 1, sizeof(Trace_event));
+    uint64_t* const live_p = (uint64_t*)calloc(max_live_blocks, sizeof(uint64_t));
+
+    if (events_p == NULL || live_p == NULL)
+    {
+        free(events_p);
+        free(live_p);
+
+        return NULL;
+    }
+
+    uint32_t state = seed;
+    uint64_t next_id = 1;
+    size_t nr_of_live = 0;
+
+    for (size_t i = 0; i < nr_of_events; ++i)
+    {
+        state = state * 1103515245u + 12345u;
+
+        const uint32_t kind = (state >> 8) % 100;
+        const size_t victim = nr_of_live == 0 ? 0 : (state >> 12) % nr_of_live;
+
+        /* 80% of blocks up to 256 B, 15% up to 4 kB, 5% up to 256 kB */
+        state = state * 1103515245u + 12345u;
+
+        const uint32_t class = (state >> 8) % 100;
+        const size_t max_size = class < 80 ? 256 : class < 95 ? 4096 : (256 << 10);
+        const size_t size = 1 + (size_t)(state >> 4) % max_size;
+
+        Trace_event* const event_p = &events_p[i];
+        event_p->timestamp = (uint64_t)i * 100;
+
+        if (nr_of_live == 0 || (kind < 50 && nr_of_live < max_live_blocks))
+        {
+            event_p->type = TRACE_ALLOC;
+            event_p->id = next_id++;
+            event_p->size = (uint64_t)size & SIZE_MASK;
+
+            live_p[nr_of_live++] = event_p->id;
+        }
+        else if (kind < 60)
+        {
+            event_p->type = TRACE_REALLOC;
+            event_p->id = live_p[victim];
+            event_p->new_id = next_id++;
+            event_p->size = (uint64_t)size & SIZE_MASK;
+
+            live_p[victim] = event_p->new_id;
+        }
+        else
+        {
+            event_p->type = TRACE_FREE;
+            event_p->id = live_p[victim];
+
+            live_p[victim] = live_p[--nr_of_live];
+        }
+    }
+
+    Trace* const trace_p = trace_create(events_p, nr_of_events);
+
+    free(events_p);
+    free(live_p);
+
+    return trace_p;
+}
+
+bool trace_save(const Trace* trace_p, const char* path)
+{
+    if (trace_p == NULL || path == NULL)
+    {
+        return false;
+    }
+
+    FILE* const file_p = fopen(path, "wb");
+
+    if (file_p == NULL)
+    {
+        return false;
+    }
+
+    const Trace_header header = {.magic = TRACE_MAGIC, .version = TRACE_VERSION};
+
+    const bool is_written = fwrite(&header, sizeof(header), 1, file_p) == 1 &&
+        fwrite(trace_p->events_p, sizeof(Trace_event), trace_p->nr_of_events, file_p) == trace_p->nr_of_events;
+
+    return fclose(file_p) == 0 && is_written;
+}
+
+void trace_destroy(Trace* trace_p)
+{
+    if (trace_p == NULL)
+    {
+        return;
+    }
+
+    free(trace_p->events_p);
+    free(trace_p->operations_p);
+    free(trace_p);
+}
+
+size_t trace_get_nr_of_operations(const Trace* trace_p)
+{
+    return trace_p == NULL ? 0 : trace_p->nr_of_operations;
+}
+
+size_t trace_get_nr_of_slots(const Trace* trace_p)
+{
+    return trace_p == NULL ? 0 : trace_p->nr_of_slots;
+}
+
+void trace_replay(const Trace* trace_p, const Trace_allocator* allocator_p, Trace_replay_result* result_p)
+{
+    if (trace_p == NULL || allocator_p == NULL || result_p == NULL)
+    {
+        return;
+    }
+
+    (void)memset(result_p, 0, sizeof(*result_p));
+
+    void** const slots_p = (void**)calloc(trace_p->nr_of_slots + 1, sizeof(void*));
+
+    if (slots_p == NULL)
+    {
+        return;
+    }
+
+    allocator_p->init();
+
+    struct timespec start;
+    struct timespec end;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (size_t i = 0; i < trace_p->nr_of_operations; ++i)
+    {
+        const Trace_operation* const operation_p = &trace_p->operations_p[i];
+        void** const block_pp = &slots_p[operation_p->slot];
+
+        if (operation_p->type == TRACE_FREE)
+        {
+            allocator_p->dealloc(*block_pp);
+            *block_pp = NULL;
+        }
+        else
+        {
+            const size_t size = operation_p->size == 0 ? 1 : (size_t)operation_p->size;
+
+            /* failed realloc keeps block, failed alloc leaves empty slot, frees of it are no-op */
+            void* const addr_p = operation_p->type == TRACE_ALLOC || *block_pp == NULL ?
+                allocator_p->alloc(size) : allocator_p->realloc(*block_pp, size);
+
+            if (addr_p == NULL)
+            {
+                ++result_p->nr_of_failures;
+            }
+            else
+            {
+                *(volatile uint8_t*)addr_p = (uint8_t)i;
+                *block_pp = addr_p;
+            }
+        }
+
+        if (i == trace_p->peak_operation)
+        {
+            result_p->peak_footprint = allocator_p->get_footprint();
+        }
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    for (size_t i = 0; i < trace_p->nr_of_slots; ++i)
+    {
+        allocator_p->dealloc(slots_p[i]);
+    }
+
+    free(slots_p);
+
+    result_p->nr_of_operations = trace_p->nr_of_operations;
+    result_p->ns_per_operation =
+        trace_p->nr_of_operations == 0 ? 0.0 : __elapsed_ns(&start, &end) / (double)trace_p->nr_of_operations;
+    result_p->peak_requested_bytes = trace_p->peak_requested_bytes;
+    result_p->fragmentation = result_p->peak_footprint == 0 ?
+        0.0 : 1.0 - (double)trace_p->peak_requested_bytes / (double)result_p->peak_footprint;
+}
@@ -0,0 +1,325 @@
+#include <trace_replay.h>
+#include <fixed_size_allocator.h>
+#include <split_size_allocator.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <malloc.h>
+#include <unistd.h>
+
+/* -------------------------------------------- FUNCTIONLIKE MACRO ------------------------------------------------- */
+
+/* macro for calculating size of arrays allocated on stack */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* ------------------------------------------------- DEFINES ------------------------------------------------------- */
+
+/* synthetic trace replayed when no trace file is given */
+#define NR_OF_EVENTS 200000
+#define MAX_LIVE_BLOCKS 4096
+#define SEED 1
+
+/* ------------------------------------------- ALLOCATOR DECLARATION ----------------------------------------------- */
+
+/*
+    Adapters of allocators for replay, see Trace_allocator. fsa has not got realloc, so it is alloc, copy and free.
+
+    PARAMS:
+    See Trace_allocator.
+
+    RETURN:
+    See Trace_allocator.
+*/
+static void* __fsa_realloc(void* addr_p, size_t bytes);
+static size_t __fsa_get_footprint(void);
+static size_t __ssa_get_footprint(void);
+static void __libc_init(void);
+static size_t __libc_get_footprint(void);
+
+/* ---------------------------------------------- TEST DECLARATION ------------------------------------------------- */
+
+/*
+    In this test case we want to make sure that addresses are mapped to dense slots, resized block keeps its slot and
+    events of blocks allocated before recording are skipped.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_trace_create(void);
+
+/*
+    In this test case we want to make sure that saved trace is loaded back, file cut in the middle of event is loaded
+    without it and file which is not trace is rejected.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_trace_save_load(void);
+
+/*
+    In this test case we want to make sure that replay gives back all blocks and result is filled.
+
+    PARAMS:
+    @IN - void
+
+    RETURN:
+    This is void function.
+*/
+static void test_replay(void);
+
+/*
+    Replay trace on fsa, ssa and libc malloc and print results.
+
+    PARAMS:
+    @IN trace_p - pointer to trace.
+    @IN name - name of trace.
+
+    RETURN:
+    This is void function.
+*/
+static void benchmark_replay(const Trace* trace_p, const char* name);
+
+/* -------------------------------------------- ALLOCATOR DEFINITION ----------------------------------------------- */
+
+static void* __fsa_realloc(void* addr_p, size_t bytes)
+{
+    const size_t usable = fsa_get_usable_size(addr_p);
+
+    if (bytes <= usable)
+    {
+        return addr_p;
+    }
+
+    void* const new_addr_p = fsa_slab_alloc(bytes);
+
+    if (new_addr_p == NULL)
+    {
+        return NULL;
+    }
+
+    (void)memcpy(new_addr_p, addr_p, usable);
+    fsa_dealloc(addr_p);
+
+    return new_addr_p;
+}
+
+static size_t __fsa_get_footprint(void)
+{
+    Fsa_statistics stats;
+    fsa_read_statistics(&stats);
+
+    return stats.bytes_in_use;
+}
+
+static size_t __ssa_get_footprint(void)
+{
+    Ssa_statistics stats;
+    ssa_read_statistics(&stats);
+
+    return stats.bytes_in_use;
+}
+
+static void __libc_init(void)
+{
+    (void)malloc_trim(0);
+}
+
+static size_t __libc_get_footprint(void)
+{
+    const struct mallinfo2 info = mallinfo2();
+
+    return info.uordblks + info.hblkhd;
+}
+
+static const Trace_allocator allocators[] =
+{
+    {
+        .name = "fsa",
+        .init = fsa_init,
+        .alloc = fsa_slab_alloc,
+        .dealloc = fsa_dealloc,
+        .realloc = __fsa_realloc,
+        .get_footprint = __fsa_get_footprint,
+    },
+    {
+        .name = "ssa",
+        .init = ssa_init,
+        .alloc = ssa_alloc,
+        .dealloc = ssa_dealloc,
+        .realloc = ssa_realloc,
+        .get_footprint = __ssa_get_footprint,
+    },
+    {
+        .name = "libc",
+        .init = __libc_init,
+        .alloc = malloc,
+        .dealloc = free,
+        .realloc = realloc,
+        .get_footprint = __libc_get_footprint,
+    },
+};
+
+/* ---------------------------------------------- TEST DEFINITION -------------------------------------------------- */
+
+static void test_trace_create(void)
+{
+    assert(sizeof(Trace_header) == 8 && sizeof(Trace_event) == 32);
+
+    const Trace_event events[] =
+    {
+        {.type = TRACE_ALLOC, .id = 0x1000, .size = 100},
+        {.type = TRACE_ALLOC, .id = 0x2000, .size = 200},
+        {.type = TRACE_REALLOC, .id = 0x1000, .new_id = 0x3000, .size = 300},
+        {.type = TRACE_FREE, .id = 0x2000},
+        {.type = TRACE_FREE, .id = 0x9000}, /* allocated before recording */
+        {.type = TRACE_REALLOC, .id = 0x9000, .new_id = 0xa000, .size = 10},
+        {.type = TRACE_ALLOC, .id = 0x1000, .size = 50}, /* address is reused */
+        {.type = TRACE_FREE, .id = 0x3000},
+        {.type = TRACE_FREE, .id = 0x1000},
+    };
+
+    Trace* const trace_p = trace_create(&events[0], ARRAY_SIZE(events));
+    assert(trace_p != NULL);
+
+    assert(trace_get_nr_of_operations(trace_p) == ARRAY_SIZE(events) - 2);
+    assert(trace_get_nr_of_slots(trace_p) == 2);
+
+    trace_destroy(trace_p);
+
+    /* empty trace is valid */
+    Trace* const empty_p = trace_create(NULL, 0);
+    assert(empty_p != NULL && trace_get_nr_of_operations(empty_p) == 0);
+
+    trace_destroy(empty_p);
+}
+
+static void test_trace_save_load(void)
+{
+    char path[] = "/tmp/trace_replay_XXXXXX";
+    const int fd = mkstemp(path);
+    assert(fd >= 0);
+
+    (void)close(fd);
+
+    Trace* const trace_p = trace_generate(10000, 256, SEED);
+    assert(trace_p != NULL && trace_get_nr_of_slots(trace_p) <= 256);
+    assert(trace_save(trace_p, path));
+
+    Trace* const loaded_p = trace_load(path);
+    assert(loaded_p != NULL);
+    assert(trace_get_nr_of_operations(loaded_p) == trace_get_nr_of_operations(trace_p));
+    assert(trace_get_nr_of_slots(loaded_p) == trace_get_nr_of_slots(trace_p));
+
+    trace_destroy(loaded_p);
+
+    /* recording was stopped in the middle of event */
+    assert(truncate(path, (off_t)(sizeof(Trace_header) + 3 * sizeof(Trace_event) + 5)) == 0);
+
+    Trace* const cut_p = trace_load(path);
+    assert(cut_p != NULL && trace_get_nr_of_operations(cut_p) == 3);
+
+    trace_destroy(cut_p);
+
+    /* file without header is not trace */
+    assert(truncate(path, 0) == 0);
+    assert(trace_load(path) == NULL);
+
+    (void)unlink(path);
+
+    assert(trace_load(path) == NULL);
+
+    trace_destroy(trace_p);
+}
+
+static void test_replay(void)
+{
+    Trace* const trace_p = trace_generate(20000, 512, SEED);
+    assert(trace_p != NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(allocators); ++i)
+    {
+        Trace_replay_result result;
+        trace_replay(trace_p, &allocators[i], &result);
+
+        assert(result.nr_of_operations == trace_get_nr_of_operations(trace_p));
+        assert(result.nr_of_failures == 0);
+        assert(result.peak_requested_bytes > 0 && result.fragmentation < 1.0);
+
+        /* mallinfo2 gives nothing if malloc is replaced (sanitizers, LD_PRELOAD) */
+        if (allocators[i].get_footprint != __libc_get_footprint)
+        {
+            assert(result.peak_footprint >= result.peak_requested_bytes && result.fragmentation >= 0.0);
+        }
+    }
+
+    /* all blocks live at the end of trace were given back */
+    Ssa_statistics ssa_stats;
+    ssa_read_statistics(&ssa_stats);
+    assert(ssa_stats.nr_of_chunks_in_use == 0 && ssa_stats.bytes_in_use == 0);
+
+    /* slab layer keeps one empty chunk for each size class */
+    Fsa_statistics fsa_stats;
+    fsa_read_statistics(&fsa_stats);
+    assert(fsa_stats.bytes_in_use <= FSA_SLAB_NR_OF_CLASSES * SIZE_OF_CHUNK);
+
+    trace_destroy(trace_p);
+}
+
+static void benchmark_replay(const Trace* trace_p, const char* name)
+{
+    printf("TRACE REPLAY %s, %zu operations, %zu blocks live at most\n",
+           name, trace_get_nr_of_operations(trace_p), trace_get_nr_of_slots(trace_p));
+
+    for (size_t i = 0; i < ARRAY_SIZE(allocators); ++i)
+    {
+        Trace_replay_result result;
+        trace_replay(trace_p, &allocators[i], &result);
+
+        printf("%-5s %.1f ns/op, peak footprint = %zu (requested = %zu), fragmentation = %.3f, failures = %zu\n",
+               allocators[i].name, result.ns_per_operation, result.peak_footprint, result.peak_requested_bytes,
+               result.fragmentation, result.nr_of_failures);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    test_trace_create();
+    test_trace_save_load();
+    test_replay();
+
+    if (argc < 2)
+    {
+        Trace* const trace_p = trace_generate(NR_OF_EVENTS, MAX_LIVE_BLOCKS, SEED);
+        assert(trace_p != NULL);
+
+        benchmark_replay(trace_p, "synthetic");
+        trace_destroy(trace_p);
+
+        return 0;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        Trace* const trace_p = trace_load(argv[i]);
+
+        if (trace_p == NULL)
+        {
+            fprintf(stderr, "%s is not trace file\n", argv[i]);
+            return 1;
+        }
+
+        benchmark_replay(trace_p, argv[i]);
+        trace_destroy(trace_p);
+    }
+
+    return 0;
+}